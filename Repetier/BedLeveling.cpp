@@ -87,6 +87,19 @@ bending to both sides of the axis. So probe points 2 and 3 build the symmetric a
 point 1 is mirrored to 1m across the axis. Using the symmetry we then remove the bending
 from 1 and use that as plane.
 
+BED_LEVELING_METHOD 3
+Adaptive grid. Uses the same grid as method 1, but starts with the 4 corners and the center
+and computes a regression plane. Only cells with a corner deviating more than
+BED_LEVELING_ADAPTIVE_THRESHOLD from the plane get refined with the next finer grid level.
+With an even grid size the center is no grid point. It is probed anyway and if it deviates,
+the cells containing it get refined.
+Probing stops as soon as all points fit the plane, so a flat bed needs only 5 probes.
+
+Repeated measurements of one point are averaged or reduced to the median depending on
+Z_PROBE_USE_MEDIAN. With Z_PROBE_USE_MEDIAN 2 values deviating more than
+Z_PROBE_MAD_FACTOR times the median absolute deviation (at least one step) from the median
+are dropped and the rest is averaged.
+
 By now the leveling process is finished. All errors that remain are measuring errors and bumps on
 the bed it self. For deltas you can enable distortion correction to follow the bumps.
 
@@ -122,6 +135,30 @@ requires the extruder to bend the coating thickness without harm!
 #define BED_LEVELING_REPETITIONS 1
 #endif
 
+#ifndef BED_LEVELING_ADAPTIVE_THRESHOLD
+#define BED_LEVELING_ADAPTIVE_THRESHOLD 0.05
+#endif
+
+#ifndef Z_PROBE_MAD_FACTOR
+#define Z_PROBE_MAD_FACTOR 3
+#endif
+
+#ifndef Z_PROBE_FAST_APPROACH
+#define Z_PROBE_FAST_APPROACH 0
+#endif
+
+#ifndef Z_PROBE_FAST_SPEED
+#define Z_PROBE_FAST_SPEED (4 * Z_PROBE_SPEED)
+#endif
+
+#ifndef Z_PROBE_LEARN_MARGIN
+#define Z_PROBE_LEARN_MARGIN 1.0
+#endif
+
+#ifndef Z_PROBE_REPEATABILITY
+#define Z_PROBE_REPEATABILITY 0.01
+#endif
+
 #if FEATURE_Z_PROBE
 void Printer::prepareForProbing() {
 #ifndef SKIP_PROBE_PREPARE
@@ -162,6 +199,35 @@ void Printer::prepareForProbing() {
 
 #if FEATURE_AUTOLEVEL && FEATURE_Z_PROBE
 
+#if BED_LEVELING_METHOD == 3
+/** Position of grid coordinate fx,fy of the grid spanned by probe points 1-3. */
+static void adaptiveGridPosition(float fx, float fy, float &px, float &py) {
+    float delta = 1.0 / (BED_LEVELING_GRID_SIZE - 1);
+    px = EEPROM::zProbeX1() + delta * (fx * (EEPROM::zProbeX2() - EEPROM::zProbeX1()) + fy * (EEPROM::zProbeX3() - EEPROM::zProbeX1()));
+    py = EEPROM::zProbeY1() + delta * (fx * (EEPROM::zProbeY2() - EEPROM::zProbeY1()) + fy * (EEPROM::zProbeY3() - EEPROM::zProbeY1()));
+}
+
+/** Probes grid coordinate fx,fy and adds it to builder. */
+static bool probeAdaptivePoint(PlaneBuilder &builder, float fx, float fy, float &h) {
+    float px, py;
+    adaptiveGridPosition(fx, fy, px, py);
+    Printer::moveTo(px, py, IGNORE_COORDINATE, IGNORE_COORDINATE, EEPROM::zProbeXYSpeed());
+    h = Printer::runZProbe(false, false);
+    if(h == ILLEGAL_Z_PROBE)
+        return false;
+    builder.addPoint(px, py, h);
+    return true;
+}
+
+/** Probes grid point ix,iy and stores the result in heights/state. */
+static bool probeAdaptiveGridPoint(PlaneBuilder &builder, float heights[BED_LEVELING_GRID_SIZE][BED_LEVELING_GRID_SIZE], uint8_t state[BED_LEVELING_GRID_SIZE][BED_LEVELING_GRID_SIZE], fast8_t ix, fast8_t iy) {
+    if(!probeAdaptivePoint(builder, static_cast<float>(ix), static_cast<float>(iy), heights[ix][iy]))
+        return false;
+    state[ix][iy] = 1;
+    return true;
+}
+#endif
+
 bool measureAutolevelPlane(Plane &plane) {
     PlaneBuilder builder;
     builder.reset();
@@ -236,6 +302,78 @@ bool measureAutolevelPlane(Plane &plane) {
     builder.addPoint(EEPROM::zProbeX1(), EEPROM::zProbeY1(), h1);
     builder.addPoint(EEPROM::zProbeX2(), EEPROM::zProbeY2(), h2);
     builder.addPoint(EEPROM::zProbeX3(), EEPROM::zProbeY3(), h3);
+#elif BED_LEVELING_METHOD == 3 // adaptive grid
+    float heights[BED_LEVELING_GRID_SIZE][BED_LEVELING_GRID_SIZE];
+    uint8_t state[BED_LEVELING_GRID_SIZE][BED_LEVELING_GRID_SIZE]; // 0 = not probed, 1 = probed, 2 = above threshold
+    memset(state, 0, sizeof(state));
+    fast8_t step = BED_LEVELING_GRID_SIZE - 1;
+    uint8_t probes = 5;
+    if(!probeAdaptiveGridPoint(builder, heights, state, 0, 0) ||
+            !probeAdaptiveGridPoint(builder, heights, state, step, 0) ||
+            !probeAdaptiveGridPoint(builder, heights, state, step, step) ||
+            !probeAdaptiveGridPoint(builder, heights, state, 0, step))
+        return false;
+#if BED_LEVELING_GRID_SIZE & 1
+    if(!probeAdaptiveGridPoint(builder, heights, state, step >> 1, step >> 1))
+        return false;
+#else
+    // Bed center is no grid point, probe it anyway and refine the cells around it if it is off
+    float centerHeight;
+    bool centerRough = false;
+    if(!probeAdaptivePoint(builder, 0.5 * step, 0.5 * step, centerHeight))
+        return false;
+#endif
+    while(true) {
+        builder.createPlane(plane, true);
+        bool rough = false;
+        for(fast8_t ix = 0; ix < BED_LEVELING_GRID_SIZE; ix++) {
+            for(fast8_t iy = 0; iy < BED_LEVELING_GRID_SIZE; iy++) {
+                if(state[ix][iy] == 0)
+                    continue;
+                float px, py;
+                adaptiveGridPosition(ix, iy, px, py);
+                if(fabs(heights[ix][iy] - plane.z(px, py)) > BED_LEVELING_ADAPTIVE_THRESHOLD) {
+                    state[ix][iy] = 2;
+                    rough = true;
+                } else
+                    state[ix][iy] = 1;
+            }
+        }
+#if !(BED_LEVELING_GRID_SIZE & 1)
+        {
+            float px, py;
+            adaptiveGridPosition(0.5 * (BED_LEVELING_GRID_SIZE - 1), 0.5 * (BED_LEVELING_GRID_SIZE - 1), px, py);
+            centerRough = fabs(centerHeight - plane.z(px, py)) > BED_LEVELING_ADAPTIVE_THRESHOLD;
+            rough |= centerRough;
+        }
+#endif
+        if(!rough || step <= 1)
+            break;
+        // Refine only cells with a corner above threshold
+        fast8_t next = step >> 1;
+        for(fast8_t ix = 0; ix < BED_LEVELING_GRID_SIZE; ix += next) {
+            for(fast8_t iy = 0; iy < BED_LEVELING_GRID_SIZE; iy += next) {
+                if(state[ix][iy] != 0)
+                    continue;
+                fast8_t x0 = (ix / step) * step, y0 = (iy / step) * step;
+                fast8_t x1 = RMath::min(x0 + step, BED_LEVELING_GRID_SIZE - 1), y1 = RMath::min(y0 + step, BED_LEVELING_GRID_SIZE - 1);
+                bool refine = state[x0][y0] == 2 || state[x1][y0] == 2 || state[x0][y1] == 2 || state[x1][y1] == 2;
+#if !(BED_LEVELING_GRID_SIZE & 1)
+                // with an even grid size the center lies strictly inside one cell per level
+                if(centerRough && 2 * x0 < BED_LEVELING_GRID_SIZE - 1 && 2 * x1 > BED_LEVELING_GRID_SIZE - 1 &&
+                        2 * y0 < BED_LEVELING_GRID_SIZE - 1 && 2 * y1 > BED_LEVELING_GRID_SIZE - 1)
+                    refine = true;
+#endif
+                if(refine) {
+                    if(!probeAdaptiveGridPoint(builder, heights, state, ix, iy))
+                        return false;
+                    probes++;
+                }
+            }
+        }
+        step = next;
+    }
+    Com::printFLN(PSTR("Adaptive leveling probes:"), (int)probes);
 #else
 #error Unknown bed leveling method
 #endif
@@ -492,6 +630,37 @@ float Printer::runZMaxProbe() {
 #endif
 
 #if FEATURE_Z_PROBE
+#if Z_PROBE_FAST_APPROACH
+static int32_t zProbeLearnedSteps; ///< z position in steps where the probe triggered last time
+static bool zProbeLearned = false; ///< True if zProbeLearnedSteps is from this probing session
+#endif
+
+/** Moves z by steps with z probe active. Returns true if the probe triggered and
+corrects the position to the trigger point. */
+static bool zProbeMove(int32_t steps, float speed) {
+    Printer::stepsRemainingAtZHit = -1; // Marker that we did not hit z probe
+    Printer::setZProbingActive(true);
+#if defined(Z_PROBE_DELAY) && Z_PROBE_DELAY > 0
+    HAL::delayMilliseconds(Z_PROBE_DELAY);
+#endif
+    PrintLine::moveRelativeDistanceInSteps(0, 0, steps, 0, speed, true, true);
+    Printer::setZProbingActive(false);
+    if(Printer::stepsRemainingAtZHit < 0)
+        return false;
+#if NONLINEAR_SYSTEM
+    Printer::stepsRemainingAtZHit = Printer::realDeltaPositionSteps[C_TOWER] - Printer::currentNonlinearPositionSteps[C_TOWER]; // nonlinear moves may split z so stepsRemainingAtZHit is only what is left from last segment not total move. This corrects the problem.
+#endif
+#if DRIVE_SYSTEM == DELTA
+    Printer::currentNonlinearPositionSteps[A_TOWER] += Printer::stepsRemainingAtZHit; // Update difference
+    Printer::currentNonlinearPositionSteps[B_TOWER] += Printer::stepsRemainingAtZHit;
+    Printer::currentNonlinearPositionSteps[C_TOWER] += Printer::stepsRemainingAtZHit;
+#elif NONLINEAR_SYSTEM
+    Printer::currentNonlinearPositionSteps[Z_AXIS] += Printer::stepsRemainingAtZHit;
+#endif
+    Printer::currentPositionSteps[Z_AXIS] += Printer::stepsRemainingAtZHit; // now current position is correct
+    return true;
+}
+
 /** \brief Activate z-probe
 
 Tests if switching from active tool to z-probe is possible at current position. If not the operation is aborted.
@@ -503,6 +672,9 @@ If ok, it runs start script, checks z position and applies the z-probe offset.
 bool Printer::startProbing(bool runScript, bool enforceStartHeight) {
     float cx, cy, cz;
     realPosition(cx, cy, cz);
+#if Z_PROBE_FAST_APPROACH
+    zProbeLearned = false;
+#endif
     // Fix position to be inside print area when probe is enabled
 #if EXTRUDER_IS_Z_PROBE == 0
     float ZPOffsetX = EEPROM::zProbeXOffset();
@@ -634,35 +806,54 @@ float Printer::runZProbe(bool first, bool last, uint8_t repeat, bool runStartScr
 #if Z_PROBE_DISABLE_HEATERS
 	Extruder::pauseExtruders(true);
 	HAL::delayMilliseconds(70);
+#endif
+#if Z_PROBE_FAST_APPROACH
+    int32_t lastMeasurement = 0;
+    int32_t repeatabilitySteps = static_cast<int32_t>(static_cast<float>(Z_PROBE_REPEATABILITY) * axisStepsPerMM[Z_AXIS]);
 #endif
     for(int8_t r = 0; r < repeat; r++) {
         probeDepth = 2 * (Printer::zMaxSteps - Printer::zMinSteps); // probe should always hit within this distance
-        stepsRemainingAtZHit = -1; // Marker that we did not hit z probe
-        setZProbingActive(true);
-#if defined(Z_PROBE_DELAY) && Z_PROBE_DELAY > 0
-        HAL::delayMilliseconds(Z_PROBE_DELAY);
+#if Z_PROBE_FAST_APPROACH
+        if(r == 0) {
+            // Approach fast, down to just above the last trigger height if known, so
+            // the slow touch only needs to travel the switching distance.
+            bool hit;
+            if(zProbeLearned) {
+                int32_t approach = currentPositionSteps[Z_AXIS] - zProbeLearnedSteps - static_cast<int32_t>(static_cast<float>(Z_PROBE_LEARN_MARGIN) * axisStepsPerMM[Z_AXIS]);
+                hit = approach > 0 && zProbeMove(-approach, Z_PROBE_FAST_SPEED);
+            } else {
+                hit = zProbeMove(-probeDepth, Z_PROBE_FAST_SPEED);
+                if(!hit) {
+                    Com::printErrorFLN(Com::tZProbeFailed);
+                    return ILLEGAL_Z_PROBE;
+                }
+            }
+            if(hit) {
+                PrintLine::moveRelativeDistanceInSteps(0, 0, shortMove, 0, HOMING_FEEDRATE_Z, true, true);
+                if(Endstops::zProbe()) {
+                    Com::printErrorFLN(PSTR("z-probe did not untrigger on repetitive measurement - maybe you need to increase distance!"));
+                    UI_MESSAGE(1);
+                    return ILLEGAL_Z_PROBE;
+                }
+            }
+        }
 #endif
-        PrintLine::moveRelativeDistanceInSteps(0, 0, -probeDepth, 0, EEPROM::zProbeSpeed(), true, true);
-        setZProbingActive(false);
-        if(stepsRemainingAtZHit < 0) {
+        if(!zProbeMove(-probeDepth, EEPROM::zProbeSpeed())) {
             Com::printErrorFLN(Com::tZProbeFailed);
             return ILLEGAL_Z_PROBE;
         }
-#if NONLINEAR_SYSTEM
-        stepsRemainingAtZHit = realDeltaPositionSteps[C_TOWER] - currentNonlinearPositionSteps[C_TOWER]; // nonlinear moves may split z so stepsRemainingAtZHit is only what is left from last segment not total move. This corrects the problem.
-#endif
-#if DRIVE_SYSTEM == DELTA
-        currentNonlinearPositionSteps[A_TOWER] += stepsRemainingAtZHit; // Update difference
-        currentNonlinearPositionSteps[B_TOWER] += stepsRemainingAtZHit;
-        currentNonlinearPositionSteps[C_TOWER] += stepsRemainingAtZHit;
-#elif NONLINEAR_SYSTEM
-        currentNonlinearPositionSteps[Z_AXIS] += stepsRemainingAtZHit;
-#endif
-        currentPositionSteps[Z_AXIS] += stepsRemainingAtZHit; // now current position is correct
 #if defined(Z_PROBE_USE_MEDIAN) && Z_PROBE_USE_MEDIAN
         measurements[r] = lastCorrection - currentPositionSteps[Z_AXIS];
 #else
         sum += lastCorrection - currentPositionSteps[Z_AXIS];
+#endif
+#if Z_PROBE_FAST_APPROACH
+        zProbeLearnedSteps = currentPositionSteps[Z_AXIS];
+        zProbeLearned = true;
+        // Stop repeating as soon as two touches agree
+        if(r > 0 && labs(lastCorrection - currentPositionSteps[Z_AXIS] - lastMeasurement) <= repeatabilitySteps)
+            repeat = r + 1;
+        lastMeasurement = lastCorrection - currentPositionSteps[Z_AXIS];
 #endif
         //Com::printFLN(PSTR("ZHSteps:"),lastCorrection - currentPositionSteps[Z_AXIS]);
         if(r + 1 < repeat) {
@@ -705,7 +896,39 @@ float Printer::runZProbe(bool first, bool last, uint8_t repeat, bool runStartScr
 		}
 	}
 // process result
+#if Z_PROBE_USE_MEDIAN == 2
+	// drop outliers using the median absolute deviation and average the rest
+	int32_t median = measurements[repeat >> 1];
+	int32_t deviations[Z_PROBE_REPETITIONS];
+	for(fast8_t i = 0; i < repeat; i++) {
+		deviations[i] = labs(measurements[i] - median);
+	}
+	for(fast8_t i = 0 ; i < repeat - 1; i++) {
+		for(fast8_t j = 0; j < repeat - i - 1; j++)  {
+			if( deviations[j] > deviations[j + 1] ) {
+				tmp = deviations[j];
+				deviations[j] = deviations[j + 1];
+				deviations[j + 1] = tmp;
+			}
+		}
+	}
+	// Quantized to steps the median deviation is often 0, one step is the resolution limit
+	int32_t maxDeviation = Z_PROBE_MAD_FACTOR * RMath::max(deviations[repeat >> 1], static_cast<int32_t>(1));
+	int32_t sum = 0;
+	fast8_t used = 0;
+	for(fast8_t i = 0; i < repeat; i++) {
+		if(labs(measurements[i] - median) <= maxDeviation) {
+			sum += measurements[i];
+			used++;
+		}
+	}
+	if(used < repeat) {
+		Com::printFLN(PSTR("Z-probe outliers removed:"), (int)(repeat - used));
+	}
+	float distance = static_cast<float>(sum) * invAxisStepsPerMM[Z_AXIS] / static_cast<float>(used) + EEPROM::zProbeHeight();
+#else
 	float distance = static_cast<float>(measurements[repeat >> 1]) * invAxisStepsPerMM[Z_AXIS] + EEPROM::zProbeHeight();
+#endif
 #else
 	float distance = static_cast<float>(sum) * invAxisStepsPerMM[Z_AXIS] / static_cast<float>(repeat) + EEPROM::zProbeHeight();
 #endif
@@ -0,0 +1,112 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _BEZIER_H
+#define _BEZIER_H
+
+#include <math.h>
+
+/** \brief Geometry of a cubic xy Bezier curve for G5.
+
+Only needs math.h, so tools/bezier_test can check the flattening on the host.
+*/
+class BezierCurve {
+public:
+    float p[4][2];  ///< Start, control points and end
+    float d[3][2];  ///< 3 * (p[i+1] - p[i]), B'(t) is the quadratic Bezier over d
+    float a0[2];    ///< B''(0)
+    float a1[2];    ///< B''(1), B'' changes linear between both
+
+    void init(const float *p0, const float *p1, const float *p2, const float *p3) {
+        for(int i = 0; i < 2; i++) {
+            p[0][i] = p0[i];
+            p[1][i] = p1[i];
+            p[2][i] = p2[i];
+            p[3][i] = p3[i];
+            d[0][i] = 3.0f * (p1[i] - p0[i]);
+            d[1][i] = 3.0f * (p2[i] - p1[i]);
+            d[2][i] = 3.0f * (p3[i] - p2[i]);
+            a0[i] = 2.0f * (d[1][i] - d[0][i]);
+            a1[i] = 2.0f * (d[2][i] - d[1][i]);
+        }
+    }
+    /** |B''(t)| */
+    float secondDerivative(float t) const {
+        float x = a0[0] + (a1[0] - a0[0]) * t;
+        float y = a0[1] + (a1[1] - a0[1]) * t;
+        return sqrt(x * x + y * y);
+    }
+    /** B'(t) */
+    void firstDerivative(float t, float *result) const {
+        float mt = 1.0f - t;
+        float b0 = mt * mt, b1 = 2.0f * mt * t, b2 = t * t;
+        result[0] = b0 * d[0][0] + b1 * d[1][0] + b2 * d[2][0];
+        result[1] = b0 * d[0][1] + b1 * d[1][1] + b2 * d[2][1];
+    }
+    /** |B'(t)|, mm per unit of t */
+    float speed(float t) const {
+        float v[2];
+        firstDerivative(t, v);
+        return sqrt(v[0] * v[0] + v[1] * v[1]);
+    }
+    /** Curvature 1/r at t */
+    float curvature(float t) const {
+        float v[2];
+        firstDerivative(t, v);
+        float ax = a0[0] + (a1[0] - a0[0]) * t;
+        float ay = a0[1] + (a1[1] - a0[1]) * t;
+        float speed2 = v[0] * v[0] + v[1] * v[1];
+        if(speed2 < 1e-8f) return 0; // cusp or degenerated curve, nothing sensible to limit
+        return fabs(v[0] * ay - v[1] * ax) / (speed2 * sqrt(speed2));
+    }
+    void point(float t, float &x, float &y) const {
+        float mt = 1.0f - t;
+        float b0 = mt * mt * mt, b1 = 3.0f * mt * mt * t, b2 = 3.0f * mt * t * t, b3 = t * t * t;
+        x = b0 * p[0][0] + b1 * p[1][0] + b2 * p[2][0] + b3 * p[3][0];
+        y = b0 * p[0][1] + b1 * p[1][1] + b2 * p[2][1] + b3 * p[3][1];
+    }
+    /** Returns t at the end of the next line starting at t. The chord error is at most
+    dt^2/8 * max|B''| and |B''| is maximal at one end of [t, t + dt], so the
+    second check keeps the error below tolerance. Lines are also not longer than
+    maxLength, which only adds lines. The line length uses the largest |B'| of
+    both ends and the middle. */
+    float nextT(float t, float tolerance, float maxLength) const {
+        const float tolerance8 = 8.0f * tolerance;
+        float dt = 1.0f - t;
+        float maxD2 = secondDerivative(t);
+        if(maxD2 * dt * dt > tolerance8)
+            dt = sqrt(tolerance8 / maxD2);
+        float d2 = secondDerivative(t + dt);
+        if(d2 > maxD2) maxD2 = d2;
+        if(maxD2 * dt * dt > tolerance8)
+            dt = sqrt(tolerance8 / maxD2);
+        for(int i = 0; i < 2; i++) { // second pass uses the shorter line
+            float maxSpeed = speed(t);
+            float s = speed(t + 0.5f * dt);
+            if(s > maxSpeed) maxSpeed = s;
+            s = speed(t + dt);
+            if(s > maxSpeed) maxSpeed = s;
+            if(maxSpeed * dt > maxLength)
+                dt = maxLength / maxSpeed;
+        }
+        t += dt;
+        return (t > 0.999999f ? 1.0f : t); // no float dust lines at the end
+    }
+};
+
+#endif
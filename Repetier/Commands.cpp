@@ -50,6 +50,11 @@ void Commands::commandLoop() {
                 Commands::executeGCode(code);
             code->popCurrentCommand();
         }
+#if RETRACT_ON_TRAVEL
+        // Nothing left to merge with once the moves have run out
+        else if((Extruder::travelTailPending || Extruder::retractPendingSteps != 0) && PrintLine::linesCount == 0)
+            Extruder::flushRetractTravel();
+#endif
     } else {
         GCode::keepAlive(Paused);
         UI_MEDIUM;
@@ -69,15 +74,33 @@ void Commands::checkForPeriodicalActions(bool allowNewMoves) {
         }
 #endif
     }
+#endif
+#if SD_READ_BUFFERS
+    sd.prefetch(); // use waiting time to read ahead
+#endif
+#if SD_PARSE_AHEAD
+    GCode::readAheadSD(2); // parse while the move cache is full
 #endif
     if(!executePeriodical) return; // gets true every 100ms
     executePeriodical = 0;
     EVENT_TIMER_100MS;
     Extruder::manageTemperatures();
+#if SD_LAYER_INDEX
+    sd.layerIndexStep();
+#endif
+#if SD_CHECKPOINT
+    sd.checkpointStep();
+#endif
     if(--counter500ms == 0) {
         if(manageMonitor)
             writeMonitor();
         counter500ms = 5;
+#if TOOLCHANGE_PREHEAT
+        Extruder::toolchangeLookahead();
+#endif
+#if SD_INFO_CACHE
+        sd.infoCacheBuild();
+#endif
         EVENT_TIMER_500MS;
     }
     // If called from queueDelta etc. it is an error to start a new move since it
@@ -1003,6 +1026,22 @@ void Commands::processArc(GCode *com) {
 }
 #endif
 
+#if BEZIER_SUPPORT
+/**
+\brief Execute the G5 cubic Bezier command stored in com.
+*/
+void Commands::processBezier(GCode *com) {
+    float position[Z_AXIS_ARRAY];
+    Printer::realPosition(position[X_AXIS], position[Y_AXIS], position[Z_AXIS]);
+    if(!Printer::setDestinationStepsFromGCode(com)) return; // For X Y Z E F
+    float target[E_AXIS_ARRAY] = {Printer::realXPosition(), Printer::realYPosition(), Printer::realZPosition(), Printer::destinationSteps[E_AXIS]*Printer::invAxisStepsPerMM[E_AXIS]};
+    // I/J is relative to start, P/Q relative to end
+    float control1[2] = {position[X_AXIS] + Printer::convertToMM(com->hasI() ? com->I : 0), position[Y_AXIS] + Printer::convertToMM(com->hasJ() ? com->J : 0)};
+    float control2[2] = {target[X_AXIS] + Printer::convertToMM(com->hasP() ? com->PF : 0), target[Y_AXIS] + Printer::convertToMM(com->hasQ() ? com->Q : 0)};
+    PrintLine::bezier(position, target, control1, control2);
+}
+#endif
+
 /**
 \brief Execute the G command stored in com.
 */
@@ -1042,7 +1081,12 @@ void Commands::processGCode(GCode *com) {
                 Com::printWarningFLN(PSTR("executeGCode / queueDeltaMove returns error"));
             }
 #else
-            PrintLine::queueCartesianMove(ALWAYS_CHECK_ENDSTOPS, true);
+#if RETRACT_ON_TRAVEL
+            if(Extruder::current->isRetracted() && Printer::destinationSteps[E_AXIS] == Printer::currentPositionSteps[E_AXIS])
+                Extruder::queueRetractTravel();
+            else
+#endif
+                PrintLine::queueCartesianMove(ALWAYS_CHECK_ENDSTOPS, true);
 #endif
 #if UI_HAS_KEYS
         // ui can only execute motion commands if we are not waiting inside a move for an
@@ -1091,6 +1135,11 @@ void Commands::processGCode(GCode *com) {
     }
 #endif // defined                
     break;
+#endif
+#if BEZIER_SUPPORT
+    case 5: // G5 cubic Bezier
+        processBezier(com);
+        break;
 #endif
     case 4: // G4 dwell
         Commands::waitUntilEndOfAllMoves();
@@ -1693,15 +1742,24 @@ void Commands::processMCode(GCode *com) {
         sd.pausePrint();
         break;
     case 26: //M26 - Set SD index
+#if SD_COMPILED_JOBS
+        if(com->hasS() && com->S != 0 && sd.compiledJob) // only layer starts are keyframes
+            Com::printErrorFLN(PSTR("Compiled jobs can only be positioned at layer starts"));
+        else
+#endif
         if(com->hasS())
             sd.setIndex(com->S);
+#if SD_LAYER_INDEX
+        else if((com->hasL() || com->hasZ()) && !sd.seekLayer(com->hasL() ? static_cast<int32_t>(com->L) : 0, com->hasZ() ? com->Z : 0))
+            Com::printErrorFLN(PSTR("Layer not indexed"));
+#endif
         break;
     case 27: //M27 - Get SD status
         sd.printStatus();
         break;
     case 28: //M28 - Start SD write
         if(com->hasString())
-            sd.startWrite(com->text);
+            sd.startWrite(com->text, com->hasS() ? com->S : 0);
         break;
     case 29: //M29 - Stop SD write
         //processed in write to file routine above
@@ -1720,12 +1778,45 @@ void Commands::processMCode(GCode *com) {
         }
         break;
 #endif
+#if SD_COMPILED_JOBS
+    case 37: // M37 - Job header of compiled sd files
+        if(com->hasP())
+            Printer::maxLayer = com->P;
+        Com::printF(PSTR("JobInfo Layers:"), static_cast<int32_t>(com->getP(0)));
+        Com::printF(PSTR(" Time:"), static_cast<int32_t>(com->getS(0)));
+        if(com->hasZ())
+            Com::printF(PSTR(" Height:"), com->Z, 2);
+        if(com->hasE())
+            Com::printF(PSTR(" Filament:"), com->E, 1);
+        Com::println();
+        break;
+#endif
 #if JSON_OUTPUT && SDSUPPORT
     case 36: // M36 JSON File Info
         if (com->hasString()) {
             sd.JSONFileInfo(com->text);
         }
         break;
+#endif
+#if SD_ESTIMATE
+    case 38: // M38 filename - Estimate print time and filament
+        if(com->hasString()) {
+            sd.fat.chdir();
+            sd.estimateFile(com->text);
+        }
+        break;
+#endif
+#if SD_BLOCK_CACHE
+    case 39: { // M39 [S0] - SD block cache statistics, S0 resets them
+        FatVolume *vol = sd.fat.vol();
+        uint32_t hits = vol->lruHits(), total = hits + vol->lruMisses();
+        Com::printF(PSTR("SD cache hits:"), hits);
+        Com::printF(PSTR(" misses:"), vol->lruMisses());
+        Com::printFLN(PSTR(" rate:"), total ? 100.0f * hits / total : 0.0f, 1);
+        if(com->hasS() && com->S == 0)
+            vol->lruClearStats();
+    }
+    break;
 #endif
     case 42: //M42 -Change pin status via gcode
         if (com->hasP()) {
@@ -1903,8 +1994,14 @@ void Commands::processMCode(GCode *com) {
         Commands::waitUntilEndOfAllMoves();
         Extruder *actExtruder = Extruder::current;
         if(com->hasT() && com->T < NUM_EXTRUDER) actExtruder = &extruder[com->T];
+#if PREDICTIVE_HEATUP
+        if (com->hasS()) Extruder::setTemperatureForExtruder(com->S + (com->hasO() ? com->O : 0), actExtruder->id, com->hasF() && com->F > 0, false);
+        else if(com->hasH())  Extruder::setTemperatureForExtruder(actExtruder->tempControl.preheatTemperature + (com->hasO() ? com->O : 0), actExtruder->id, com->hasF() && com->F > 0, false);
+        Extruder::deferHeatup(actExtruder->id);
+#else
         if (com->hasS()) Extruder::setTemperatureForExtruder(com->S + (com->hasO() ? com->O : 0), actExtruder->id, com->hasF() && com->F > 0, true);
         else if(com->hasH())  Extruder::setTemperatureForExtruder(actExtruder->tempControl.preheatTemperature + (com->hasO() ? com->O : 0), actExtruder->id, com->hasF() && com->F > 0, true);
+#endif
     }
 #endif
     previousMillisCmd = HAL::timeInMilliseconds();
@@ -1919,9 +2016,13 @@ void Commands::processMCode(GCode *com) {
 #if defined(SKIP_M190_IF_WITHIN) && SKIP_M190_IF_WITHIN > 0
         if(abs(heatedBedController.currentTemperatureC - heatedBedController.targetTemperatureC) < SKIP_M190_IF_WITHIN) break;
 #endif
+#if PREDICTIVE_HEATUP
+        Extruder::deferHeatup(HEATED_BED_INDEX);
+#else
         EVENT_WAITING_HEATER(-1);
         tempController[HEATED_BED_INDEX]->waitForTargetTemperature();
         EVENT_HEATING_FINISHED(-1);
+#endif
 #endif
         UI_CLEAR_STATUS;
         previousMillisCmd = HAL::timeInMilliseconds();
@@ -1934,9 +2035,13 @@ void Commands::processMCode(GCode *com) {
 #if NUM_TEMPERATURE_LOOPS > 0
     case 116: // Wait for temperatures to reach target temperature
         for(fast8_t h = 0; h <= HEATED_BED_INDEX; h++) {
+#if PREDICTIVE_HEATUP
+            Extruder::deferHeatup(h);
+#else
             EVENT_WAITING_HEATER(h < NUM_EXTRUDER ? h : -1);
             tempController[h]->waitForTargetTemperature();
             EVENT_HEATING_FINISHED(h < NUM_EXTRUDER ? h : -1);
+#endif
         }
         break;
 #endif
@@ -2396,7 +2501,16 @@ void Commands::processMCode(GCode *com) {
         if(com->hasC()) method = static_cast<int>(com->C);
         if(cont >= HEATED_BED_INDEX) cont = HEATED_BED_INDEX;
         if(cont < 0) cont = 0;
-        tempController[cont]->autotunePID(temp, cont, cycles, com->hasX(), method);
+#if !TEMP_MODEL_CONTROL
+        if(method == 5) {
+            Com::printErrorFLN(PSTR("M303 C5 needs TEMP_MODEL_CONTROL"));
+            break;
+        }
+#endif
+        if(method == 5 || (com->hasF() && com->F != 0))
+            tempController[cont]->autotuneStep(temp, cont, com->hasX(), method);
+        else
+            tempController[cont]->autotunePID(temp, cont, cycles, com->hasX(), method);
 #endif
     }
     break;
@@ -2468,6 +2582,33 @@ void Commands::processMCode(GCode *com) {
         } else
             Printer::reportCaseLightStatus();
         break;
+#if ANALOG_INPUT_FILTER && ANALOG_INPUTS > 0
+    case 356: // M356 - report analog input noise
+        Extruder::reportAnalogNoise();
+        break;
+#endif
+#if HEATER_SCHEDULER
+    case 357: // M357 - report heater current budget utilization
+        Extruder::reportHeaterBudget();
+        break;
+#endif
+#if VOLUMETRIC_FLOW_LIMIT
+    case 358: { // M358 T<extruder> S<mm^3/s> - set max. volumetric flow, no S = report limited moves
+        uint8_t extruderId = Extruder::current->id;
+        if(com->hasT() && com->T < NUM_EXTRUDER)
+            extruderId = com->T;
+        if(com->hasS()) {
+            extruder[extruderId].maxVolumetricFlow = RMath::max(0.0f, static_cast<float>(com->S));
+        } else {
+            Com::printF(PSTR("Volumetric limited moves:"), PrintLine::flowLimitedMoves);
+            Com::printF(PSTR(" of "), PrintLine::extrudingMoves);
+            Com::printFLN(PSTR(" = "), PrintLine::extrudingMoves > 0 ? 100.0f * PrintLine::flowLimitedMoves / PrintLine::extrudingMoves : 0.0f, 1);
+        }
+        Com::printF(PSTR("Max. volumetric flow extruder "), static_cast<int>(extruderId));
+        Com::printFLN(Com::tColon, extruder[extruderId].maxVolumetricFlow, 1);
+    }
+    break;
+#endif
     case 360: // M360 - show configuration
         Com::writeToAll = false;
         Printer::showConfiguration();
@@ -2485,6 +2626,14 @@ void Commands::processMCode(GCode *com) {
     case 408:
         Printer::showJSONStatus(com->hasS() ? static_cast<int>(com->S) : 0);
         break;
+#endif
+#if SD_CHECKPOINT
+    case 413: // M413 S1 - Resume sd job from checkpoint, no S = report checkpoint
+        if(com->hasS() && com->S == 1)
+            sd.resumeCheckpoint();
+        else
+            sd.reportCheckpoint();
+        break;
 #endif
     case 450:
         Printer::reportPrinterMode();
@@ -2922,11 +3071,28 @@ void Commands::executeGCode(GCode *com) {
             }
         }
     }
+#if PREDICTIVE_HEATUP
+    // Deferred heat-up waits end with the first command that extrudes
+    if(Extruder::heatupPending != 0 && (com->hasG() ? ((com->G <= 3 && com->hasE()) || com->G == 10 || com->G == 11) : (!com->hasM() && com->hasT())))
+        Extruder::waitForPendingHeatup();
+#endif
+#if RETRACT_ON_TRAVEL
+    // Held back retraction moves only merge with travel moves and unretracts
+    if((Extruder::travelTailPending || Extruder::retractPendingSteps != 0) &&
+            !(com->hasG() && (com->G == 11 || (com->G <= 1 && (com->hasNoXYZ() ? com->hasE() && Printer::isAutoretract() : !com->hasE() && !Extruder::travelTailPending)))))
+        Extruder::flushRetractTravel();
+#endif
+#if SD_CHECKPOINT
+    if(com->source == &sdSource)
+        sd.checkpointCommand(com);
+#endif
     if(com->hasG()) processGCode(com);
     else if(com->hasM()) processMCode(com);
     else if(com->hasT()) {    // Process T code
         //com->printCommand(); // for testing if this the source of extruder switches
+#if !MIXING_GRADIENT
         Commands::waitUntilEndOfAllMoves();
+#endif
         Extruder::selectExtruderById(com->T);
     } else {
         if(Printer::debugErrors()) {
@@ -30,6 +30,7 @@ public:
     static void commandLoop();
     static void checkForPeriodicalActions(bool allowNewMoves);
     static void processArc(GCode *com);
+    static void processBezier(GCode *com);
     static void processGCode(GCode *com);
     static void processMCode(GCode *com);
     static void executeGCode(GCode *com);
@@ -73,6 +73,7 @@ FSTRINGVALUE(Com::tB, " B")
 FSTRINGVALUE(Com::tK, " K")
 FSTRINGVALUE(Com::tL, " L")
 FSTRINGVALUE(Com::tO, " O")
+FSTRINGVALUE(Com::tQ, " Q")
 FSTRINGVALUE(Com::tSDReadError, "SD read error")
 FSTRINGVALUE(Com::tExpectedLine, "Error:expected line ")
 FSTRINGVALUE(Com::tGot, " got ")
@@ -413,6 +414,15 @@ FSTRINGVALUE(Com::tEPRAdvanceK, "advance K [0=off]")
 FSTRINGVALUE(Com::tEPRAdvanceL, "advance L [0=off]")
 FSTRINGVALUE(Com::tEPRPreheatTemp, "Preheat temp. [°C]")
 FSTRINGVALUE(Com::tEPRPreheatBedTemp, "Bed Preheat temp. [°C]")
+#if TEMP_MODEL_CONTROL
+FSTRINGVALUE(Com::tEPRModelGain, "model gain [°C/pwm]")
+FSTRINGVALUE(Com::tEPRModelTimeConstant, "model time constant [s]")
+FSTRINGVALUE(Com::tEPRModelDeadTime, "model dead time [s]")
+FSTRINGVALUE(Com::tEPRModelFeedForward, "model feed-forward [pwm/(mm/s)]")
+#endif
+#if VOLUMETRIC_FLOW_LIMIT
+FSTRINGVALUE(Com::tEPRMaxVolumetricFlow, "max. volumetric flow [mm^3/s,0=off]")
+#endif
 
 #endif
 #if SDSUPPORT
@@ -104,6 +104,7 @@ FSTRINGVAR(tB)
 FSTRINGVAR(tK)
 FSTRINGVAR(tL)
 FSTRINGVAR(tO)
+FSTRINGVAR(tQ)
 FSTRINGVAR(tSDReadError)
 FSTRINGVAR(tExpectedLine)
 FSTRINGVAR(tGot)
@@ -421,6 +422,15 @@ FSTRINGVAR(tEPRAdvanceK)
 FSTRINGVAR(tEPRAdvanceL)
 FSTRINGVAR(tEPRPreheatTemp)
 FSTRINGVAR(tEPRPreheatBedTemp)
+#if TEMP_MODEL_CONTROL
+FSTRINGVAR(tEPRModelGain)
+FSTRINGVAR(tEPRModelTimeConstant)
+FSTRINGVAR(tEPRModelDeadTime)
+FSTRINGVAR(tEPRModelFeedForward)
+#endif
+#if VOLUMETRIC_FLOW_LIMIT
+FSTRINGVAR(tEPRMaxVolumetricFlow)
+#endif
 #endif
 #if SDSUPPORT
 //FSTRINGVAR(tSDRemoved)
@@ -0,0 +1,318 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _COMPILED_JOB_H
+#define _COMPILED_JOB_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/* Binary command format of files written with M28 and of compiled SD jobs. Needs only
+SD_COMPILED_KEYFRAME and BEZIER_SUPPORT, so tools/gcode_compile writes the same files
+on the host. The commands are GCode or a class with the same members. */
+
+#define SD_JOB_HEADER_SIZE 28 // binary M37 with Z E S P I
+#define SD_JOB_HEADER_PARAMS (128 | 2 | 32 | 64 | 1024 | 2048 | 4096)
+
+/** \brief Packing state and job header values of a compiled job.
+
+X, Y, Z and E are written as 16 bit um deltas to the last value of the same axis, flagged
+by bit 13 of the parameters. Every SD_COMPILED_KEYFRAME commands and on every z change
+all coordinates are written unpacked, so the reader can start at layer starts. The job
+header is a binary M37 with height, filament, time, layers and first layer height.
+*/
+class JobCompiler {
+public:
+    int32_t base[4]; ///< Last written coordinate per axis in um
+    uint8_t valid; ///< Bit per axis with valid base
+    uint8_t count; ///< Commands since last keyframe
+    bool relative, relativeE;
+    float pos[4]; ///< Tracked position for the header values
+    float feedrate;
+    float time, filament, height, layerHeight;
+    int32_t layers;
+
+    void start()
+    {
+        valid = 0;
+        count = 0;
+        relative = relativeE = false;
+        for(uint8_t i = 0; i < 4; i++)
+            pos[i] = 0;
+        feedrate = 50;
+        time = filament = height = layerHeight = 0;
+        layers = 0;
+    }
+    /** Collects the job header values. */
+    template<class C> void metadata(C *code)
+    {
+        if(code->hasM()) {
+            if(code->M == 82 || code->M == 83)
+                relativeE = code->M == 83;
+            return;
+        }
+        if(!code->hasG()) return;
+        if(code->G == 90 || code->G == 91) {
+            relative = relativeE = code->G == 91;
+        } else if(code->G == 92) {
+            if(code->hasX()) pos[0] = code->X;
+            if(code->hasY()) pos[1] = code->Y;
+            if(code->hasZ()) pos[2] = code->Z;
+            if(code->hasE()) pos[3] = code->E;
+        } else if(code->G <= 3) {
+            if(code->hasF() && code->F > 0)
+                feedrate = code->F / 60.0f;
+            float dist = 0;
+            for(uint8_t i = 0; i < 3; i++) {
+                if(!(code->params & (8 << i))) continue;
+                float v = (i == 0 ? code->X : (i == 1 ? code->Y : code->Z));
+                float d = (relative ? v : v - pos[i]);
+                pos[i] += d;
+                dist += d * d;
+            }
+            time += sqrt(dist) / feedrate;
+            if(code->hasE()) {
+                float d = (relativeE ? code->E : code->E - pos[3]);
+                pos[3] += d;
+                if(d > 0) {
+                    filament += d;
+                    if(pos[2] > height + 0.001f) { // first extrusion of a new layer, ignores z hops
+                        if(layers == 1)
+                            layerHeight = pos[2] - height;
+                        height = pos[2];
+                        layers++;
+                    }
+                }
+            }
+        }
+    }
+    /** Sets code to the M37 job header with the values collected so far. */
+    template<class C> void header(C &code)
+    {
+        code.params = 2 | 32 | 64 | 1024 | 2048 | 4096; // M Z E S P V2
+        code.params2 = 1; // I
+        code.M = 37;
+        code.Z = height;
+        code.E = filament;
+        code.S = static_cast<int32_t>(time);
+        code.P = layers;
+        code.I = layerHeight;
+    }
+    /** Returns true if header is the job header of a compiled job. */
+    static bool isHeader(const uint8_t *header)
+    {
+        uint16_t params, params2, m;
+        memcpy(&params, header, 2);
+        memcpy(&params2, &header[2], 2);
+        memcpy(&m, &header[4], 2);
+        return params == SD_JOB_HEADER_PARAMS && params2 == 1 && m == 37;
+    }
+    /** Decides for a command if its coordinates get packed. Starts keyframes. */
+    template<class C> bool packCoordinates(C *code)
+    {
+        metadata(code);
+        if(++count >= SD_COMPILED_KEYFRAME || code->hasZ()) { // keyframe, all coordinates unpacked
+            count = 0;
+            valid = 0;
+        }
+        bool packed = (code->params & (8 | 16 | 32 | 64)) != 0;
+        for(uint8_t i = 0; i < 4 && packed; i++) {
+            if(!(code->params & (8 << i))) continue;
+            float v = (i == 0 ? code->X : (i == 1 ? code->Y : (i == 2 ? code->Z : code->E)));
+            int32_t delta = lroundf(v * 1000.0f) - base[i];
+            packed = (valid & (1 << i)) != 0 && delta >= -32768 && delta <= 32767;
+        }
+        return packed;
+    }
+    uint8_t writeCoordinate(uint8_t *buf, uint8_t p, uint8_t axis, float value, bool packed)
+    {
+        int32_t um = lroundf(value * 1000.0f);
+        if(packed) {
+            int16_t delta = static_cast<int16_t>(um - base[axis]);
+            memcpy(&buf[p], &delta, 2);
+            p += 2;
+        } else {
+            memcpy(&buf[p], &value, 4);
+            p += 4;
+        }
+        base[axis] = um;
+        valid |= 1 << axis;
+        return p;
+    }
+};
+
+/** Writes code in the binary format with fletcher-16 checksum into buf, which needs 100
+bytes. With job the coordinates get packed like in compiled jobs, the line number is never
+written. Returns the size or 0 for commands without parameters. */
+template<class C> uint8_t encodeBinaryCommand(C *code, uint8_t *buf, JobCompiler *job)
+{
+    unsigned int sum1 = 0, sum2 = 0; // for fletcher-16 checksum
+    uint8_t p = 2;
+    uint16_t params = 128 | (code->params & ~1);
+    bool packed = job != NULL && job->packCoordinates(code);
+    if(packed)
+        params |= 8192;
+    if(params == 128)
+        return 0;
+    memcpy(buf, &params, 2);
+    if(code->isV2()) { // Read G,M as 16 bit value
+        memcpy(&buf[p], &code->params2, 2);
+        p += 2;
+        if(code->hasString())
+            buf[p++] = strlen(code->text);
+        if(code->hasM()) {
+            memcpy(&buf[p], &code->M, 2);
+            p += 2;
+        }
+        if(code->hasG()) {
+            memcpy(&buf[p], &code->G, 2);
+            p += 2;
+        }
+    } else {
+        if(code->hasM()) {
+            buf[p++] = (uint8_t)code->M;
+        }
+        if(code->hasG()) {
+            buf[p++] = (uint8_t)code->G;
+        }
+    }
+    if(job != NULL) {
+        if(code->hasX())
+            p = job->writeCoordinate(buf, p, 0, code->X, packed);
+        if(code->hasY())
+            p = job->writeCoordinate(buf, p, 1, code->Y, packed);
+        if(code->hasZ())
+            p = job->writeCoordinate(buf, p, 2, code->Z, packed);
+        if(code->hasE())
+            p = job->writeCoordinate(buf, p, 3, code->E, packed);
+    } else {
+        if(code->hasX()) {
+            memcpy(&buf[p], &code->X, 4);
+            p += 4;
+        }
+        if(code->hasY()) {
+            memcpy(&buf[p], &code->Y, 4);
+            p += 4;
+        }
+        if(code->hasZ()) {
+            memcpy(&buf[p], &code->Z, 4);
+            p += 4;
+        }
+        if(code->hasE()) {
+            memcpy(&buf[p], &code->E, 4);
+            p += 4;
+        }
+    }
+    if(code->hasF()) {
+        memcpy(&buf[p], &code->F, 4);
+        p += 4;
+    }
+    if(code->hasT()) {
+        buf[p++] = code->T;
+    }
+    if(code->hasS()) {
+        memcpy(&buf[p], &code->S, 4);
+        p += 4;
+    }
+    if(code->hasP()) {
+        memcpy(&buf[p], &code->P, 4);
+        p += 4;
+    }
+    if(code->hasI()) {
+        memcpy(&buf[p], &code->I, 4);
+        p += 4;
+    }
+    if(code->hasJ()) {
+        memcpy(&buf[p], &code->J, 4);
+        p += 4;
+    }
+    if(code->hasR()) {
+        memcpy(&buf[p], &code->R, 4);
+        p += 4;
+    }
+    if(code->hasD()) {
+        memcpy(&buf[p], &code->D, 4);
+        p += 4;
+    }
+    if(code->hasC()) {
+        memcpy(&buf[p], &code->C, 4);
+        p += 4;
+    }
+    if(code->hasH()) {
+        memcpy(&buf[p], &code->H, 4);
+        p += 4;
+    }
+    if(code->hasA()) {
+        memcpy(&buf[p], &code->A, 4);
+        p += 4;
+    }
+    if(code->hasB()) {
+        memcpy(&buf[p], &code->B, 4);
+        p += 4;
+    }
+    if(code->hasK()) {
+        memcpy(&buf[p], &code->K, 4);
+        p += 4;
+    }
+    if(code->hasL()) {
+        memcpy(&buf[p], &code->L, 4);
+        p += 4;
+    }
+    if(code->hasO()) {
+        memcpy(&buf[p], &code->O, 4);
+        p += 4;
+    }
+    if(code->hasQ()) {
+        memcpy(&buf[p], &code->Q, 4);
+        p += 4;
+    }
+#if BEZIER_SUPPORT
+    if(code->params2 & 4096) {
+        memcpy(&buf[p], &code->PF, 4);
+        p += 4;
+    }
+#endif
+    if(code->hasString()) { // read 16 uint8_t into string
+        char *sp = code->text;
+        if(code->isV2()) {
+            uint8_t i = strlen(code->text);
+            for(; i; i--) buf[p++] = *sp++;
+        } else {
+            for(uint8_t i = 0; i < 16; ++i) buf[p++] = *sp++;
+        }
+    }
+    uint8_t *ptr = buf;
+    uint8_t len = p;
+    while (len) {
+        uint8_t tlen = len > 21 ? 21 : len;
+        len -= tlen;
+        do {
+            sum1 += *ptr++;
+            if(sum1 >= 255) sum1 -= 255;
+            sum2 += sum1;
+            if(sum2 >= 255) sum2 -= 255;
+        } while (--tlen);
+    }
+    buf[p++] = sum1;
+    buf[p++] = sum2;
+    return p;
+}
+
+#endif
@@ -202,6 +202,26 @@
  */
 #define ARC_SUPPORT 1
 
+/**
+ * Split arcs by chord tolerance. Segments deviate at most ARC_CHORD_TOLERANCE mm
+ * from the arc and are not longer than MM_PER_ARC_SEGMENT (MM_PER_ARC_SEGMENT_BIG
+ * at high feedrates), so MM_PER_ARC_SEGMENT can be raised without losing small
+ * radii. Arc speed is limited so the centripetal acceleration stays below the
+ * xy acceleration, which replaces the jerk limit between the segments of an arc.
+ */
+#define ARC_ADAPTIVE_SEGMENTS 0
+#define ARC_CHORD_TOLERANCE 0.01
+
+/**
+ * G5 cubic Bezier support. G5 I<x1> J<y1> P<x2> Q<y2> X<x> Y<y> E<e> F<f>
+ * I/J is the first control point relative to the start, P/Q the second
+ * control point relative to the end. Curves are split so the lines deviate
+ * at most ARC_CHORD_TOLERANCE mm from the curve and are not longer than
+ * MM_PER_ARC_SEGMENT. Speed is limited by the curvature so the
+ * centripetal acceleration stays below the xy acceleration.
+ */
+#define BEZIER_SUPPORT 0
+
 
 
 
@@ -49,7 +49,9 @@ void EEPROM::update(GCode *com)
     uint8_t newcheck = computeChecksum();
     if(newcheck != HAL::eprGetByte(EPR_INTEGRITY_BYTE))
         HAL::eprSetByte(EPR_INTEGRITY_BYTE, newcheck);
-    bool includesEeprom = com->P >= EEPROM_EXTRUDER_OFFSET && com->P < EEPROM_EXTRUDER_OFFSET + 6 * EEPROM_EXTRUDER_LENGTH;
+    bool includesEeprom = (com->P >= EEPROM_EXTRUDER_OFFSET && com->P < EEPROM_EXTRUDER_OFFSET + 6 * EEPROM_EXTRUDER_LENGTH)
+                          || (com->P >= EPR_EXTRUDER_MODEL_OFFSET && com->P < EPR_EXTRUDER_MODEL_OFFSET + 6 * EPR_EXTRUDER_MODEL_LENGTH)
+                          || (com->P >= EPR_EXTRUDER_FLOW_OFFSET && com->P < EPR_EXTRUDER_FLOW_OFFSET + 6 * EPR_EXTRUDER_FLOW_LENGTH);
     readDataFromEEPROM(includesEeprom);
 #if MIXING_EXTRUDER
     Extruder::selectExtruderById(Extruder::activeMixingExtruder);
@@ -145,6 +147,9 @@ void EEPROM::restoreEEPROMSettingsFromConfiguration()
     e->waitRetractUnits = EXT0_WAIT_RETRACT_UNITS;
 #endif
     e->coolerSpeed = EXT0_EXTRUDER_COOLER_SPEED;
+#if VOLUMETRIC_FLOW_LIMIT
+    e->maxVolumetricFlow = EXT0_MAX_VOLUMETRIC_FLOW;
+#endif
 #if USE_ADVANCE
 #if ENABLE_QUADRATIC_ADVANCE
     e->advanceK = EXT0_ADVANCE_K;
@@ -174,6 +179,9 @@ void EEPROM::restoreEEPROMSettingsFromConfiguration()
     e->waitRetractUnits = EXT1_WAIT_RETRACT_UNITS;
 #endif
     e->coolerSpeed = EXT1_EXTRUDER_COOLER_SPEED;
+#if VOLUMETRIC_FLOW_LIMIT
+    e->maxVolumetricFlow = EXT1_MAX_VOLUMETRIC_FLOW;
+#endif
 #if USE_ADVANCE
 #if ENABLE_QUADRATIC_ADVANCE
     e->advanceK = EXT1_ADVANCE_K;
@@ -203,6 +211,9 @@ void EEPROM::restoreEEPROMSettingsFromConfiguration()
     e->waitRetractUnits = EXT2_WAIT_RETRACT_UNITS;
 #endif
     e->coolerSpeed = EXT2_EXTRUDER_COOLER_SPEED;
+#if VOLUMETRIC_FLOW_LIMIT
+    e->maxVolumetricFlow = EXT2_MAX_VOLUMETRIC_FLOW;
+#endif
 #if USE_ADVANCE
 #if ENABLE_QUADRATIC_ADVANCE
     e->advanceK = EXT2_ADVANCE_K;
@@ -232,6 +243,9 @@ void EEPROM::restoreEEPROMSettingsFromConfiguration()
     e->waitRetractUnits = EXT3_WAIT_RETRACT_UNITS;
 #endif
     e->coolerSpeed = EXT3_EXTRUDER_COOLER_SPEED;
+#if VOLUMETRIC_FLOW_LIMIT
+    e->maxVolumetricFlow = EXT3_MAX_VOLUMETRIC_FLOW;
+#endif
 #if USE_ADVANCE
 #if ENABLE_QUADRATIC_ADVANCE
     e->advanceK = EXT3_ADVANCE_K;
@@ -261,6 +275,9 @@ void EEPROM::restoreEEPROMSettingsFromConfiguration()
     e->waitRetractUnits = EXT4_WAIT_RETRACT_UNITS;
 #endif
     e->coolerSpeed = EXT4_EXTRUDER_COOLER_SPEED;
+#if VOLUMETRIC_FLOW_LIMIT
+    e->maxVolumetricFlow = EXT4_MAX_VOLUMETRIC_FLOW;
+#endif
 #if USE_ADVANCE
 #if ENABLE_QUADRATIC_ADVANCE
     e->advanceK = EXT4_ADVANCE_K;
@@ -290,6 +307,9 @@ void EEPROM::restoreEEPROMSettingsFromConfiguration()
     e->waitRetractUnits = EXT5_WAIT_RETRACT_UNITS;
 #endif
     e->coolerSpeed = EXT5_EXTRUDER_COOLER_SPEED;
+#if VOLUMETRIC_FLOW_LIMIT
+    e->maxVolumetricFlow = EXT5_MAX_VOLUMETRIC_FLOW;
+#endif
 #if USE_ADVANCE
 #if ENABLE_QUADRATIC_ADVANCE
     e->advanceK = EXT5_ADVANCE_K;
@@ -297,6 +317,14 @@ void EEPROM::restoreEEPROMSettingsFromConfiguration()
     e->advanceL = EXT5_ADVANCE_L;
 #endif
 #endif // NUM_EXTRUDER > 5
+#if TEMP_MODEL_CONTROL
+    for(uint8_t i = 0; i < NUM_EXTRUDER; i++) {
+        extruder[i].tempControl.model.gain = TEMP_MODEL_GAIN;
+        extruder[i].tempControl.model.timeConstant = TEMP_MODEL_TIME_CONSTANT;
+        extruder[i].tempControl.model.dead = TEMP_MODEL_DEAD_TIME;
+        extruder[i].tempControl.model.feedForward = TEMP_MODEL_FEED_FORWARD;
+    }
+#endif
 #if FEATURE_AUTOLEVEL
     Printer::setAutolevelActive(false);
     Printer::resetTransformationMatrix(true);
@@ -401,6 +429,12 @@ void EEPROM::storeDataIntoEEPROM(uint8_t corrupted)
     HAL::eprSetByte(EPR_SELECTED_LANGUAGE,Com::selectedLanguage);
 #endif
     // now the extruder
+#if !VOLUMETRIC_FLOW_LIMIT
+    // enabling the limit later starts with the configured values
+    const float configuredFlow[6] = {EXT0_MAX_VOLUMETRIC_FLOW, EXT1_MAX_VOLUMETRIC_FLOW, EXT2_MAX_VOLUMETRIC_FLOW,
+                                     EXT3_MAX_VOLUMETRIC_FLOW, EXT4_MAX_VOLUMETRIC_FLOW, EXT5_MAX_VOLUMETRIC_FLOW
+                                    };
+#endif
     for(uint8_t i = 0; i < NUM_EXTRUDER; i++)
     {
 #if FEATURE_WATCHDOG
@@ -443,6 +477,23 @@ void EEPROM::storeDataIntoEEPROM(uint8_t corrupted)
 #else
         HAL::eprSetFloat(o+EPR_EXTRUDER_ADVANCE_K,0);
         HAL::eprSetFloat(o+EPR_EXTRUDER_ADVANCE_L,0);
+#endif
+        o = i * EPR_EXTRUDER_MODEL_LENGTH + EPR_EXTRUDER_MODEL_OFFSET;
+#if TEMP_MODEL_CONTROL
+        HAL::eprSetFloat(o+EPR_EXTRUDER_MODEL_GAIN,e->tempControl.model.gain);
+        HAL::eprSetFloat(o+EPR_EXTRUDER_MODEL_TIME_CONSTANT,e->tempControl.model.timeConstant);
+        HAL::eprSetFloat(o+EPR_EXTRUDER_MODEL_DEAD_TIME,e->tempControl.model.dead);
+        HAL::eprSetFloat(o+EPR_EXTRUDER_MODEL_FEED_FORWARD,e->tempControl.model.feedForward);
+#else
+        HAL::eprSetFloat(o+EPR_EXTRUDER_MODEL_GAIN,0);
+        HAL::eprSetFloat(o+EPR_EXTRUDER_MODEL_TIME_CONSTANT,0);
+        HAL::eprSetFloat(o+EPR_EXTRUDER_MODEL_DEAD_TIME,0);
+        HAL::eprSetFloat(o+EPR_EXTRUDER_MODEL_FEED_FORWARD,0);
+#endif
+#if VOLUMETRIC_FLOW_LIMIT
+        HAL::eprSetFloat(i * EPR_EXTRUDER_FLOW_LENGTH + EPR_EXTRUDER_FLOW_OFFSET, e->maxVolumetricFlow);
+#else
+        HAL::eprSetFloat(i * EPR_EXTRUDER_FLOW_LENGTH + EPR_EXTRUDER_FLOW_OFFSET, configuredFlow[i]);
 #endif
     }
 #if MIXING_EXTRUDER
@@ -650,6 +701,26 @@ void EEPROM::readDataFromEEPROM(bool includeExtruder)
                 HAL::eprSetInt32(o+EPR_EXTRUDER_Z_OFFSET,e->zOffset);
             }
             e->zOffset = HAL::eprGetInt32(o + EPR_EXTRUDER_Z_OFFSET);
+#if TEMP_MODEL_CONTROL
+            // Unset or invalid models keep the configuration values
+            o = i * EPR_EXTRUDER_MODEL_LENGTH + EPR_EXTRUDER_MODEL_OFFSET;
+            float gain = HAL::eprGetFloat(o + EPR_EXTRUDER_MODEL_GAIN);
+            float timeConstant = HAL::eprGetFloat(o + EPR_EXTRUDER_MODEL_TIME_CONSTANT);
+            float deadTime = HAL::eprGetFloat(o + EPR_EXTRUDER_MODEL_DEAD_TIME);
+            float feedForward = HAL::eprGetFloat(o + EPR_EXTRUDER_MODEL_FEED_FORWARD);
+            if(gain > 0 && timeConstant > 0 && deadTime >= 0 && feedForward >= 0) {
+                e->tempControl.model.gain = gain;
+                e->tempControl.model.timeConstant = timeConstant;
+                e->tempControl.model.dead = deadTime;
+                e->tempControl.model.feedForward = feedForward;
+            }
+#endif
+            e->tempControl.updateTempControlVars(); // rejects unusable heat manager
+#if VOLUMETRIC_FLOW_LIMIT
+            float flow = HAL::eprGetFloat(i * EPR_EXTRUDER_FLOW_LENGTH + EPR_EXTRUDER_FLOW_OFFSET);
+            if(flow >= 0) // unset value keeps configuration
+                e->maxVolumetricFlow = flow;
+#endif
         }
     }
     if(version != EEPROM_PROTOCOL_VERSION)
@@ -1061,6 +1132,16 @@ writeFloat(EPR_X2AXIS_STEPS_PER_MM, Com::tEPRX2StepsPerMM, 4);
 #endif
         writeFloat(o + EPR_EXTRUDER_ADVANCE_L, Com::tEPRAdvanceL);
 #endif
+#if TEMP_MODEL_CONTROL
+        int m = i * EPR_EXTRUDER_MODEL_LENGTH + EPR_EXTRUDER_MODEL_OFFSET;
+        writeFloat(m + EPR_EXTRUDER_MODEL_GAIN, Com::tEPRModelGain, 4);
+        writeFloat(m + EPR_EXTRUDER_MODEL_TIME_CONSTANT, Com::tEPRModelTimeConstant);
+        writeFloat(m + EPR_EXTRUDER_MODEL_DEAD_TIME, Com::tEPRModelDeadTime);
+        writeFloat(m + EPR_EXTRUDER_MODEL_FEED_FORWARD, Com::tEPRModelFeedForward);
+#endif
+#if VOLUMETRIC_FLOW_LIMIT
+        writeFloat(i * EPR_EXTRUDER_FLOW_LENGTH + EPR_EXTRUDER_FLOW_OFFSET, Com::tEPRMaxVolumetricFlow);
+#endif
 #if MIXING_EXTRUDER
         for(uint8_t v = 0; v < VIRTUAL_EXTRUDER; v++)
         {
@@ -1102,8 +1183,13 @@ void EEPROM::updateChecksum()
 
 void EEPROM::writeExtruderPrefix(uint pos)
 {
-    if(pos < EEPROM_EXTRUDER_OFFSET || pos >= 800) return;
-    int n = (pos - EEPROM_EXTRUDER_OFFSET) / EEPROM_EXTRUDER_LENGTH + 1;
+    int n;
+    if(pos >= EPR_EXTRUDER_MODEL_OFFSET && pos < EPR_EXTRUDER_MODEL_OFFSET + 6 * EPR_EXTRUDER_MODEL_LENGTH)
+        n = (pos - EPR_EXTRUDER_MODEL_OFFSET) / EPR_EXTRUDER_MODEL_LENGTH + 1;
+    else if(pos >= EPR_EXTRUDER_FLOW_OFFSET && pos < EPR_EXTRUDER_FLOW_OFFSET + 6 * EPR_EXTRUDER_FLOW_LENGTH)
+        n = (pos - EPR_EXTRUDER_FLOW_OFFSET) / EPR_EXTRUDER_FLOW_LENGTH + 1;
+    else if(pos < EEPROM_EXTRUDER_OFFSET || pos >= 800) return;
+    else n = (pos - EEPROM_EXTRUDER_OFFSET) / EEPROM_EXTRUDER_LENGTH + 1;
     Com::printF(Com::tExtrDot, n);
     Com::print(' ');
 }
@@ -132,6 +132,8 @@ have problems with other modules using the eeprom */
 #define EPR_PARK_X						      1056
 #define EPR_PARK_Y                            1060
 #define EPR_PARK_Z                            1064
+#define EPR_EXTRUDER_MODEL_OFFSET             1068 // 16 byte per extruder -> end = 1164
+#define EPR_EXTRUDER_FLOW_OFFSET              1164 // 4 byte per extruder -> end = 1188
 
 
 
@@ -177,6 +179,14 @@ have problems with other modules using the eeprom */
 #define EPR_EXTRUDER_MIXING_RATIOS  58 // 16*2 byte ratios = 32 byte -> end = 89
 #define EPR_EXTRUDER_Z_OFFSET            90
 #define EPR_EXTRUDER_PREHEAT             94 // maybe better temperature
+// Heat manager model per extruder, relative to EPR_EXTRUDER_MODEL_OFFSET + extruder * EPR_EXTRUDER_MODEL_LENGTH
+#define EPR_EXTRUDER_MODEL_LENGTH        16
+#define EPR_EXTRUDER_MODEL_GAIN           0
+#define EPR_EXTRUDER_MODEL_TIME_CONSTANT  4
+#define EPR_EXTRUDER_MODEL_DEAD_TIME      8
+#define EPR_EXTRUDER_MODEL_FEED_FORWARD  12
+// Max. volumetric flow per extruder at EPR_EXTRUDER_FLOW_OFFSET + extruder * EPR_EXTRUDER_FLOW_LENGTH
+#define EPR_EXTRUDER_FLOW_LENGTH          4
 #ifndef Z_PROBE_BED_DISTANCE
 #define Z_PROBE_BED_DISTANCE 5.0
 #endif
@@ -32,7 +32,26 @@ uint8_t Extruder::dittoMode = 0;
 int Extruder::mixingS;
 uint8_t Extruder::mixingDir = 10;
 uint8_t Extruder::activeMixingExtruder = 0;
+int Extruder::mixingWA[NUM_EXTRUDER];
 #endif // MIXING_EXTRUDER
+#if PREDICTIVE_HEATUP
+uint8_t Extruder::heatupPending = 0;
+static float heatupStartTemp[NUM_TEMPERATURE_LOOPS];
+static millis_t heatupStartTime[NUM_TEMPERATURE_LOOPS];
+#endif
+#if TOOLCHANGE_PREHEAT
+static float toolchangeTemp[NUM_EXTRUDER]; // temperature of each tool when it was last active
+static millis_t toolPreheatStart[NUM_EXTRUDER]; // 0 = not heated ahead of change
+static millis_t toolPreheatReached[NUM_EXTRUDER];
+static float toolPreheatStandby[NUM_EXTRUDER]; // temperature to return to if the preheated tool is not selected
+static millis_t toolchangeSaved = 0; // heat-up time saved in current job
+static int8_t toolchangeNext = -1;
+static float toolchangeNextTime; // seconds until change to toolchangeNext
+#if SDSUPPORT
+static float toolchangeByteRate = 0; // bytes per second read from sd card
+static uint32_t toolchangeLastSdpos = 0;
+#endif
+#endif
 #ifdef SUPPORT_MAX6675
 extern int16_t read_max6675(uint8_t ss_pin, fast8_t idx);
 #endif
@@ -45,6 +64,9 @@ const uint8 osAnalogInputChannels[] PROGMEM = ANALOG_INPUT_CHANNELS;
 volatile uint osAnalogInputValues[ANALOG_INPUTS];
 #endif
 
+#if FAST_TEMPERATURE_LOOKUP && NUM_TEMPERATURE_LOOPS > 0
+TemperatureLookup temperatureLookupTables[NUM_TEMPERATURE_LOOPS];
+#endif
 #ifdef USE_GENERIC_THERMISTORTABLE_1
 short temptable_generic1[GENERIC_THERM_NUM_ENTRIES][2];
 #endif
@@ -60,6 +82,9 @@ Is called every 100ms.
 */
 static uint8_t extruderTempErrors = 0;
 static uint8_t extrSecondFlag = 0;
+#if HEATER_SCHEDULER
+static uint8_t heaterDemand[NUM_TEMPERATURE_LOOPS]; ///< Heat manager outputs, scheduleHeaters limits them and sets pwm_pos
+#endif
 void Extruder::manageTemperatures() {
     extrSecondFlag++;
     if(extrSecondFlag == 10)
@@ -244,6 +269,10 @@ void Extruder::manageTemperatures() {
                 act->tempIStateLimitMax = act->pidDriveMax;
                 act->tempIStateLimitMin = 0;
             }
+#if TEMP_MODEL_CONTROL
+            if(act->heatManager == HTR_MODEL)
+                act->tempIState = 0;
+#endif
         } else if(error < -PID_CONTROL_RANGE) // control range left upper side!
             output = 0;
         else { // control range handle by heat manager
@@ -283,7 +312,21 @@ void Extruder::manageTemperatures() {
 #endif
                 output = static_cast<uint8_t>(act->currentTemperatureC + raising * act->deadTime > act->targetTemperatureC ? act->tempIStateLimitMin : act->tempIStateLimitMax /* pidDriveMax */);
                 act->tempIState = raising;
-            } else // bang bang and slow bang bang
+            }
+#if TEMP_MODEL_CONTROL
+            else if(act->heatManager == HTR_MODEL && act->model.gain > 0) { // model based control
+                act->startHoldDecouple(time);
+                float extrusionSpeed = 0;
+#if SHARED_EXTRUDER_HEATER || MIXING_EXTRUDER
+                if(controller == 0)
+#else
+                if(controller == Extruder::current->id)
+#endif
+                    extrusionSpeed = PrintLine::plannedExtrusionSpeed(act->model.dead + TEMP_MODEL_HORIZON);
+                output = act->computeModelOutput(extrusionSpeed);
+            }
+#endif
+            else // bang bang and slow bang bang
                 if(act->heatManager == HTR_SLOWBANG) {  // Bang-bang with reduced change frequency to save relays life
                     if (time - act->lastTemperatureUpdate > HEATED_BED_SET_INTERVAL) {
                         output = (on ? act->pidMax : 0);
@@ -301,7 +344,11 @@ void Extruder::manageTemperatures() {
         if(act->currentTemperatureC > MAXTEMP) // Force heater off if MAXTEMP is exceeded
             output = 0;
 #endif // MAXTEMP
+#if HEATER_SCHEDULER
+        heaterDemand[controller] = output;
+#else
         pwm_pos[act->pwmIndex] = output; // set pwm signal
+#endif
         if(extrSecondFlag == 0 /*|| (act->heatManager == HTR_DEADTIME && extrSecondFlag == 5)*/) {
             act->lastTemperatureC = act->temperatureC;
             act->temperatureC = act->currentTemperatureC;
@@ -312,6 +359,9 @@ void Extruder::manageTemperatures() {
             WRITE(LED_PIN, on);
 #endif // LED_PIN
     } // for controller
+#if HEATER_SCHEDULER
+    scheduleHeaters(time);
+#endif
 
 #ifdef RED_BLUE_STATUS_LEDS
     if(Printer::isAnyTempsensorDefect()) {
@@ -644,22 +694,229 @@ void Extruder::initExtruder() {
     WRITE(HEATED_BED_HEATER_PIN, HEATER_PINS_INVERTED);
     Extruder::initHeatedBed();
 #endif
+#if FAST_TEMPERATURE_LOOKUP && NUM_TEMPERATURE_LOOPS > 0
+    for(i = 0; i < NUM_TEMPERATURE_LOOPS; i++)
+        tempController[i]->buildLookupTable(&temperatureLookupTables[i]);
+#endif
 #if ANALOG_INPUTS > 0
     HAL::analogStart();
 #endif
 }
 
+#if HEATER_SCHEDULER
+static float heaterCurrentDemand = 0; ///< Smoothed current requested by heat managers
+static float heaterCurrentUsed = 0; ///< Smoothed current granted to heaters
+#if HEATER_CURRENT_BUDGET > 0
+static millis_t heaterThrottleStart[NUM_TEMPERATURE_LOOPS]; ///< Start of decoupling test hold, 0 = none
+static millis_t heaterThrottleLast[NUM_TEMPERATURE_LOOPS]; ///< Last time the heater was throttled
+#endif
+
+/** \brief Limits heater outputs to the current budget and staggers their pwm phases.
+
+Called after every temperature update. If the requested outputs exceed HEATER_CURRENT_BUDGET,
+heaters get power in order of their distance below target until the budget is used up.
+Throttled heaters can not rise as expected, so their decoupling test is postponed, but for
+at most HEATER_THROTTLE_HOLD ms. A new hold needs a full unthrottled test period before.
+Then every heater gets its pwm phase right after the end of the previous heater, so their
+on times do not overlap as long as the duty cycles sum up to less than 100%.
+
+Heat managers only write heaterDemand, pwm_pos gets the limited outputs here, so the pwm
+interrupt never sees an output above budget. The interrupt takes over outputs and phases at
+the start of a pwm period, so changed phases can not switch a heater on twice or skip it.
+*/
+void Extruder::scheduleHeaters(millis_t time) {
+    float demand = 0, used = 0;
+    uint8_t done = 0; // bit mask of heaters already handled
+    uint8_t output[NUM_TEMPERATURE_LOOPS];
+    for(uint8_t n = 0; n <= HEATED_BED_INDEX; n++) {
+        // pick heater furthest below target, the autotune heater goes first as it must not be throttled
+        uint8_t best = 255;
+        float bestError = 0;
+        for(uint8_t i = 0; i <= HEATED_BED_INDEX; i++) {
+            if(done & (1 << i)) continue;
+            TemperatureController *act = tempController[i];
+            float error = (i == autotuneIndex ? 10000 : act->targetTemperatureC - act->currentTemperatureC);
+            if(best == 255 || error > bestError) {
+                best = i;
+                bestError = error;
+            }
+        }
+        done |= 1 << best;
+        TemperatureController *act = tempController[best];
+#if HAVE_HEATED_BED
+        float current = (best == HEATED_BED_INDEX ? HEATED_BED_HEATER_CURRENT : EXTRUDER_HEATER_CURRENT) / 255.0f;
+#else
+        float current = EXTRUDER_HEATER_CURRENT / 255.0f;
+#endif
+        if(best == autotuneIndex)
+            output[best] = pwm_pos[act->pwmIndex]; // set by the autotune
+        else
+            output[best] = (Printer::isAnyTempsensorDefect() ? 0 : heaterDemand[best]);
+        demand += output[best] * current;
+#if HEATER_CURRENT_BUDGET > 0
+        if(best != autotuneIndex && used + output[best] * current > HEATER_CURRENT_BUDGET) {
+            float allowed = (HEATER_CURRENT_BUDGET - used) / current;
+            output[best] = (allowed > 0 ? static_cast<uint8_t>(allowed) : 0);
+            if(heaterThrottleStart[best] == 0)
+                heaterThrottleStart[best] = (time ? time : 1);
+            if(time - heaterThrottleStart[best] < HEATER_THROTTLE_HOLD) {
+                act->lastDecoupleTest = time;
+                act->lastDecoupleTemp = (act->isDecoupleHold() ? act->targetTemperatureC : act->currentTemperatureC);
+            }
+            heaterThrottleLast[best] = time;
+        } else if(heaterThrottleStart[best] != 0 && time - heaterThrottleLast[best] > act->decoupleTestPeriod)
+            heaterThrottleStart[best] = 0;
+#endif
+        used += output[best] * current;
+    }
+    heaterCurrentDemand = 0.9f * heaterCurrentDemand + 0.1f * demand;
+    heaterCurrentUsed = 0.9f * heaterCurrentUsed + 0.1f * used;
+    uint8_t phase = 0;
+    InterruptProtectedBlock noInts; // the pwm interrupt latches output and phase together
+    for(uint8_t i = 0; i <= HEATED_BED_INDEX; i++) {
+        uint8_t idx = tempController[i]->pwmIndex;
+        pwm_pos[idx] = output[i];
+        heaterPhase[idx] = phase;
+        phase += output[i];
+    }
+}
+
+void Extruder::reportHeaterBudget() {
+    Com::printF(PSTR("Heater current demand:"), heaterCurrentDemand, 2);
+    Com::printF(PSTR(" A used:"), heaterCurrentUsed, 2);
+#if HEATER_CURRENT_BUDGET > 0
+    Com::printF(PSTR(" A budget:"), (float)HEATER_CURRENT_BUDGET, 2);
+    Com::printF(PSTR(" A utilization:"), heaterCurrentUsed * 100.0f / HEATER_CURRENT_BUDGET, 0);
+    Com::printFLN(PSTR("%"));
+#else
+    Com::printFLN(PSTR(" A"));
+#endif
+}
+#endif
+
+#if ANALOG_INPUT_FILTER && ANALOG_INPUTS > 0
+/** Reports mean and peak deviation of the readings of every analog input from the filtered
+value in 12 bit ADC units. Peak values are reset afterwards. */
+void Extruder::reportAnalogNoise() {
+    for(uint8_t i = 0; i < ANALOG_INPUTS; i++) {
+        uint noise, peak;
+        {
+            InterruptProtectedBlock noInts;
+            noise = osAnalogInputNoise[i];
+            peak = osAnalogInputPeak[i];
+            osAnalogInputPeak[i] = 0;
+        }
+        Com::printF(PSTR("ADC"), (int)i);
+        Com::printF(PSTR(" noise:"), noise * 0.0625f, 2);
+        Com::printFLN(PSTR(" peak:"), (int)peak);
+    }
+}
+#endif
+
 void TemperatureController::updateTempControlVars() {
+#if TEMP_MODEL_CONTROL
+    if(heatManager == HTR_MODEL && model.gain <= 0) { // would never heat
+#else
+    if(heatManager == HTR_MODEL) {
+#endif
+        Com::printErrorFLN(PSTR("No heater model, using PID control"));
+        heatManager = HTR_PID;
+    }
     if(heatManager == HTR_PID && pidIGain != 0) { // prevent division by zero
         tempIStateLimitMax = (float)pidDriveMax * 10.0f / pidIGain;
         tempIStateLimitMin = (float)pidDriveMin * 10.0f / pidIGain;
     }
+#if TEMP_MODEL_CONTROL
+    if(heatManager == HTR_MODEL) {
+        tempIStateLimitMax = TEMP_MODEL_MAX_CORRECTION;
+        tempIStateLimitMin = -TEMP_MODEL_MAX_CORRECTION;
+    }
+#endif
 }
 
+#if TEMP_MODEL_CONTROL
+/** Computes heater output for heat manager HTR_MODEL, see TemperatureModel::control.
+\param extrusionSpeed Filament speed expected in the next seconds in mm/s.
+*/
+uint8_t TemperatureController::computeModelOutput(float extrusionSpeed) {
+    return model.control(currentTemperatureC, temperatureC - lastTemperatureC, targetTemperatureC, extrusionSpeed, pidMax, tempIState);
+}
+#endif
+
 /** \brief Select extruder ext_num.
 
 This function changes and initializes a new extruder. This is also called, after the eeprom values are changed.
 */
+#if TOOLCHANGE_PREHEAT
+/** Looks for the next tool change and heats that tool TOOLCHANGE_PREHEAT_TIME seconds
+ahead. Called every 500ms. */
+void Extruder::toolchangeLookahead() {
+    millis_t now = HAL::timeInMilliseconds();
+    for(uint8_t i = 0; i < NUM_EXTRUDER; i++) {
+        TemperatureController *tc = &extruder[i].tempControl;
+        if(toolPreheatStart[i] != 0 && toolPreheatReached[i] == 0 && fabs(tc->targetTemperatureC - tc->currentTemperatureC) <= 1)
+            toolPreheatReached[i] = now;
+    }
+    toolchangeNext = -1;
+    // Buffered commands get executed in a moment
+    for(uint8_t i = 0, idx = GCode::bufferReadIndex; i < GCode::bufferLength; i++) {
+        GCode *code = &GCode::commandsBuffered[idx];
+        if(!code->hasG() && !code->hasM() && code->hasT()) {
+            toolchangeNext = code->T;
+            toolchangeNextTime = 0;
+            break;
+        }
+        if(++idx >= GCODE_BUFFER_SIZE) idx = 0;
+    }
+#if SDSUPPORT
+    if(sd.sdmode == 1) {
+        if(sd.sdpos >= toolchangeLastSdpos)
+            toolchangeByteRate = 0.8f * toolchangeByteRate + 0.4f * (sd.sdpos - toolchangeLastSdpos);
+        toolchangeLastSdpos = sd.sdpos;
+        if(toolchangeNext < 0) {
+            toolchangeNext = sd.scanToolchange();
+            if(toolchangeNext >= 0)
+                toolchangeNextTime = (toolchangeByteRate > 1 ? (sd.toolchangePos - sd.sdpos) / toolchangeByteRate : 1e6);
+        }
+    }
+#endif
+    // Lookahead passed a preheated tool without selecting it, back to standby
+    for(uint8_t i = 0; i < NUM_EXTRUDER; i++) {
+        if(toolPreheatStart[i] == 0 || i == toolchangeNext || i == Extruder::current->id)
+            continue;
+        TemperatureController *tc = &extruder[i].tempControl;
+        toolPreheatStart[i] = 0;
+        tc->setTargetTemperature(toolPreheatStandby[i]);
+        tc->updateTempControlVars();
+        Com::printF(PSTR("Preheat for tool change ended T"), (int)i);
+        Com::printFLN(Com::tColon, toolPreheatStandby[i], 0);
+    }
+    if(toolchangeNext < 0 || toolchangeNext >= NUM_EXTRUDER || toolchangeNext == Extruder::current->id || toolchangeNextTime > TOOLCHANGE_PREHEAT_TIME)
+        return;
+    TemperatureController *tc = &extruder[toolchangeNext].tempControl;
+    // Only tools in standby get heated, switched off tools stay off
+    if(toolPreheatStart[toolchangeNext] != 0 || tc->targetTemperatureC < MAX_ROOM_TEMPERATURE || tc->targetTemperatureC >= toolchangeTemp[toolchangeNext])
+        return;
+    toolPreheatStart[toolchangeNext] = now;
+    toolPreheatReached[toolchangeNext] = 0;
+    toolPreheatStandby[toolchangeNext] = tc->targetTemperatureC;
+    tc->setTargetTemperature(toolchangeTemp[toolchangeNext]);
+    tc->updateTempControlVars();
+    Com::printF(PSTR("Preheat for tool change T"), (int)toolchangeNext);
+    Com::printFLN(Com::tColon, toolchangeTemp[toolchangeNext], 0);
+}
+
+/** Reports heat-up time saved by preheating tool id, which just got selected. */
+static void toolchangePreheatDone(uint8_t id) {
+    if(toolPreheatStart[id] == 0) return;
+    millis_t saved = (toolPreheatReached[id] != 0 ? toolPreheatReached[id] : HAL::timeInMilliseconds()) - toolPreheatStart[id];
+    toolPreheatStart[id] = 0;
+    toolchangeSaved += saved;
+    Com::printF(PSTR("Tool change preheat saved:"), (int32_t)(saved / 1000));
+    Com::printFLN(PSTR(" s job total:"), (int32_t)(toolchangeSaved / 1000));
+}
+#endif
+
 void Extruder::selectExtruderById(uint8_t extruderId) {
     float cx, cy, cz;
     Printer::realPosition(cx, cy, cz);
@@ -668,7 +925,9 @@ void Extruder::selectExtruderById(uint8_t extruderId) {
         return;
 #endif
 #if NUM_EXTRUDER > 0
+#if !MIXING_GRADIENT // new weights only apply to new moves
     Commands::waitUntilEndOfAllMoves();
+#endif
 #if MIXING_EXTRUDER
     if(extruderId >= VIRTUAL_EXTRUDER)
         extruderId = 0;
@@ -751,6 +1010,10 @@ void Extruder::selectExtruderById(uint8_t extruderId) {
 
     Extruder::current = next;
     // --------------------- Now new extruder is active --------------------
+#if TOOLCHANGE_PREHEAT
+    if(executeSelect)
+        toolchangePreheatDone(extruderId);
+#endif
 #if DUAL_X_RESOLUTION
     Printer::updateDerivedParameter(); // adjust to new resolution
     dualXPosSteps = Printer::lastCmdPos[X_AXIS] * Printer::axisStepsPerMM[X_AXIS] - Printer::xMinSteps; // correct to where we should be in new coordinates
@@ -861,6 +1124,8 @@ void Extruder::recomputeMixingExtruderSteps() {
         sum_w += extruder[i].mixingW;
         sum += extruder[i].stepsPerMM * extruder[i].mixingW;
     }
+    if(sum_w <= 0 || sum <= 0) // no weights set yet, keep the resolution
+        return;
     sum /= sum_w;
     Printer::currentPositionSteps[E_AXIS] =  Printer::currentPositionSteps[E_AXIS] * sum / Printer::axisStepsPerMM[E_AXIS]; // reposition according resolution change
     Printer::destinationSteps[E_AXIS] = Printer::currentPositionSteps[E_AXIS];
@@ -869,6 +1134,72 @@ void Extruder::recomputeMixingExtruderSteps() {
 }
 #endif
 
+/** Waits like M109 until extruder extr reached its target. Then the temperature has to stay
+within TEMP_HYSTERESIS for the watch period of the extruder. Waits at most 120 seconds after
+the temperature came within 5 degrees of the target. */
+void Extruder::waitForExtruderTemperature(uint8_t extr) {
+    TemperatureController *tc = tempController[extr];
+    if(tc->targetTemperatureC <= MAX_ROOM_TEMPERATURE
+#if defined(SKIP_M109_IF_WITHIN) && SKIP_M109_IF_WITHIN > 0
+            || abs(tc->currentTemperatureC - tc->targetTemperatureC) < (SKIP_M109_IF_WITHIN) // Already in range
+#endif
+      )
+        return;
+    Extruder *actExtruder = &extruder[extr];
+    UI_STATUS_UPD_F(Com::translatedF(UI_TEXT_HEATING_EXTRUDER_ID));
+    EVENT_WAITING_HEATER(actExtruder->id);
+    bool dirRising = actExtruder->tempControl.targetTemperatureC > actExtruder->tempControl.currentTemperatureC;
+    //millis_t printedTime = HAL::timeInMilliseconds();
+    millis_t waituntil = 0;
+#if RETRACT_DURING_HEATUP
+    uint8_t retracted = 0;
+#endif
+    millis_t currentTime;
+    millis_t maxWaitUntil = 0;
+    bool oldAutoreport = Printer::isAutoreportTemp();
+    Printer::setAutoreportTemp(true);
+    do {
+        previousMillisCmd = currentTime = HAL::timeInMilliseconds();
+        /*if( (currentTime - printedTime) > 1000 )   //Print Temp Reading every 1 second while heating up.
+        {
+            Commands::printTemperatures();
+            printedTime = currentTime;
+        }*/
+        Commands::checkForPeriodicalActions(true);
+        GCode::keepAlive(WaitHeater);
+        //gcode_read_serial();
+#if RETRACT_DURING_HEATUP
+        if (actExtruder == Extruder::current && actExtruder->waitRetractUnits > 0 && !retracted && dirRising && actExtruder->tempControl.currentTemperatureC > actExtruder->waitRetractTemperature) {
+            PrintLine::moveRelativeDistanceInSteps(0, 0, 0, -actExtruder->waitRetractUnits * Printer::axisStepsPerMM[E_AXIS], actExtruder->maxFeedrate / 4, false, false);
+            retracted = 1;
+        }
+#endif
+        if(maxWaitUntil == 0) {
+            if(dirRising ? actExtruder->tempControl.currentTemperatureC >= actExtruder->tempControl.targetTemperatureC - 5 : actExtruder->tempControl.currentTemperatureC <= actExtruder->tempControl.targetTemperatureC + 5) {
+                maxWaitUntil = currentTime + 120000L;
+            }
+        } else if((millis_t)(maxWaitUntil - currentTime) < 2000000000UL) {
+            break;
+        }
+        if((waituntil == 0 &&
+                (dirRising ? actExtruder->tempControl.currentTemperatureC >= actExtruder->tempControl.targetTemperatureC - 1
+                 : actExtruder->tempControl.currentTemperatureC <= actExtruder->tempControl.targetTemperatureC + 1))
+#if defined(TEMP_HYSTERESIS) && TEMP_HYSTERESIS >= 1
+                || (waituntil != 0 && (abs(actExtruder->tempControl.currentTemperatureC - actExtruder->tempControl.targetTemperatureC)) > TEMP_HYSTERESIS)
+#endif
+          ) {
+            waituntil = currentTime + 1000UL * (millis_t)actExtruder->watchPeriod; // now wait for temp. to stabilize
+        }
+    } while(waituntil == 0 || (waituntil != 0 && (millis_t)(waituntil - currentTime) < 2000000000UL));
+    Printer::setAutoreportTemp(oldAutoreport);
+#if RETRACT_DURING_HEATUP
+    if (retracted && actExtruder == Extruder::current) {
+        PrintLine::moveRelativeDistanceInSteps(0, 0, 0, actExtruder->waitRetractUnits * Printer::axisStepsPerMM[E_AXIS], actExtruder->maxFeedrate / 4, false, false);
+    }
+#endif
+    EVENT_HEATING_FINISHED(actExtruder->id);
+}
+
 void Extruder::setTemperatureForExtruder(float temperatureInCelsius, uint8_t extr, bool beep, bool wait) {
 #if NUM_EXTRUDER > 0
 #if MIXING_EXTRUDER || SHARED_EXTRUDER_HEATER
@@ -877,6 +1208,15 @@ void Extruder::setTemperatureForExtruder(float temperatureInCelsius, uint8_t ext
     bool alloffs = true;
     for(uint8_t i = 0; i < NUM_EXTRUDER; i++)
         if(tempController[i]->targetTemperatureC > 15) alloffs = false;
+#if TOOLCHANGE_PREHEAT
+    if(alloffs && temperatureInCelsius > 15) { // new job
+        toolchangeSaved = 0;
+        for(uint8_t i = 0; i < NUM_EXTRUDER; i++) {
+            toolchangeTemp[i] = 0;
+            toolPreheatStart[i] = 0;
+        }
+    }
+#endif
 #ifdef MAXTEMP
     if(temperatureInCelsius > MAXTEMP) temperatureInCelsius = MAXTEMP;
 #endif
@@ -889,6 +1229,18 @@ void Extruder::setTemperatureForExtruder(float temperatureInCelsius, uint8_t ext
 #endif
         if(tc->sensorType == 0) temperatureInCelsius = 0;
         //if(temperatureInCelsius==tc->targetTemperatureC) return;
+#if TOOLCHANGE_PREHEAT
+        if(extr == Extruder::current->id) {
+            if(temperatureInCelsius > MAX_ROOM_TEMPERATURE)
+                toolchangeTemp[extr] = temperatureInCelsius;
+        } else if(temperatureInCelsius > MAX_ROOM_TEMPERATURE && temperatureInCelsius < tc->targetTemperatureC
+                  && (toolPreheatStart[extr] != 0 || (toolchangeNext == extr && toolchangeNextTime <= TOOLCHANGE_PREHEAT_TIME))) {
+            if(toolPreheatStart[extr] != 0)
+                toolPreheatStandby[extr] = temperatureInCelsius; // used if the change does not happen
+            temperatureInCelsius = tc->targetTemperatureC; // tool change is due soon, keep it hot
+        } else
+            toolPreheatStart[extr] = 0; // other temperatures end the preheat
+#endif
         if (temperatureInCelsius < MAX_ROOM_TEMPERATURE)
             tc->resetPreheatTime();
         else if (tc->targetTemperatureC == 0)
@@ -929,65 +1281,8 @@ void Extruder::setTemperatureForExtruder(float temperatureInCelsius, uint8_t ext
 #endif
     }
 #endif // FEATURE_DITTO_PRINTING
-    if(wait && temperatureInCelsius > MAX_ROOM_TEMPERATURE
-#if defined(SKIP_M109_IF_WITHIN) && SKIP_M109_IF_WITHIN > 0
-            && !(abs(tc->currentTemperatureC - tc->targetTemperatureC) < (SKIP_M109_IF_WITHIN))// Already in range
-#endif
-      ) {
-        Extruder *actExtruder = &extruder[extr];
-        UI_STATUS_UPD_F(Com::translatedF(UI_TEXT_HEATING_EXTRUDER_ID));
-        EVENT_WAITING_HEATER(actExtruder->id);
-        bool dirRising = actExtruder->tempControl.targetTemperatureC > actExtruder->tempControl.currentTemperatureC;
-        //millis_t printedTime = HAL::timeInMilliseconds();
-        millis_t waituntil = 0;
-#if RETRACT_DURING_HEATUP
-        uint8_t retracted = 0;
-#endif
-        millis_t currentTime;
-        millis_t maxWaitUntil = 0;
-        bool oldAutoreport = Printer::isAutoreportTemp();
-        Printer::setAutoreportTemp(true);
-        do {
-            previousMillisCmd = currentTime = HAL::timeInMilliseconds();
-            /*if( (currentTime - printedTime) > 1000 )   //Print Temp Reading every 1 second while heating up.
-            {
-                Commands::printTemperatures();
-                printedTime = currentTime;
-            }*/
-            Commands::checkForPeriodicalActions(true);
-            GCode::keepAlive(WaitHeater);
-            //gcode_read_serial();
-#if RETRACT_DURING_HEATUP
-            if (actExtruder == Extruder::current && actExtruder->waitRetractUnits > 0 && !retracted && dirRising && actExtruder->tempControl.currentTemperatureC > actExtruder->waitRetractTemperature) {
-                PrintLine::moveRelativeDistanceInSteps(0, 0, 0, -actExtruder->waitRetractUnits * Printer::axisStepsPerMM[E_AXIS], actExtruder->maxFeedrate / 4, false, false);
-                retracted = 1;
-            }
-#endif
-            if(maxWaitUntil == 0) {
-                if(dirRising ? actExtruder->tempControl.currentTemperatureC >= actExtruder->tempControl.targetTemperatureC - 5 : actExtruder->tempControl.currentTemperatureC <= actExtruder->tempControl.targetTemperatureC + 5) {
-                    maxWaitUntil = currentTime + 120000L;
-                }
-            } else if((millis_t)(maxWaitUntil - currentTime) < 2000000000UL) {
-                break;
-            }
-            if((waituntil == 0 &&
-                    (dirRising ? actExtruder->tempControl.currentTemperatureC >= actExtruder->tempControl.targetTemperatureC - 1
-                     : actExtruder->tempControl.currentTemperatureC <= actExtruder->tempControl.targetTemperatureC + 1))
-#if defined(TEMP_HYSTERESIS) && TEMP_HYSTERESIS >= 1
-                    || (waituntil != 0 && (abs(actExtruder->tempControl.currentTemperatureC - actExtruder->tempControl.targetTemperatureC)) > TEMP_HYSTERESIS)
-#endif
-              ) {
-                waituntil = currentTime + 1000UL * (millis_t)actExtruder->watchPeriod; // now wait for temp. to stabilize
-            }
-        } while(waituntil == 0 || (waituntil != 0 && (millis_t)(waituntil - currentTime) < 2000000000UL));
-        Printer::setAutoreportTemp(oldAutoreport);
-#if RETRACT_DURING_HEATUP
-        if (retracted && actExtruder == Extruder::current) {
-            PrintLine::moveRelativeDistanceInSteps(0, 0, 0, actExtruder->waitRetractUnits * Printer::axisStepsPerMM[E_AXIS], actExtruder->maxFeedrate / 4, false, false);
-        }
-#endif
-        EVENT_HEATING_FINISHED(actExtruder->id);
-    }
+    if(wait)
+        waitForExtruderTemperature(extr);
     UI_CLEAR_STATUS;
 
     bool alloff = true;
@@ -996,6 +1291,10 @@ void Extruder::setTemperatureForExtruder(float temperatureInCelsius, uint8_t ext
 #if EEPROM_MODE != 0
     if(alloff && !alloffs) // All heaters are now switched off?
         EEPROM::updatePrinterUsage();
+#endif
+#if TOOLCHANGE_PREHEAT
+    if(alloff && !alloffs && toolchangeSaved > 0)
+        Com::printFLN(PSTR("Tool change preheat saved in job:"), (int32_t)(toolchangeSaved / 1000));
 #endif
     if(alloffs && !alloff) { // heaters are turned on, start measuring printing time
         Printer::msecondsPrinting = HAL::timeInMilliseconds();
@@ -1021,6 +1320,69 @@ void Extruder::setHeatedBedTemperature(float temperatureInCelsius, bool beep) {
     EVENT_SET_BED_TEMP(temperatureInCelsius, beep);
 }
 
+#if PREDICTIVE_HEATUP
+/** Remembers a wait for temperature controller index controller instead of blocking. */
+void Extruder::deferHeatup(fast8_t controller) {
+#if MIXING_EXTRUDER || SHARED_EXTRUDER_HEATER
+    if(controller < NUM_EXTRUDER) controller = 0;
+#endif
+    TemperatureController *tc = tempController[controller];
+    if(tc->targetTemperatureC < 30 || Printer::debugDryrun()) return;
+    if(fabs(tc->targetTemperatureC - tc->currentTemperatureC) <= 1) return;
+    heatupStartTemp[controller] = tc->currentTemperatureC;
+    heatupStartTime[controller] = HAL::timeInMilliseconds();
+    heatupPending |= 1 << controller;
+}
+
+/** Seconds until controller reaches target at the heating rate observed since the wait
+was deferred. Returns -1 as long as no rate is known. */
+float Extruder::estimateHeatupTime(fast8_t controller) {
+    TemperatureController *tc = tempController[controller];
+    float elapsed = (HAL::timeInMilliseconds() - heatupStartTime[controller]) * 0.001f;
+    if(elapsed < 2) return -1;
+    float rate = (tc->currentTemperatureC - heatupStartTemp[controller]) / elapsed;
+    float diff = tc->targetTemperatureC - tc->currentTemperatureC;
+    if(fabs(diff) <= 1) return 0;
+    if(rate * diff <= 0) return -1; // not moving towards target
+    return diff / rate;
+}
+
+/** Blocks until all deferred heaters are in range. Called before the first extruding command. */
+void Extruder::waitForPendingHeatup() {
+    for(fast8_t h = 0; h < NUM_TEMPERATURE_LOOPS; h++) {
+        TemperatureController *tc = tempController[h];
+        if((heatupPending & (1 << h)) == 0 || tc->targetTemperatureC < 30) continue; // switched off meanwhile
+        millis_t start = HAL::timeInMilliseconds();
+        Com::printF(PSTR("Heat-up overlapped:"), (int32_t)((start - heatupStartTime[h]) / 1000));
+        float eta = estimateHeatupTime(h);
+        if(eta > 0)
+            Com::printF(PSTR(" s remaining est.:"), eta, 0);
+        Com::printFLN(PSTR(" s"));
+#if HAVE_HEATED_BED
+        if(h == HEATED_BED_INDEX) {
+            UI_STATUS_UPD_F(Com::translatedF(UI_TEXT_HEATING_BED_ID));
+        } else
+#endif
+        {
+            UI_STATUS_UPD_F(Com::translatedF(UI_TEXT_HEATING_EXTRUDER_ID));
+        }
+#if NUM_EXTRUDER > 0
+        if(h < NUM_EXTRUDER)
+            waitForExtruderTemperature(h); // same as M109
+        else
+#endif
+        {
+            EVENT_WAITING_HEATER(-1);
+            tc->waitForTargetTemperature();
+            EVENT_HEATING_FINISHED(-1);
+        }
+        Com::printFLN(PSTR("Heat-up waited:"), (int32_t)((HAL::timeInMilliseconds() - start) / 1000));
+        UI_CLEAR_STATUS;
+    }
+    heatupPending = 0;
+}
+#endif
+
 float Extruder::getHeatedBedTemperature() {
 #if HAVE_HEATED_BED
     TemperatureController *c = tempController[HEATED_BED_INDEX];
@@ -1032,18 +1394,13 @@ float Extruder::getHeatedBedTemperature() {
 
 #if MIXING_EXTRUDER > 0
 void Extruder::setMixingWeight(uint8_t extr, int weight) {
-    uint8_t i;
-    mixingS = 0;
     extruder[extr].mixingW = weight;
-    float sum = 0;
-    for(fast8_t i = 0; i < NUM_EXTRUDER; i++) {
-        sum += extruder[i].stepsPerMM * extruder[i].mixingW;                   // steps of virtual axis with original weights
-    }
-    for(i = 0; i < NUM_EXTRUDER; i++) {
-        extruder[i].mixingWB = static_cast<int>(10000.0 * extruder[i].stepsPerMM * extruder[i].mixingW / sum);
-        extruder[i].mixingE = extruder[i].mixingWB;
-        mixingS += extruder[i].mixingWB;
-    }
+    int total = balanceMixingWeights(extruder, NUM_EXTRUDER);
+#if !MIXING_GRADIENT // with gradients the stepper activates the weights with each move
+    for(uint8_t i = 0; i < NUM_EXTRUDER; i++)
+        extruder[i].mixingE = mixingWA[i] = extruder[i].mixingWB;
+    mixingS = total;
+#endif
 }
 void Extruder::step() {
     if(PrintLine::cur != NULL && PrintLine::cur->isAllEMotors()) {
@@ -1103,33 +1460,8 @@ void Extruder::step() {
 #endif
         return;
     }
-    uint8_t best = 255, i;
-    int bestError;
-    if(mixingDir) {
-        bestError = -20000;
-        for(i = 0; i < NUM_EXTRUDER; i++) {
-            if(extruder[i].mixingWB == 0) continue;
-            if(extruder[i].mixingE > bestError) {
-                bestError = extruder[i].mixingE;
-                best = i;
-            }
-            extruder[i].mixingE += extruder[i].mixingWB;
-        }
-        if(best == 255) return; // no extruder has weight!
-        extruder[best].mixingE -= mixingS;
-    } else {
-        bestError = 20000;
-        for(i = 0; i < NUM_EXTRUDER; i++) {
-            if(extruder[i].mixingWB == 0) continue;
-            if(extruder[i].mixingE < bestError) {
-                bestError = extruder[i].mixingE;
-                best = i;
-            }
-            extruder[i].mixingE -= extruder[i].mixingWB;
-        }
-        if(best == 255) return; // no extruder has weight!
-        extruder[best].mixingE += mixingS;
-    }
+    uint8_t best = mixingStepExtruder(extruder, mixingWA, mixingS, NUM_EXTRUDER, mixingDir);
+    if(best == 255) return; // no extruder has weight!
 #if NUM_EXTRUDER > 0
     if(best == 0) {
         WRITE(EXT0_STEP_PIN, START_STEP_WITH_HIGH);
@@ -1938,152 +2270,8 @@ void Extruder::disableAllExtruderMotors() {
     WRITE(EXT5_ENABLE2_PIN, !EXT5_ENABLE_ON);
 #endif
 }
-#define NUMTEMPS_1 28
-// Epcos B57560G0107F000
-const short temptable_1[NUMTEMPS_1][2] PROGMEM = {
-    {0, 4000}, {92, 2400}, {105, 2320}, {121, 2240}, {140, 2160}, {162, 2080}, {189, 2000}, {222, 1920}, {261, 1840}, {308, 1760},
-    {365, 1680}, {434, 1600}, {519, 1520}, {621, 1440}, {744, 1360}, {891, 1280}, {1067, 1200}, {1272, 1120},
-    {1771, 960}, {2357, 800}, {2943, 640}, {3429, 480}, {3760, 320}, {3869, 240}, {3912, 200}, {3948, 160}, {4077, -160}, {4094, -440}
-};
-#define NUMTEMPS_2 21
-const short temptable_2[NUMTEMPS_2][2] PROGMEM = {
-    {1 * 4, 848 * 8}, {54 * 4, 275 * 8}, {107 * 4, 228 * 8}, {160 * 4, 202 * 8}, {213 * 4, 185 * 8}, {266 * 4, 171 * 8}, {319 * 4, 160 * 8}, {372 * 4, 150 * 8},
-    {425 * 4, 141 * 8}, {478 * 4, 133 * 8}, {531 * 4, 125 * 8}, {584 * 4, 118 * 8}, {637 * 4, 110 * 8}, {690 * 4, 103 * 8}, {743 * 4, 95 * 8}, {796 * 4, 86 * 8},
-    {849 * 4, 77 * 8}, {902 * 4, 65 * 8}, {955 * 4, 49 * 8}, {1008 * 4, 17 * 8}, {1020 * 4, 0 * 8} //safety
-};
 
-#define NUMTEMPS_3 28
-const short temptable_3[NUMTEMPS_3][2] PROGMEM = {
-    {1 * 4, 864 * 8}, {21 * 4, 300 * 8}, {25 * 4, 290 * 8}, {29 * 4, 280 * 8}, {33 * 4, 270 * 8}, {39 * 4, 260 * 8}, {46 * 4, 250 * 8}, {54 * 4, 240 * 8}, {64 * 4, 230 * 8}, {75 * 4, 220 * 8},
-    {90 * 4, 210 * 8}, {107 * 4, 200 * 8}, {128 * 4, 190 * 8}, {154 * 4, 180 * 8}, {184 * 4, 170 * 8}, {221 * 4, 160 * 8}, {265 * 4, 150 * 8}, {316 * 4, 140 * 8}, {375 * 4, 130 * 8},
-    {441 * 4, 120 * 8}, {513 * 4, 110 * 8}, {588 * 4, 100 * 8}, {734 * 4, 80 * 8}, {856 * 4, 60 * 8}, {938 * 4, 40 * 8}, {986 * 4, 20 * 8}, {1008 * 4, 0 * 8}, {1018 * 4, -20 * 8}
-};
-
-#define NUMTEMPS_4 20
-const short temptable_4[NUMTEMPS_4][2] PROGMEM = {
-    {1 * 4, 430 * 8}, {54 * 4, 137 * 8}, {107 * 4, 107 * 8}, {160 * 4, 91 * 8}, {213 * 4, 80 * 8}, {266 * 4, 71 * 8}, {319 * 4, 64 * 8}, {372 * 4, 57 * 8}, {425 * 4, 51 * 8},
-    {478 * 4, 46 * 8}, {531 * 4, 41 * 8}, {584 * 4, 35 * 8}, {637 * 4, 30 * 8}, {690 * 4, 25 * 8}, {743 * 4, 20 * 8}, {796 * 4, 14 * 8}, {849 * 4, 7 * 8}, {902 * 4, 0 * 8},
-    {955 * 4, -11 * 8}, {1008 * 4, -35 * 8}
-};
-// ATC 104GT
-#define NUMTEMPS_8 34
-const short temptable_8[NUMTEMPS_8][2] PROGMEM = {
-    {0, 8000}, {69, 2400}, {79, 2320}, {92, 2240}, {107, 2160}, {125, 2080}, {146, 2000}, {172, 1920}, {204, 1840}, {244, 1760}, {291, 1680}, {350, 1600},
-    {422, 1520}, {511, 1440}, {621, 1360}, {755, 1280}, {918, 1200}, {1114, 1120}, {1344, 1040}, {1608, 960}, {1902, 880}, {2216, 800}, {2539, 720},
-    {2851, 640}, {3137, 560}, {3385, 480}, {3588, 400}, {3746, 320}, {3863, 240}, {3945, 160}, {4002, 80}, {4038, 0}, {4061, -80}, {4075, -160}
-};
-#define NUMTEMPS_9 67 // 100k Honeywell 135-104LAG-J01
-const short temptable_9[NUMTEMPS_9][2] PROGMEM = {
-    {1 * 4, 941 * 8}, {19 * 4, 362 * 8}, {37 * 4, 299 * 8}, //top rating 300C
-    {55 * 4, 266 * 8}, {73 * 4, 245 * 8}, {91 * 4, 229 * 8}, {109 * 4, 216 * 8}, {127 * 4, 206 * 8}, {145 * 4, 197 * 8}, {163 * 4, 190 * 8}, {181 * 4, 183 * 8}, {199 * 4, 177 * 8},
-    {217 * 4, 171 * 8}, {235 * 4, 166 * 8}, {253 * 4, 162 * 8}, {271 * 4, 157 * 8}, {289 * 4, 153 * 8}, {307 * 4, 149 * 8}, {325 * 4, 146 * 8}, {343 * 4, 142 * 8}, {361 * 4, 139 * 8},
-    {379 * 4, 135 * 8}, {397 * 4, 132 * 8}, {415 * 4, 129 * 8}, {433 * 4, 126 * 8}, {451 * 4, 123 * 8}, {469 * 4, 121 * 8}, {487 * 4, 118 * 8}, {505 * 4, 115 * 8}, {523 * 4, 112 * 8},
-    {541 * 4, 110 * 8}, {559 * 4, 107 * 8}, {577 * 4, 105 * 8}, {595 * 4, 102 * 8}, {613 * 4, 99 * 8}, {631 * 4, 97 * 8}, {649 * 4, 94 * 8}, {667 * 4, 92 * 8}, {685 * 4, 89 * 8},
-    {703 * 4, 86 * 8}, {721 * 4, 84 * 8}, {739 * 4, 81 * 8}, {757 * 4, 78 * 8}, {775 * 4, 75 * 8}, {793 * 4, 72 * 8}, {811 * 4, 69 * 8}, {829 * 4, 66 * 8}, {847 * 4, 62 * 8},
-    {865 * 4, 59 * 8}, {883 * 4, 55 * 8}, {901 * 4, 51 * 8}, {919 * 4, 46 * 8}, {937 * 4, 41 * 8},
-    {955 * 4, 35 * 8}, {973 * 4, 27 * 8}, {991 * 4, 17 * 8}, {1009 * 4, 1 * 8}, {1023 * 4, 0} //to allow internal 0 degrees C
-};
-#define NUMTEMPS_10 20 // 100k 0603 SMD Vishay NTCS0603E3104FXT (4.7k pullup)
-const short temptable_10[NUMTEMPS_10][2] PROGMEM = {
-    {1 * 4, 704 * 8}, {54 * 4, 216 * 8}, {107 * 4, 175 * 8}, {160 * 4, 152 * 8}, {213 * 4, 137 * 8}, {266 * 4, 125 * 8}, {319 * 4, 115 * 8}, {372 * 4, 106 * 8}, {425 * 4, 99 * 8},
-    {478 * 4, 91 * 8}, {531 * 4, 85 * 8}, {584 * 4, 78 * 8}, {637 * 4, 71 * 8}, {690 * 4, 65 * 8}, {743 * 4, 58 * 8}, {796 * 4, 50 * 8}, {849 * 4, 42 * 8}, {902 * 4, 31 * 8},
-    {955 * 4, 17 * 8}, {1008 * 4, 0}
-};
-#define NUMTEMPS_11 31 // 100k GE Sensing AL03006-58.2K-97-G1 (4.7k pullup)
-const short temptable_11[NUMTEMPS_11][2] PROGMEM = {
-    {1 * 4, 936 * 8}, {36 * 4, 300 * 8}, {71 * 4, 246 * 8}, {106 * 4, 218 * 8}, {141 * 4, 199 * 8}, {176 * 4, 185 * 8}, {211 * 4, 173 * 8}, {246 * 4, 163 * 8}, {281 * 4, 155 * 8},
-    {316 * 4, 147 * 8}, {351 * 4, 140 * 8}, {386 * 4, 134 * 8}, {421 * 4, 128 * 8}, {456 * 4, 122 * 8}, {491 * 4, 117 * 8}, {526 * 4, 112 * 8}, {561 * 4, 107 * 8}, {596 * 4, 102 * 8},
-    {631 * 4, 97 * 8}, {666 * 4, 92 * 8}, {701 * 4, 87 * 8}, {736 * 4, 81 * 8}, {771 * 4, 76 * 8}, {806 * 4, 70 * 8}, {841 * 4, 63 * 8}, {876 * 4, 56 * 8}, {911 * 4, 48 * 8},
-    {946 * 4, 38 * 8}, {981 * 4, 23 * 8}, {1005 * 4, 5 * 8}, {1016 * 4, 0}
-};
-#define NUMTEMPS_12 31 // 100k RS thermistor 198-961 (4.7k pullup)
-const short temptable_12[NUMTEMPS_12][2] PROGMEM = {
-    {1 * 4, 929 * 8}, {36 * 4, 299 * 8}, {71 * 4, 246 * 8}, {106 * 4, 217 * 8}, {141 * 4, 198 * 8}, {176 * 4, 184 * 8}, {211 * 4, 173 * 8}, {246 * 4, 163 * 8}, {281 * 4, 154 * 8}, {316 * 4, 147 * 8},
-    {351 * 4, 140 * 8}, {386 * 4, 134 * 8}, {421 * 4, 128 * 8}, {456 * 4, 122 * 8}, {491 * 4, 117 * 8}, {526 * 4, 112 * 8}, {561 * 4, 107 * 8}, {596 * 4, 102 * 8}, {631 * 4, 97 * 8}, {666 * 4, 91 * 8},
-    {701 * 4, 86 * 8}, {736 * 4, 81 * 8}, {771 * 4, 76 * 8}, {806 * 4, 70 * 8}, {841 * 4, 63 * 8}, {876 * 4, 56 * 8}, {911 * 4, 48 * 8}, {946 * 4, 38 * 8}, {981 * 4, 23 * 8}, {1005 * 4, 5 * 8}, {1016 * 4, 0 * 8}
-};
-#if CPU_ARCH == ARCH_AVR
-#define NUMTEMPS_13 19
-const short temptable_13[NUMTEMPS_13][2] PROGMEM = {
-    {0, 0}, {908, 8}, {942, 10 * 8}, {982, 20 * 8}, {1015, 8 * 30}, {1048, 8 * 40}, {1080, 8 * 50}, {1113, 8 * 60}, {1146, 8 * 70}, {1178, 8 * 80}, {1211, 8 * 90}, {1276, 8 * 110}, {1318, 8 * 120}
-    , {1670, 8 * 230}, {2455, 8 * 500}, {3445, 8 * 900}, {3666, 8 * 1000}, {3871, 8 * 1100}, {4095, 8 * 2000}
-};
-#else
-#define NUMTEMPS_13 9
-const short temptable_13[NUMTEMPS_13][2] PROGMEM = {
-    {0, 0}, {1365, 8}, {1427, 10 * 8}, {1489, 20 * 8}, {2532, 8 * 230}, {2842, 8 * 300}, {3301, 8 * 400}, {3723, 8 * 500}, {4095, 8 * 600}
-};
-#endif
-#define NUMTEMPS_14 46
-const short temptable_14[NUMTEMPS_14][2] PROGMEM = {
-    {1 * 4, 8 * 938}, {31 * 4, 8 * 314}, {41 * 4, 8 * 290}, {51 * 4, 8 * 272}, {61 * 4, 8 * 258}, {71 * 4, 8 * 247}, {81 * 4, 8 * 237}, {91 * 4, 8 * 229}, {101 * 4, 8 * 221}, {111 * 4, 8 * 215}, {121 * 4, 8 * 209},
-    {131 * 4, 8 * 204}, {141 * 4, 8 * 199}, {151 * 4, 8 * 195}, {161 * 4, 8 * 190}, {171 * 4, 8 * 187}, {181 * 4, 8 * 183}, {191 * 4, 8 * 179}, {201 * 4, 8 * 176}, {221 * 4, 8 * 170}, {241 * 4, 8 * 165},
-    {261 * 4, 8 * 160}, {281 * 4, 8 * 155}, {301 * 4, 8 * 150}, {331 * 4, 8 * 144}, {361 * 4, 8 * 139}, {391 * 4, 8 * 133}, {421 * 4, 8 * 128}, {451 * 4, 8 * 123}, {491 * 4, 8 * 117}, {531 * 4, 8 * 111},
-    {571 * 4, 8 * 105}, {611 * 4, 8 * 100}, {681 * 4, 8 * 90}, {711 * 4, 8 * 85}, {811 * 4, 8 * 69}, {831 * 4, 8 * 65}, {881 * 4, 8 * 55},
-    {901 * 4, 8 * 51},  {941 * 4, 8 * 39}, {971 * 4, 8 * 28}, {981 * 4, 8 * 23}, {991 * 4, 8 * 17}, {1001 * 4, 8 * 9}, {1021 * 4, 8 * -27}, {1023 * 4, 8 * -200}
-};
-#define NUMTEMPS_15 27 // DYZE DESIGN 500°C Thermistor
-const short temptable_15[NUMTEMPS_15][2] PROGMEM = {
-    { 18 * 4, 850 * 8 }, { 18 * 4, 500 * 8 }, { 22 * 4, 480 * 8 }, { 27 * 4, 460 * 8 }, { 33 * 4, 440 * 8 }, { 41 * 4, 420 * 8 }, { 52 * 4, 400 * 8 }, { 68 * 4, 380 * 8 }, { 86 * 4, 360 * 8 }, { 112 * 4, 340 * 8 },
-    { 147 * 4, 320 * 8 }, { 194 * 4, 300 * 8 }, { 254 * 4, 280 * 8 }, { 330 * 4, 260 * 8 }, { 428 * 4, 240 * 8 }, { 533 * 4, 220 * 8 }, { 646 * 4, 200 * 8 }, { 754 * 4, 180 * 8 }, { 844 * 4, 160 * 8 },
-    { 912 * 4, 140 * 8 }, { 959 * 4, 120 * 8 }, { 989 * 4, 100 * 8 }, { 1007 * 4, 80 * 8 }, { 1016 * 4, 60 * 8 }, { 1021 * 4, 30 * 8 }, { 4091, 25 * 8 }, { 4092, 20 * 8 }
-};
-// Contributed by Brandon Coates - May 2015
-// B3 Innovations Pico 500c Thermistor
-// B150/250 = 5300 K +/- 3%
-// R 250 = 2.705k Ohms +/- 2.5%
-#define NUMTEMPS_16 49
-const short temptable_16[NUMTEMPS_16][2] PROGMEM = {
-    {  37,  510 * 8 },
-    {  44,  500 * 8 },
-    {  51,  490 * 8 },
-    {  58,  480 * 8 },
-    {  67,  470 * 8 },
-    {  77,  460 * 8 },
-    {  88,  450 * 8 },
-    {  99,  440 * 8 },
-    {  112,  430 * 8 },
-    {  126,  420 * 8 },
-    {  144,  410 * 8 },
-    {  163,  400 * 8 },
-    {  185,  390 * 8 },
-    {  210,  380 * 8 },
-    {  240,  370 * 8 },
-    {  273,  360 * 8 },
-    {  311,  350 * 8 },
-    {  355,  340 * 8 },
-    {  408,  330 * 8 },
-    {  470,  320 * 8 },
-    {  542,  310 * 8 },
-    {  623,  300 * 8 },
-    {  720,  290 * 8 },
-    {  832,  280 * 8 },
-    {  961,  270 * 8 },
-    {  1108,  260 * 8 },
-    {  1276,  250 * 8 },
-    {  1463,  240 * 8 },
-    {  1676,  230 * 8 },
-    {  1896,  220 * 8 },
-    {  2133,  210 * 8 },
-    {  2382,  200 * 8 },
-    {  2635,  190 * 8 },
-    {  2866,  180 * 8 },
-    {  3092,  170 * 8 },
-    {  3288,  160 * 8 },
-    {  3468,  150 * 8 },
-    {  3608,  140 * 8 },
-    {  3727,  130 * 8 },
-    {  3824,  120 * 8 },
-    {  3898,  110 * 8 },
-    {  3955,  100 * 8 },
-    {  4029,  80 * 8 },
-    {  4060,  65 * 8 },
-    {  4073,  55 * 8 },
-    {  4082,  45 * 8 },
-    {  4088,  35 * 8 },
-    {  4092,  25 * 8 },
-    {  4095,   0 * 8 },
-};
+#include "ThermistorTables.h"
 #if NUM_TEMPS_USERTHERMISTOR0 > 0
 const short temptable_5[NUM_TEMPS_USERTHERMISTOR0][2] PROGMEM = USER_THERMISTORTABLE0 ;
 #endif
@@ -2184,7 +2372,67 @@ void TemperatureController::updateCurrentTemperature() {
     default:
         currentTemperature = 4095; // unknown method, return high value to switch heater off for safety
     }
-    int currentTemperature = this->currentTemperature;
+#if FAST_TEMPERATURE_LOOKUP
+    if(lookup != NULL) {
+        currentTemperatureC = lookup->convert(currentTemperature) * (1.0f / 16.0f);
+        return;
+    }
+#endif
+    convertTemperature(currentTemperature);
+}
+
+/** Describes the sensor table of table based sensors. Returns false for other sensors
+and for tables that are not defined in the configuration. */
+bool TemperatureController::sensorTable(uint8_t type, SensorTable &st) {
+    st.table = NULL;
+    st.num = 0;
+    st.inverted = true;
+    st.ram = false;
+    if(type == 13 || (type >= 50 && type <= 52)) { // PTC tables
+        type = (type > 49 ? type - 46 : type - 1);
+        st.inverted = false;
+    } else if(type >= 1 && type <= 16)
+        type--;
+#if defined(USE_GENERIC_THERMISTORTABLE_1) || defined(USE_GENERIC_THERMISTORTABLE_2) || defined(USE_GENERIC_THERMISTORTABLE_3)
+    else if(type >= 97 && type <= 99) {
+        st.ram = true;
+        st.num = GENERIC_THERM_NUM_ENTRIES;
+#ifdef USE_GENERIC_THERMISTORTABLE_1
+        if(type == 97)
+            st.table = (const int16_t *)temptable_generic1;
+#endif
+#ifdef USE_GENERIC_THERMISTORTABLE_2
+        if(type == 98)
+            st.table = (const int16_t *)temptable_generic2;
+#endif
+#ifdef USE_GENERIC_THERMISTORTABLE_3
+        if(type == 99)
+            st.table = (const int16_t *)temptable_generic3;
+#endif
+        return st.table != NULL;
+    }
+#endif
+    else
+        return false;
+    st.num = pgm_read_byte(&temptables_num[type]);
+    st.table = (const int16_t *)pgm_read_word(&temptables[type]);
+    return st.table != NULL && st.num > 1;
+}
+
+#if FAST_TEMPERATURE_LOOKUP
+/** Builds the lookup table for table based sensors. Other sensors and tables needing more
+samples than TEMPERATURE_LOOKUP_SAMPLES keep the normal conversion. */
+void TemperatureController::buildLookupTable(TemperatureLookup *table) {
+    lookup = NULL;
+    SensorTable st;
+    if(sensorTable(sensorType, st) && table->build(st))
+        lookup = table;
+}
+#endif
+
+/** Converts the raw sensor value currentTemperature into currentTemperatureC. */
+void TemperatureController::convertTemperature(int currentTemperature) {
+    uint8_t type = sensorType;
     switch(type) {
     case 0:
         currentTemperatureC = 25;
@@ -2201,57 +2449,19 @@ void TemperatureController::updateCurrentTemperature() {
     case 10:
     case 11:
     case 12:
+    case 13:
     case 14:
     case 15:
-    case 16: {
-        type--;
-        uint8_t num = pgm_read_byte(&temptables_num[type]) << 1;
-        uint8_t i = 2;
-        const int16_t *temptable = (const int16_t *)pgm_read_word(&temptables[type]); //pgm_read_word_near(&temptables[type]);
-        int16_t oldraw = pgm_read_word(&temptable[0]);
-        int16_t oldtemp = pgm_read_word(&temptable[1]);
-        int16_t newraw, newtemp = 0;
-        currentTemperature = (1023 << (2 - ANALOG_REDUCE_BITS)) - currentTemperature;
-        while(i < num) {
-            newraw = pgm_read_word(&temptable[i++]);
-            newtemp = pgm_read_word(&temptable[i++]);
-            if (newraw > currentTemperature) {
-                currentTemperatureC = TEMP_INT_TO_FLOAT(oldtemp + (float)(currentTemperature - oldraw) * (float)(newtemp - oldtemp) / (newraw - oldraw));
-                return;
-            }
-            oldtemp = newtemp;
-            oldraw = newraw;
-        }
-        // Overflow: Set to last value in the table
-        currentTemperatureC = TEMP_INT_TO_FLOAT(newtemp);
-    }
-    break;
-    case 13:
+    case 16:
     case 50: // User defined PTC thermistor
     case 51:
-    case 52: {
-        if(type > 49)
-            type -= 46;
-        else
-            type--;
-        uint8_t num = pgm_read_byte(&temptables_num[type]) << 1;
-        uint8_t i = 2;
-        const int16_t *temptable = (const int16_t *)pgm_read_word(&temptables[type]); //pgm_read_word_near(&temptables[type]);
-        int16_t oldraw = pgm_read_word(&temptable[0]);
-        int16_t oldtemp = pgm_read_word(&temptable[1]);
-        int16_t newraw, newtemp = 0;
-        while(i < num) {
-            newraw = pgm_read_word(&temptable[i++]);
-            newtemp = pgm_read_word(&temptable[i++]);
-            if (newraw > currentTemperature) {
-                currentTemperatureC = TEMP_INT_TO_FLOAT(oldtemp + (float)(currentTemperature - oldraw) * (float)(newtemp - oldtemp) / (newraw - oldraw));
-                return;
-            }
-            oldtemp = newtemp;
-            oldraw = newraw;
-        }
-        // Overflow: Set to last value in the table
-        currentTemperatureC = TEMP_INT_TO_FLOAT(newtemp);
+    case 52:
+    case 97: // Generic thermistor tables
+    case 98:
+    case 99: {
+        SensorTable st;
+        if(sensorTable(type, st))
+            currentTemperatureC = TEMP_INT_TO_FLOAT(st.value(currentTemperature));
         break;
     }
     case 60: // AD8495 (Delivers 5mV/degC vs the AD595's 10mV)
@@ -2296,43 +2506,6 @@ void TemperatureController::updateCurrentTemperature() {
     case 102: // MAX31855
         currentTemperatureC = (float)currentTemperature / 4.0;
         break;
-#endif
-#if defined(USE_GENERIC_THERMISTORTABLE_1) || defined(USE_GENERIC_THERMISTORTABLE_2) || defined(USE_GENERIC_THERMISTORTABLE_3)
-    case 97:
-    case 98:
-    case 99: {
-        uint8_t i = 2;
-        const short *temptable;
-#ifdef USE_GENERIC_THERMISTORTABLE_1
-        if(type == 97)
-            temptable = (const short *)temptable_generic1;
-#endif
-#ifdef USE_GENERIC_THERMISTORTABLE_2
-        if(type == 98)
-            temptable = (const short *)temptable_generic2;
-#endif
-#ifdef USE_GENERIC_THERMISTORTABLE_3
-        if(type == 99)
-            temptable = (const short *)temptable_generic3;
-#endif
-        short oldraw = temptable[0];
-        short oldtemp = temptable[1];
-        short newraw, newtemp;
-        currentTemperature = (1023 << (2 - ANALOG_REDUCE_BITS)) - currentTemperature;
-        while(i < GENERIC_THERM_NUM_ENTRIES * 2) {
-            newraw = temptable[i++];
-            newtemp = temptable[i++];
-            if (newraw > currentTemperature) {
-                currentTemperatureC = TEMP_INT_TO_FLOAT(oldtemp + (float)(currentTemperature - oldraw) * (float)(newtemp - oldtemp) / (newraw - oldraw));
-                return;
-            }
-            oldtemp = newtemp;
-            oldraw = newraw;
-        }
-        // Overflow: Set to last value in the table
-        currentTemperatureC = TEMP_INT_TO_FLOAT(newtemp);
-        break;
-    }
 #endif
     }
 }
@@ -2355,6 +2528,44 @@ void Extruder::disableAllHeater() {
     autotuneIndex = 255;
 }
 
+/** \brief Computes PID parameters from ultimate gain Ku and ultimate period Tu in seconds.
+
+method selects the tuning rule: 0 = classic Ziegler-Nichols, 1 = some overshoot, 2 = no overshoot,
+3 = Pessen integral rule, 4 = Tyreus-Lyben.
+*/
+static void autotuneRule(float Ku, float Tu, int method, float &Kp, float &Ki, float &Kd) {
+    if(method == 0) {
+        Kp = 0.6 * Ku;
+        Ki = Kp * 2.0 / Tu;
+        Kd = Kp * Tu * 0.125;
+        Com::printFLN(Com::tAPIDClassic);
+    }
+    if(method == 1) {
+        Kp = 0.33 * Ku;
+        Ki = Kp * 2.0 / Tu;
+        Kd = Kp * Tu / 3.0;
+        Com::printFLN(Com::tAPIDSome);
+    }
+    if(method == 2) {
+        Kp = 0.2 * Ku;
+        Ki = Kp * 2.0 / Tu;
+        Kd = Kp * Tu / 3;
+        Com::printFLN(Com::tAPIDNone);
+    }
+    if(method == 3) {
+        Kp = 0.7 * Ku;
+        Ki = Kp * 2.5 / Tu;
+        Kd = Kp * Tu * 3.0 / 20.0;
+        Com::printFLN(Com::tAPIDPessen);
+    }
+    if(method == 4) { //Tyreus-Lyben
+        Kp = 0.4545f * Ku;    //1/2.2 KRkrit
+        Ki = Kp / Tu / 2.2f;  //2.2 Tkrit
+        Kd = Kp * Tu / 6.3f;  //1/6.3 Tkrit
+        Com::printFLN(Com::tAPIDTyreusLyben);
+    }
+}
+
 void TemperatureController::autotunePID(float temp, uint8_t controllerId, int maxCycles, bool storeValues, int method) {
 	ENSURE_POWER
     if(method < 0) method = 0;
@@ -2428,36 +2639,7 @@ void TemperatureController::autotunePID(float temp, uint8_t controllerId, int ma
                         Tu = static_cast<float>(t_low + t_high) / 1000.0;
                         Com::printF(Com::tAPIDKu, Ku);
                         Com::printFLN(Com::tAPIDTu, Tu);
-                        if(method == 0) {
-                            Kp = 0.6 * Ku;
-                            Ki = Kp * 2.0 / Tu;
-                            Kd = Kp * Tu * 0.125;
-                            Com::printFLN(Com::tAPIDClassic);
-                        }
-                        if(method == 1) {
-                            Kp = 0.33 * Ku;
-                            Ki = Kp * 2.0 / Tu;
-                            Kd = Kp * Tu / 3.0;
-                            Com::printFLN(Com::tAPIDSome);
-                        }
-                        if(method == 2) {
-                            Kp = 0.2 * Ku;
-                            Ki = Kp * 2.0 / Tu;
-                            Kd = Kp * Tu / 3;
-                            Com::printFLN(Com::tAPIDNone);
-                        }
-                        if(method == 3) {
-                            Kp = 0.7 * Ku;
-                            Ki = Kp * 2.5 / Tu;
-                            Kd = Kp * Tu * 3.0 / 20.0;
-                            Com::printFLN(Com::tAPIDPessen);
-                        }
-						if(method == 4) { //Tyreus-Lyben
-						   Kp = 0.4545f*Ku;      //1/2.2 KRkrit
-			               Ki = Kp/Tu/2.2f;        //2.2 Tkrit
-	                       Kd = Kp*Tu/6.3f;      //1/6.3 Tkrit[/code]
-	                       Com::printFLN(Com::tAPIDTyreusLyben);
-						}
+                        autotuneRule(Ku, Tu, method, Kp, Ki, Kd);
                         Com::printFLN(Com::tAPIDKp, Kp);
                         Com::printFLN(Com::tAPIDKi, Ki);
                         Com::printFLN(Com::tAPIDKd, Kd);
@@ -2502,6 +2684,195 @@ void TemperatureController::autotunePID(float temp, uint8_t controllerId, int ma
     } // loop
 }
 
+/** \brief Fast autotune from one heating step and a short cool-down.
+
+Heats with full power from current temperature up to temp, then switches off until the
+temperature dropped again. Each second the rise rate y, power u and temperature above ambient x
+are added to a least squares fit of the first order model y = (gain * u - x) / timeConstant.
+Samples from the first 20% of the step and before the peak after switching off are skipped
+as they are dominated by the dead time. Dead time is the mean of where the tangent at the
+steepest rise crosses the start temperature and the delay from switching off to the peak.
+Fit quality is the coefficient of determination of the rise rates.
+
+The fitted model with dead time is converted into ultimate gain and period, so the
+tuning rules of the relay autotune apply. Method 5 stores the model for HTR_MODEL instead.
+If the heater uses dead time control, the dead time gets stored instead of PID values.
+*/
+void TemperatureController::autotuneStep(float temp, uint8_t controllerId, bool storeValues, int method) {
+    ENSURE_POWER
+    if(method < 0) method = 0;
+#if TEMP_MODEL_CONTROL
+    if(method > 5) method = 5;
+    if(method == 5 && controllerId >= NUM_EXTRUDER) {
+        Com::printErrorFLN(PSTR("Model control is only available for extruders"));
+        return;
+    }
+#else
+    if(method > 4) method = 4;
+#endif
+    updateCurrentTemperature();
+    float startTemp = currentTemperatureC;
+    if(temp - startTemp < 30) {
+        Com::printErrorFLN(PSTR("Step autotune needs a target 30 deg. C above current temperature"));
+        return;
+    }
+    Com::printInfoFLN(Com::tPIDAutotuneStart);
+    autotuneIndex = controllerId;
+    pwm_pos[pwmIndex] = pidMax;
+    if(controllerId < NUM_EXTRUDER) {
+        extruder[controllerId].coolerPWM = extruder[controllerId].coolerSpeed;
+        extruder[0].coolerPWM = extruder[0].coolerSpeed;
+    }
+    millis_t startTime = HAL::timeInMilliseconds();
+    millis_t lastSample = startTime;
+    millis_t offTime = 0;
+    bool heating = true;
+    float lastTemp = startTemp, peakTemp = startTemp;
+    float maxRate = 0, maxRateTime = 0, maxRateTemp = startTemp;
+    float coolingDelay = -1;
+    float coolDrop = RMath::max(3.0f, 0.1f * (temp - startTemp));
+    float sumUU = 0, sumUX = 0, sumXX = 0, sumUY = 0, sumXY = 0, sumY = 0, sumYY = 0;
+    int samples = 0;
+    for(;;) {
+#if FEATURE_WATCHDOG
+        HAL::pingWatchdog();
+#endif // FEATURE_WATCHDOG
+        Commands::checkForPeriodicalActions(true); // update heaters etc.
+        GCode::keepAlive(WaitHeater);
+        updateCurrentTemperature();
+        millis_t time = HAL::timeInMilliseconds();
+        if(time - lastSample >= 1000) {
+            float rate = (currentTemperatureC - lastTemp) * 1000.0f / static_cast<float>(time - lastSample);
+            float mid = 0.5f * (currentTemperatureC + lastTemp);
+            float u = 0;
+            bool use;
+            if(heating) {
+                if(rate > maxRate) {
+                    maxRate = rate;
+                    maxRateTime = static_cast<float>((time + lastSample) / 2 - startTime) * 0.001f;
+                    maxRateTemp = mid;
+                }
+                u = pidMax;
+                use = mid > startTemp + 0.2f * (temp - startTemp);
+            } else {
+                if(coolingDelay < 0 && rate <= 0)
+                    coolingDelay = static_cast<float>((time + lastSample) / 2 - offTime) * 0.001f;
+                use = coolingDelay >= 0;
+            }
+            if(use) {
+                float x = mid - TEMP_MODEL_AMBIENT;
+                sumUU += u * u;
+                sumUX += u * x;
+                sumXX += x * x;
+                sumUY += u * rate;
+                sumXY += x * rate;
+                sumY += rate;
+                sumYY += rate * rate;
+                samples++;
+            }
+            lastSample = time;
+            lastTemp = currentTemperatureC;
+            Commands::printTemperatures();
+        }
+        if(heating) {
+            if(currentTemperatureC >= temp) { // switch heating -> off
+                heating = false;
+                pwm_pos[pwmIndex] = 0;
+                offTime = time;
+            }
+        } else {
+            peakTemp = RMath::max(peakTemp, currentTemperatureC);
+            if(coolingDelay >= 0 && currentTemperatureC < peakTemp - coolDrop)
+                break;
+        }
+        if(currentTemperatureC > temp + 40) {
+            pwm_pos[pwmIndex] = 0;
+            Com::printErrorFLN(Com::tAPIDFailedHigh);
+            autotuneIndex = 255;
+            return;
+        }
+        if(time - startTime > 20L * 60L * 1000L) { // 20 Minutes
+            pwm_pos[pwmIndex] = 0;
+            Com::printErrorFLN(Com::tAPIDFailedTimeout);
+            autotuneIndex = 255;
+            return;
+        }
+        UI_MEDIUM;
+        UI_SLOW(true);
+    }
+    autotuneIndex = 255;
+    // Solve normal equations of rate = a * u + b * x with a = gain / timeConstant, b = -1 / timeConstant
+    float det = sumUU * sumXX - sumUX * sumUX;
+    float a = 0, b = 0;
+    if(samples > 4 && det > 0) {
+        a = (sumUY * sumXX - sumXY * sumUX) / det;
+        b = (sumUU * sumXY - sumUX * sumUY) / det;
+    }
+    if(a <= 0 || b >= 0 || maxRate <= 0) {
+        Com::printErrorFLN(PSTR("Step autotune failed, temperature curve does not fit a first order model"));
+        return;
+    }
+    float residual = sumYY - 2.0f * (a * sumUY + b * sumXY) + a * a * sumUU + 2.0f * a * b * sumUX + b * b * sumXX;
+    float total = sumYY - sumY * sumY / samples;
+    float quality = (total > 0 ? 1.0f - residual / total : 0);
+    float timeConstant = -1.0f / b;
+    float gain = a * timeConstant;
+    float dead = maxRateTime - (maxRateTemp - startTemp) / maxRate;
+    if(coolingDelay > 0)
+        dead = (dead > 0 ? 0.5f * (dead + coolingDelay) : coolingDelay);
+    if(dead < 0.5f) dead = 0.5f;
+    Com::printInfoFLN(Com::tAPIDFinished);
+    Com::printFLN(PSTR("Model gain:"), gain, 4);
+    Com::printFLN(PSTR("Model time constant:"), timeConstant);
+    Com::printFLN(PSTR("Model dead time:"), dead);
+    Com::printFLN(PSTR("Fit quality R2:"), quality, 3);
+    // Frequency with 180 deg. phase lag: atan(w * timeConstant) + w * dead = pi
+    float wLow = 0, wHigh = 3.14159f / dead;
+    for(uint8_t i = 0; i < 30; i++) {
+        float w = 0.5f * (wLow + wHigh);
+        if(atan(w * timeConstant) + w * dead > 3.14159f)
+            wHigh = w;
+        else
+            wLow = w;
+    }
+    float w = 0.5f * (wLow + wHigh);
+    float Ku = sqrt(1.0f + RMath::sqr(w * timeConstant)) / gain;
+    float Tu = 2.0f * 3.14159f / w;
+    float Kp = 0, Ki = 0, Kd = 0;
+    Com::printF(Com::tAPIDKu, Ku);
+    Com::printFLN(Com::tAPIDTu, Tu);
+    if(method < 5) {
+        autotuneRule(Ku, Tu, method, Kp, Ki, Kd);
+        Com::printFLN(Com::tAPIDKp, Kp);
+        Com::printFLN(Com::tAPIDKi, Ki);
+        Com::printFLN(Com::tAPIDKd, Kd);
+    }
+    if(!storeValues)
+        return;
+    if(quality < 0.8f) { // noisy sensor or heater not first order, do not trust the result
+        Com::printErrorFLN(PSTR("Fit quality too low, values not stored"));
+        return;
+    }
+#if TEMP_MODEL_CONTROL
+    if(method == 5) {
+        model.gain = gain;
+        model.timeConstant = timeConstant;
+        model.dead = dead;
+        heatManager = HTR_MODEL;
+    } else
+#endif
+        if(heatManager == HTR_DEADTIME) {
+            deadTime = dead;
+        } else {
+            pidPGain = Kp;
+            pidIGain = Ki;
+            pidDGain = Kd;
+            heatManager = HTR_PID;
+        }
+    updateTempControlVars();
+    EEPROM::storeDataIntoEEPROM();
+}
+
 /** \brief Writes monitored temperatures.
 
 This function is called every 250ms to write the monitored temperature. If monitoring is
@@ -2613,6 +2984,82 @@ int16_t read_max31855(uint8_t ss_pin, fast8_t idx) {
 #endif
 
 #if FEATURE_RETRACTION
+#if RETRACT_ON_TRAVEL
+int32_t Extruder::retractPendingSteps = 0;
+bool Extruder::travelTailPending = false;
+static float retractTravelLength; // mm retracted by the pending/last merged retraction
+static int32_t travelTailTarget[Z_AXIS_ARRAY];
+static float travelTailFeedrate;
+
+/** Queues a travel part to target. The extruder moves by eSteps without changing the logical e position. */
+static void queueTravelPart(int32_t *target, int32_t eSteps, float feedrate) {
+    float oldFeedrate = Printer::feedrate;
+    int32_t oldEPos = Printer::currentPositionSteps[E_AXIS];
+    for(fast8_t i = 0; i < Z_AXIS_ARRAY; i++)
+        Printer::destinationSteps[i] = target[i];
+    Printer::destinationSteps[E_AXIS] = oldEPos + eSteps;
+    Printer::feedrate = feedrate;
+    PrintLine::queueCartesianMove(ALWAYS_CHECK_ENDSTOPS, true);
+    Printer::currentPositionSteps[E_AXIS] = Printer::destinationSteps[E_AXIS] = oldEPos;
+    Printer::feedrate = oldFeedrate;
+}
+
+/** Travel move to destinationSteps while retracted. A pending retraction
+is done over the first part. The last part is held back so a following
+unretract can be merged into it. */
+void Extruder::queueRetractTravel() {
+    int32_t start[Z_AXIS_ARRAY], part[Z_AXIS_ARRAY];
+    float length = 0;
+    for(fast8_t i = 0; i < Z_AXIS_ARRAY; i++) {
+        start[i] = Printer::currentPositionSteps[i];
+        travelTailTarget[i] = Printer::destinationSteps[i];
+        float d = (travelTailTarget[i] - start[i]) * Printer::invAxisStepsPerMM[i];
+        length += d * d;
+    }
+    length = sqrt(length);
+    if(length < 0.01 || (retractPendingSteps == 0 && EEPROM_FLOAT(RETRACTION_Z_LIFT) != 0)) {
+        flushRetractTravel();
+        PrintLine::queueCartesianMove(ALWAYS_CHECK_ENDSTOPS, true);
+        return;
+    }
+    // Ramps long enough to keep the extruder below retraction speeds
+    float retractRamp = 0;
+    if(retractPendingSteps != 0)
+        retractRamp = RMath::max(static_cast<float>(RETRACT_TRAVEL_RAMP), Printer::feedrate * retractTravelLength / RMath::max(EEPROM_FLOAT(RETRACTION_SPEED), 1.f));
+    float undoRamp = RMath::max(static_cast<float>(RETRACT_TRAVEL_RAMP), Printer::feedrate * retractTravelLength / RMath::max(EEPROM_FLOAT(RETRACTION_UNDO_SPEED), 1.f));
+    if(retractRamp + undoRamp > length) {
+        float scale = length / (retractRamp + undoRamp);
+        retractRamp *= scale;
+        undoRamp *= scale;
+    }
+    if(retractPendingSteps != 0) {
+        float f = retractRamp / length;
+        for(fast8_t i = 0; i < Z_AXIS_ARRAY; i++)
+            part[i] = start[i] + static_cast<int32_t>((travelTailTarget[i] - start[i]) * f);
+        queueTravelPart(part, -retractPendingSteps, Printer::feedrate);
+        retractPendingSteps = 0;
+    }
+    float f = 1.0f - undoRamp / length;
+    for(fast8_t i = 0; i < Z_AXIS_ARRAY; i++)
+        part[i] = start[i] + static_cast<int32_t>((travelTailTarget[i] - start[i]) * f);
+    queueTravelPart(part, 0, Printer::feedrate);
+    travelTailFeedrate = Printer::feedrate;
+    travelTailPending = true;
+}
+
+/** Executes held back retraction moves without merging. */
+void Extruder::flushRetractTravel() {
+    if(retractPendingSteps != 0) {
+        retractPendingSteps = 0;
+        current->retractDistance(retractTravelLength);
+    }
+    if(travelTailPending) {
+        travelTailPending = false;
+        queueTravelPart(travelTailTarget, 0, travelTailFeedrate);
+    }
+}
+#endif
+
 void Extruder::retractDistance(float dist, bool extraLength) {
     float oldFeedrate = Printer::feedrate;
     int32_t distance = static_cast<int32_t>(dist * stepsPerMM / Printer::extrusionFactor);
@@ -2636,6 +3083,30 @@ void Extruder::retract(bool isRetract, bool isLong) {
     float distance = (isLong ? EEPROM_FLOAT( RETRACTION_LONG_LENGTH) : EEPROM_FLOAT(RETRACTION_LENGTH));
     float zLiftF = EEPROM_FLOAT(RETRACTION_Z_LIFT);
     int32_t zlift = static_cast<int32_t>(zLiftF * Printer::axisStepsPerMM[Z_AXIS]);
+#if RETRACT_ON_TRAVEL
+    if(zlift == 0) {
+        if(isRetract && !isRetracted()) { // executed by the next travel move
+            retractTravelLength = distance;
+            retractPendingSteps = static_cast<int32_t>(distance * stepsPerMM / Printer::extrusionFactor);
+            setRetracted(true);
+        } else if(!isRetract && isRetracted()) {
+            float extra = isLong ? EEPROM_FLOAT(RETRACTION_UNDO_EXTRA_LONG_LENGTH) : EEPROM_FLOAT(RETRACTION_UNDO_EXTRA_LENGTH);
+            if(retractPendingSteps != 0) { // never retracted, only extra length is missing
+                retractPendingSteps = 0;
+                if(extra != 0)
+                    retractDistance(-extra);
+            } else if(travelTailPending) {
+                queueTravelPart(travelTailTarget, static_cast<int32_t>((distance + extra) * stepsPerMM / Printer::extrusionFactor), travelTailFeedrate);
+                travelTailPending = false;
+            } else
+                retractDistance(-distance - extra);
+            setRetracted(false);
+        }
+        Printer::feedrate = oldFeedrate;
+        return;
+    }
+    flushRetractTravel();
+#endif
     if(isRetract && !isRetracted()) {
 #ifdef EARLY_ZLIFT
         if(zlift > 0) {
@@ -2717,10 +3188,19 @@ Extruder extruder[NUM_EXTRUDER] = {
             0, EXT0_TEMPSENSOR_TYPE, EXT0_SENSOR_INDEX, EXT0_HEAT_MANAGER, 0, 0, 0, 0, 0, 0
             , 0, EXT0_PID_INTEGRAL_DRIVE_MAX, EXT0_PID_INTEGRAL_DRIVE_MIN, EXT0_PID_PGAIN_OR_DEAD_TIME, EXT0_PID_I, EXT0_PID_D, EXT0_PID_MAX, 0, 0
             , 0, 0, 0, EXT0_DECOUPLE_TEST_PERIOD, 0, EXT0_PREHEAT_TEMP
+#if FAST_TEMPERATURE_LOOKUP
+            , NULL
+#endif
+#if TEMP_MODEL_CONTROL
+            , {TEMP_MODEL_GAIN, TEMP_MODEL_TIME_CONSTANT, TEMP_MODEL_DEAD_TIME, TEMP_MODEL_FEED_FORWARD}
+#endif
         }
         , ext0_select_cmd, ext0_deselect_cmd, EXT0_EXTRUDER_COOLER_SPEED, 0, 0, 0
 #if EXTRUDER_JAM_CONTROL
         , 0, 0, 10, 0, 0, JAM_SLOWDOWN_STEPS, JAM_ERROR_STEPS, JAM_SLOWDOWN_TO
+#endif
+#if VOLUMETRIC_FLOW_LIMIT
+        , EXT0_MAX_VOLUMETRIC_FLOW
 #endif
     }
 #endif
@@ -2742,10 +3222,19 @@ Extruder extruder[NUM_EXTRUDER] = {
             1, EXT1_TEMPSENSOR_TYPE, EXT1_SENSOR_INDEX, EXT1_HEAT_MANAGER, 0, 0, 0, 0, 0, 0
             , 0, EXT1_PID_INTEGRAL_DRIVE_MAX, EXT1_PID_INTEGRAL_DRIVE_MIN, EXT1_PID_PGAIN_OR_DEAD_TIME, EXT1_PID_I, EXT1_PID_D, EXT1_PID_MAX, 0, 0
             , 0, 0, 0, EXT1_DECOUPLE_TEST_PERIOD, 0, EXT1_PREHEAT_TEMP
+#if FAST_TEMPERATURE_LOOKUP
+            , NULL
+#endif
+#if TEMP_MODEL_CONTROL
+            , {TEMP_MODEL_GAIN, TEMP_MODEL_TIME_CONSTANT, TEMP_MODEL_DEAD_TIME, TEMP_MODEL_FEED_FORWARD}
+#endif
         }
         , ext1_select_cmd, ext1_deselect_cmd, EXT1_EXTRUDER_COOLER_SPEED, 0, 0, 0
 #if EXTRUDER_JAM_CONTROL
         , 0, 0, 10, 0, 0, JAM_SLOWDOWN_STEPS, JAM_ERROR_STEPS, JAM_SLOWDOWN_TO
+#endif
+#if VOLUMETRIC_FLOW_LIMIT
+        , EXT1_MAX_VOLUMETRIC_FLOW
 #endif
     }
 #endif
@@ -2767,10 +3256,19 @@ Extruder extruder[NUM_EXTRUDER] = {
             2, EXT2_TEMPSENSOR_TYPE, EXT2_SENSOR_INDEX, EXT2_HEAT_MANAGER, 0, 0, 0, 0, 0, 0
             , 0, EXT2_PID_INTEGRAL_DRIVE_MAX, EXT2_PID_INTEGRAL_DRIVE_MIN, EXT2_PID_PGAIN_OR_DEAD_TIME, EXT2_PID_I, EXT2_PID_D, EXT2_PID_MAX, 0, 0
             , 0, 0, 0, EXT2_DECOUPLE_TEST_PERIOD, 0, EXT2_PREHEAT_TEMP
+#if FAST_TEMPERATURE_LOOKUP
+            , NULL
+#endif
+#if TEMP_MODEL_CONTROL
+            , {TEMP_MODEL_GAIN, TEMP_MODEL_TIME_CONSTANT, TEMP_MODEL_DEAD_TIME, TEMP_MODEL_FEED_FORWARD}
+#endif
         }
         , ext2_select_cmd, ext2_deselect_cmd, EXT2_EXTRUDER_COOLER_SPEED, 0, 0, 0
 #if EXTRUDER_JAM_CONTROL
         , 0, 0, 10, 0, 0, JAM_SLOWDOWN_STEPS, JAM_ERROR_STEPS, JAM_SLOWDOWN_TO
+#endif
+#if VOLUMETRIC_FLOW_LIMIT
+        , EXT2_MAX_VOLUMETRIC_FLOW
 #endif
     }
 #endif
@@ -2792,10 +3290,19 @@ Extruder extruder[NUM_EXTRUDER] = {
             3, EXT3_TEMPSENSOR_TYPE, EXT3_SENSOR_INDEX, EXT3_HEAT_MANAGER, 0, 0, 0, 0, 0, 0
             , 0, EXT3_PID_INTEGRAL_DRIVE_MAX, EXT3_PID_INTEGRAL_DRIVE_MIN, EXT3_PID_PGAIN_OR_DEAD_TIME, EXT3_PID_I, EXT3_PID_D, EXT3_PID_MAX, 0, 0
             , 0, 0, 0, EXT3_DECOUPLE_TEST_PERIOD, 0, EXT3_PREHEAT_TEMP
+#if FAST_TEMPERATURE_LOOKUP
+            , NULL
+#endif
+#if TEMP_MODEL_CONTROL
+            , {TEMP_MODEL_GAIN, TEMP_MODEL_TIME_CONSTANT, TEMP_MODEL_DEAD_TIME, TEMP_MODEL_FEED_FORWARD}
+#endif
         }
         , ext3_select_cmd, ext3_deselect_cmd, EXT3_EXTRUDER_COOLER_SPEED, 0, 0, 0
 #if EXTRUDER_JAM_CONTROL
         , 0, 0, 10, 0, 0, JAM_SLOWDOWN_STEPS, JAM_ERROR_STEPS, JAM_SLOWDOWN_TO
+#endif
+#if VOLUMETRIC_FLOW_LIMIT
+        , EXT3_MAX_VOLUMETRIC_FLOW
 #endif
     }
 #endif
@@ -2817,10 +3324,19 @@ Extruder extruder[NUM_EXTRUDER] = {
             4, EXT4_TEMPSENSOR_TYPE, EXT4_SENSOR_INDEX, EXT4_HEAT_MANAGER, 0, 0, 0, 0, 0, 0
             , 0, EXT4_PID_INTEGRAL_DRIVE_MAX, EXT4_PID_INTEGRAL_DRIVE_MIN, EXT4_PID_PGAIN_OR_DEAD_TIME, EXT4_PID_I, EXT4_PID_D, EXT4_PID_MAX, 0, 0
             , 0, 0, 0, EXT4_DECOUPLE_TEST_PERIOD, 0, EXT4_PREHEAT_TEMP
+#if FAST_TEMPERATURE_LOOKUP
+            , NULL
+#endif
+#if TEMP_MODEL_CONTROL
+            , {TEMP_MODEL_GAIN, TEMP_MODEL_TIME_CONSTANT, TEMP_MODEL_DEAD_TIME, TEMP_MODEL_FEED_FORWARD}
+#endif
         }
         , ext4_select_cmd, ext4_deselect_cmd, EXT4_EXTRUDER_COOLER_SPEED, 0, 0, 0
 #if EXTRUDER_JAM_CONTROL
         , 0, 0, 10, 0, 0, JAM_SLOWDOWN_STEPS, JAM_ERROR_STEPS, JAM_SLOWDOWN_TO
+#endif
+#if VOLUMETRIC_FLOW_LIMIT
+        , EXT4_MAX_VOLUMETRIC_FLOW
 #endif
     }
 #endif
@@ -2842,10 +3358,19 @@ Extruder extruder[NUM_EXTRUDER] = {
             5, EXT5_TEMPSENSOR_TYPE, EXT5_SENSOR_INDEX, EXT5_HEAT_MANAGER, 0, 0, 0, 0, 0, 0
             , 0, EXT5_PID_INTEGRAL_DRIVE_MAX, EXT5_PID_INTEGRAL_DRIVE_MIN, EXT5_PID_PGAIN_OR_DEAD_TIME, EXT5_PID_I, EXT5_PID_D, EXT5_PID_MAX, 0, 0
             , 0, 0, 0, EXT5_DECOUPLE_TEST_PERIOD, 0, EXT5_PREHEAT_TEMP
+#if FAST_TEMPERATURE_LOOKUP
+            , NULL
+#endif
+#if TEMP_MODEL_CONTROL
+            , {TEMP_MODEL_GAIN, TEMP_MODEL_TIME_CONSTANT, TEMP_MODEL_DEAD_TIME, TEMP_MODEL_FEED_FORWARD}
+#endif
         }
         , ext5_select_cmd, ext5_deselect_cmd, EXT5_EXTRUDER_COOLER_SPEED, 0, 0, 0
 #if EXTRUDER_JAM_CONTROL
         , 0, 0, 10, 0, 0, JAM_SLOWDOWN_STEPS, JAM_ERROR_STEPS, JAM_SLOWDOWN_TO
+#endif
+#if VOLUMETRIC_FLOW_LIMIT
+        , EXT5_MAX_VOLUMETRIC_FLOW
 #endif
     }
 #endif
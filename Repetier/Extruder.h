@@ -12,6 +12,7 @@ extern uint8_t manageMonitor;
 #define HTR_PID 1
 #define HTR_SLOWBANG 2
 #define HTR_DEADTIME 3
+#define HTR_MODEL 4
 
 #define TEMPERATURE_CONTROLLER_FLAG_ALARM 1
 #define TEMPERATURE_CONTROLLER_FLAG_DECOUPLE_FULL 2    ///< Full heating enabled
@@ -36,7 +37,7 @@ public:
     uint8_t pwmIndex; ///< pwm index for output control. 0-2 = Extruder, 3 = Fan, 4 = Heated Bed
     uint8_t sensorType; ///< Type of temperature sensor.
     uint8_t sensorPin; ///< Pin to read extruder temperature.
-    int8_t heatManager; ///< How is temperature controlled. 0 = on/off, 1 = PID-Control, 3 = dead time control
+    int8_t heatManager; ///< How is temperature controlled. 0 = on/off, 1 = PID-Control, 3 = dead time control, 4 = model control
     int16_t currentTemperature; ///< Current temperature value read from sensor.
     //int16_t targetTemperature; ///< Target temperature value in units of sensor.
     float currentTemperatureC; ///< Current temperature in degC.
@@ -61,10 +62,24 @@ public:
     millis_t decoupleTestPeriod; ///< Time between setting and testing decoupling.
     millis_t preheatStartTime;    ///< Time (in milliseconds) when heat up was started
     int16_t preheatTemperature;
+#if FAST_TEMPERATURE_LOOKUP
+    TemperatureLookup *lookup; ///< Fast conversion of table based sensors, NULL = search sensor table.
+#endif
+#if TEMP_MODEL_CONTROL
+    TemperatureModel model; ///< Heater model for HTR_MODEL
+#endif
 
     void setTargetTemperature(float target);
     void updateCurrentTemperature();
+    void convertTemperature(int currentTemperature);
+    static bool sensorTable(uint8_t type, SensorTable &st);
+#if FAST_TEMPERATURE_LOOKUP
+    void buildLookupTable(TemperatureLookup *table);
+#endif
     void updateTempControlVars();
+#if TEMP_MODEL_CONTROL
+    uint8_t computeModelOutput(float extrusionSpeed);
+#endif
     inline bool isAlarm()
     {
         return flags & TEMPERATURE_CONTROLLER_FLAG_ALARM;
@@ -156,6 +171,7 @@ public:
 #endif
     void waitForTargetTemperature();
     void autotunePID(float temp,uint8_t controllerId,int maxCycles,bool storeResult, int method);
+    void autotuneStep(float temp, uint8_t controllerId, bool storeResult, int method);
    inline void startPreheatTime()
    {
        preheatStartTime = HAL::timeInMilliseconds();
@@ -239,6 +255,7 @@ public:
     static uint8_t mixingDir; ///< Direction flag
     static uint8_t activeMixingExtruder;
 	static void recomputeMixingExtruderSteps();
+    static int mixingWA[NUM_EXTRUDER]; ///< Balanced weights the stepper uses, with MIXING_GRADIENT those of the move being executed
 #endif
     uint8_t id;
     int32_t xOffset;
@@ -287,6 +304,9 @@ public:
 	int32_t jamErrorSteps;
 	uint8_t jamSlowdownTo;
 #endif
+#if VOLUMETRIC_FLOW_LIMIT
+    float maxVolumetricFlow; ///< Max. melt rate in mm^3/s, 0 = no limit
+#endif
 
     // Methods here
 
@@ -319,6 +339,13 @@ public:
     void retractDistance(float dist,bool extraLength = false);
 #endif
     static void manageTemperatures();
+#if HEATER_SCHEDULER
+    static void scheduleHeaters(millis_t time);
+    static void reportHeaterBudget();
+#endif
+#if ANALOG_INPUT_FILTER && ANALOG_INPUTS > 0
+    static void reportAnalogNoise();
+#endif
     static void disableCurrentExtruderMotor();
     static void disableAllExtruderMotors();
     static void selectExtruderById(uint8_t extruderId);
@@ -327,9 +354,25 @@ public:
     static void initHeatedBed();
     static void setHeatedBedTemperature(float temp_celsius,bool beep = false);
     static float getHeatedBedTemperature();
+    static void waitForExtruderTemperature(uint8_t extr);
     static void setTemperatureForExtruder(float temp_celsius,uint8_t extr,bool beep = false,bool wait = false);
     static void pauseExtruders(bool bed = false);
     static void unpauseExtruders(bool wait = true);
+#if TOOLCHANGE_PREHEAT
+    static void toolchangeLookahead();
+#endif
+#if RETRACT_ON_TRAVEL
+    static int32_t retractPendingSteps; ///< Retraction waiting for the next travel move
+    static bool travelTailPending; ///< End of last travel move is held back for a possible unretract
+    static void queueRetractTravel();
+    static void flushRetractTravel();
+#endif
+#if PREDICTIVE_HEATUP
+    static uint8_t heatupPending; ///< Bit per temperature controller with deferred wait
+    static void deferHeatup(fast8_t controller);
+    static float estimateHeatupTime(fast8_t controller);
+    static void waitForPendingHeatup();
+#endif
 };
 
 #if HAVE_HEATED_BED
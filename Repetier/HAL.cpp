@@ -5,6 +5,64 @@
 uint8 osAnalogInputCounter[ANALOG_INPUTS];
 uint osAnalogInputBuildup[ANALOG_INPUTS];
 uint8 osAnalogInputPos = 0; // Current sampling position
+#if ANALOG_INPUT_FILTER
+static uint osAnalogInputLast[ANALOG_INPUTS][ANALOG_INPUT_MEDIAN]; // newest reading first
+static uint osAnalogInputFiltered[ANALOG_INPUTS]; // IIR state, value << ANALOG_INPUT_IIR_SHIFT
+static uint osAnalogInputStarted = 0; // bit per channel with valid filter state
+volatile uint osAnalogInputNoise[ANALOG_INPUTS];
+volatile uint osAnalogInputPeak[ANALOG_INPUTS];
+volatile uint osAnalogInputRound = 0;
+
+/** Median of the last readings followed by the IIR low pass. Returns the filtered 12 bit value. */
+static inline uint filterAnalogInput(uint8_t pos, uint value) {
+    uint *last = osAnalogInputLast[pos];
+    if((osAnalogInputStarted & (1 << pos)) == 0) { // first reading, start filter at value
+        for(uint8_t i = 0; i < ANALOG_INPUT_MEDIAN; i++)
+            last[i] = value;
+        osAnalogInputFiltered[pos] = value << ANALOG_INPUT_IIR_SHIFT;
+        osAnalogInputStarted |= 1 << pos;
+        return value;
+    }
+    for(uint8_t i = ANALOG_INPUT_MEDIAN - 1; i > 0; i--)
+        last[i] = last[i - 1];
+    last[0] = value;
+#if ANALOG_INPUT_MEDIAN > 1
+    uint sorted[ANALOG_INPUT_MEDIAN];
+    for(uint8_t i = 0; i < ANALOG_INPUT_MEDIAN; i++) {
+        uint v = last[i];
+        uint8_t j = i;
+        for(; j > 0 && sorted[j - 1] > v; j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = v;
+    }
+    uint median = sorted[ANALOG_INPUT_MEDIAN >> 1];
+#else
+    uint median = value;
+#endif
+    uint filtered = osAnalogInputFiltered[pos];
+    filtered = filtered - (filtered >> ANALOG_INPUT_IIR_SHIFT) + median;
+    osAnalogInputFiltered[pos] = filtered;
+    filtered >>= ANALOG_INPUT_IIR_SHIFT;
+    uint deviation = (value > filtered ? value - filtered : filtered - value);
+    osAnalogInputNoise[pos] = osAnalogInputNoise[pos] - (osAnalogInputNoise[pos] >> 4) + deviation;
+    if(deviation > osAnalogInputPeak[pos])
+        osAnalogInputPeak[pos] = deviation;
+    return filtered;
+}
+
+/** Slow channels are only converted in every n-th sampling round. */
+static inline bool skipAnalogInput(uint8_t pos) {
+#if BED_ANALOG_INPUTS && ANALOG_BED_SAMPLE_DIVIDER > 1
+    if(pos == BED_SENSOR_INDEX)
+        return (osAnalogInputRound % ANALOG_BED_SAMPLE_DIVIDER) != 0;
+#endif
+#if THERMO_ANALOG_INPUTS && ANALOG_THERMO_SAMPLE_DIVIDER > 1
+    if(pos == THERMO_ANALOG_INDEX)
+        return (osAnalogInputRound % ANALOG_THERMO_SAMPLE_DIVIDER) != 0;
+#endif
+    return false;
+}
+#endif
 #endif
 #if FEATURE_WATCHDOG
 bool HAL::wdPinged = false;
@@ -301,7 +359,14 @@ void HAL::analogStart() {
         osAnalogInputCounter[i] = 0;
         osAnalogInputBuildup[i] = 0;
         osAnalogInputValues[i] = 0;
+#if ANALOG_INPUT_FILTER
+        osAnalogInputNoise[i] = 0;
+        osAnalogInputPeak[i] = 0;
+#endif
     }
+#if ANALOG_INPUT_FILTER
+    osAnalogInputStarted = 0;
+#endif
     ADCSRA = _BV(ADEN) | _BV(ADSC) | ANALOG_PRESCALER;
     //ADCSRA |= _BV(ADSC);                  // start ADC-conversion
     while (ADCSRA & _BV(ADSC) ) {} // wait for conversion
@@ -763,6 +828,16 @@ ISR(TIMER1_COMPA_vect) {
 #endif
 
 #define pulseDensityModulate( pin, density,error,invert) {uint8_t carry;carry = error + (invert ? 255 - density : density); WRITE(pin, (carry < error)); error = carry;}
+#if HEATER_SCHEDULER
+// Heaters switch on at their own phase, the pwm count is relative to the phase latched at switch on.
+// Phases and outputs are latched at the start of a period, so each heater switches on once per period.
+#define HEATER_PWM_LATCH(idx) {heater_phase_next[idx] = heaterPhase[idx] & HEATER_PWM_MASK; heater_pos_next[idx] = pwm_pos[idx] & HEATER_PWM_MASK;}
+#define HEATER_PWM_ON(idx, pin) if(pwm_count_heater == heater_phase_next[idx]) {pwm_phase_set[idx] = pwm_count_heater; if((pwm_pos_set[idx] = heater_pos_next[idx]) > 0) WRITE(pin, !HEATER_PINS_INVERTED);}
+#define HEATER_PWM_COUNT(idx) static_cast<uint8_t>(pwm_count_heater - pwm_phase_set[idx])
+#else
+#define HEATER_PWM_ON(idx, pin) if((pwm_pos_set[idx] = (pwm_pos[idx] & HEATER_PWM_MASK)) > 0) WRITE(pin, !HEATER_PINS_INVERTED);
+#define HEATER_PWM_COUNT(idx) pwm_count_heater
+#endif
 /**
 This timer is called 3906 timer per second. It is used to update pwm values for heater and some other frequent jobs.
 */
@@ -770,31 +845,41 @@ ISR(PWM_TIMER_VECTOR) {
     static uint8_t pwm_count_cooler = 0;
     static uint8_t pwm_count_heater = 0;
     static uint8_t pwm_pos_set[NUM_PWM];
+#if HEATER_SCHEDULER
+    static uint8_t pwm_phase_set[PWM_HEATED_BED + 1];
+    static uint8_t heater_phase_next[PWM_HEATED_BED + 1];
+    static uint8_t heater_pos_next[PWM_HEATED_BED + 1];
+#endif
 #if NUM_EXTRUDER > 0 && ((defined(EXT0_HEATER_PIN) && EXT0_HEATER_PIN > -1 && EXT0_EXTRUDER_COOLER_PIN > -1) || (NUM_EXTRUDER > 1 && EXT1_EXTRUDER_COOLER_PIN > -1 && EXT1_EXTRUDER_COOLER_PIN != EXT0_EXTRUDER_COOLER_PIN) || (NUM_EXTRUDER > 2 && EXT2_EXTRUDER_COOLER_PIN > -1 && EXT2_EXTRUDER_COOLER_PIN != EXT2_EXTRUDER_COOLER_PIN) || (NUM_EXTRUDER > 3 && EXT3_EXTRUDER_COOLER_PIN > -1 && EXT3_EXTRUDER_COOLER_PIN != EXT3_EXTRUDER_COOLER_PIN) || (NUM_EXTRUDER > 4 && EXT4_EXTRUDER_COOLER_PIN > -1 && EXT4_EXTRUDER_COOLER_PIN != EXT4_EXTRUDER_COOLER_PIN) || (NUM_EXTRUDER > 5 && EXT5_EXTRUDER_COOLER_PIN > -1 && EXT5_EXTRUDER_COOLER_PIN != EXT5_EXTRUDER_COOLER_PIN))
     static uint8_t pwm_cooler_pos_set[NUM_EXTRUDER];
 #endif
     PWM_OCR += 64;
-    if(pwm_count_heater == 0 && !PDM_FOR_EXTRUDER) {
+    if((pwm_count_heater == 0 || HEATER_SCHEDULER) && !PDM_FOR_EXTRUDER) {
+#if HEATER_SCHEDULER
+        if(pwm_count_heater == 0)
+            for(uint8_t i = 0; i <= PWM_HEATED_BED; i++)
+                HEATER_PWM_LATCH(i)
+#endif
 #if defined(EXT0_HEATER_PIN) && EXT0_HEATER_PIN > -1
-        if((pwm_pos_set[0] = (pwm_pos[0] & HEATER_PWM_MASK)) > 0) WRITE(EXT0_HEATER_PIN, !HEATER_PINS_INVERTED);
+        HEATER_PWM_ON(0, EXT0_HEATER_PIN)
 #endif
 #if defined(EXT1_HEATER_PIN) && EXT1_HEATER_PIN > -1 && NUM_EXTRUDER > 1 && !MIXING_EXTRUDER
-        if((pwm_pos_set[1] = (pwm_pos[1] & HEATER_PWM_MASK)) > 0) WRITE(EXT1_HEATER_PIN, !HEATER_PINS_INVERTED);
+        HEATER_PWM_ON(1, EXT1_HEATER_PIN)
 #endif
 #if defined(EXT2_HEATER_PIN) && EXT2_HEATER_PIN > -1 && NUM_EXTRUDER > 2 && !MIXING_EXTRUDER
-        if((pwm_pos_set[2] = (pwm_pos[2] & HEATER_PWM_MASK)) > 0) WRITE(EXT2_HEATER_PIN, !HEATER_PINS_INVERTED);
+        HEATER_PWM_ON(2, EXT2_HEATER_PIN)
 #endif
 #if defined(EXT3_HEATER_PIN) && EXT3_HEATER_PIN > -1 && NUM_EXTRUDER > 3 && !MIXING_EXTRUDER
-        if((pwm_pos_set[3] = (pwm_pos[3] & HEATER_PWM_MASK)) > 0) WRITE(EXT3_HEATER_PIN, !HEATER_PINS_INVERTED);
+        HEATER_PWM_ON(3, EXT3_HEATER_PIN)
 #endif
 #if defined(EXT4_HEATER_PIN) && EXT4_HEATER_PIN > -1 && NUM_EXTRUDER > 4 && !MIXING_EXTRUDER
-        if((pwm_pos_set[4] = (pwm_pos[4] & HEATER_PWM_MASK)) > 0) WRITE(EXT4_HEATER_PIN, !HEATER_PINS_INVERTED);
+        HEATER_PWM_ON(4, EXT4_HEATER_PIN)
 #endif
 #if defined(EXT5_HEATER_PIN) && EXT5_HEATER_PIN > -1 && NUM_EXTRUDER > 5 && !MIXING_EXTRUDER
-        if((pwm_pos_set[5] = (pwm_pos[5] & HEATER_PWM_MASK)) > 0) WRITE(EXT5_HEATER_PIN, !HEATER_PINS_INVERTED);
+        HEATER_PWM_ON(5, EXT5_HEATER_PIN)
 #endif
 #if HEATED_BED_HEATER_PIN > -1 && HAVE_HEATED_BED
-        if((pwm_pos_set[NUM_EXTRUDER] = (pwm_pos[NUM_EXTRUDER] & HEATER_PWM_MASK)) > 0) WRITE(HEATED_BED_HEATER_PIN, !HEATER_PINS_INVERTED);
+        HEATER_PWM_ON(NUM_EXTRUDER, HEATED_BED_HEATER_PIN)
 #endif
     }
     if(pwm_count_cooler == 0 && !PDM_FOR_COOLER) {
@@ -843,7 +928,7 @@ ISR(PWM_TIMER_VECTOR) {
 #if PDM_FOR_EXTRUDER
     pulseDensityModulate(EXT0_HEATER_PIN, pwm_pos[0], pwm_pos_set[0], HEATER_PINS_INVERTED);
 #else
-    if(pwm_pos_set[0] == pwm_count_heater && pwm_pos_set[0] != HEATER_PWM_MASK) WRITE(EXT0_HEATER_PIN, HEATER_PINS_INVERTED);
+    if(pwm_pos_set[0] == HEATER_PWM_COUNT(0) && pwm_pos_set[0] != HEATER_PWM_MASK) WRITE(EXT0_HEATER_PIN, HEATER_PINS_INVERTED);
 #endif
 #if EXT0_EXTRUDER_COOLER_PIN > -1
 #if PDM_FOR_COOLER
@@ -857,7 +942,7 @@ ISR(PWM_TIMER_VECTOR) {
 #if PDM_FOR_EXTRUDER
     pulseDensityModulate(EXT1_HEATER_PIN, pwm_pos[1], pwm_pos_set[1], HEATER_PINS_INVERTED);
 #else
-    if(pwm_pos_set[1] == pwm_count_heater && pwm_pos_set[1] != HEATER_PWM_MASK) WRITE(EXT1_HEATER_PIN, HEATER_PINS_INVERTED);
+    if(pwm_pos_set[1] == HEATER_PWM_COUNT(1) && pwm_pos_set[1] != HEATER_PWM_MASK) WRITE(EXT1_HEATER_PIN, HEATER_PINS_INVERTED);
 #endif
 #if !SHARED_COOLER && defined(EXT1_EXTRUDER_COOLER_PIN) && EXT1_EXTRUDER_COOLER_PIN > -1 && EXT1_EXTRUDER_COOLER_PIN != EXT0_EXTRUDER_COOLER_PIN
 #if PDM_FOR_COOLER
@@ -871,7 +956,7 @@ ISR(PWM_TIMER_VECTOR) {
 #if PDM_FOR_EXTRUDER
     pulseDensityModulate(EXT2_HEATER_PIN, pwm_pos[2], pwm_pos_set[2], HEATER_PINS_INVERTED);
 #else
-    if(pwm_pos_set[2] == pwm_count_heater && pwm_pos_set[2] != HEATER_PWM_MASK) WRITE(EXT2_HEATER_PIN, HEATER_PINS_INVERTED);
+    if(pwm_pos_set[2] == HEATER_PWM_COUNT(2) && pwm_pos_set[2] != HEATER_PWM_MASK) WRITE(EXT2_HEATER_PIN, HEATER_PINS_INVERTED);
 #endif
 #if !SHARED_COOLER && EXT2_EXTRUDER_COOLER_PIN > -1
 #if PDM_FOR_COOLER
@@ -885,7 +970,7 @@ ISR(PWM_TIMER_VECTOR) {
 #if PDM_FOR_EXTRUDER
     pulseDensityModulate(EXT3_HEATER_PIN, pwm_pos[3], pwm_pos_set[3], HEATER_PINS_INVERTED);
 #else
-    if(pwm_pos_set[3] == pwm_count_heater && pwm_pos_set[3] != HEATER_PWM_MASK) WRITE(EXT3_HEATER_PIN, HEATER_PINS_INVERTED);
+    if(pwm_pos_set[3] == HEATER_PWM_COUNT(3) && pwm_pos_set[3] != HEATER_PWM_MASK) WRITE(EXT3_HEATER_PIN, HEATER_PINS_INVERTED);
 #endif
 #if !SHARED_COOLER && EXT3_EXTRUDER_COOLER_PIN > -1
 #if PDM_FOR_COOLER
@@ -899,7 +984,7 @@ ISR(PWM_TIMER_VECTOR) {
 #if PDM_FOR_EXTRUDER
     pulseDensityModulate(EXT4_HEATER_PIN, pwm_pos[4], pwm_pos_set[4], HEATER_PINS_INVERTED);
 #else
-    if(pwm_pos_set[4] == pwm_count_heater && pwm_pos_set[4] != HEATER_PWM_MASK) WRITE(EXT4_HEATER_PIN, HEATER_PINS_INVERTED);
+    if(pwm_pos_set[4] == HEATER_PWM_COUNT(4) && pwm_pos_set[4] != HEATER_PWM_MASK) WRITE(EXT4_HEATER_PIN, HEATER_PINS_INVERTED);
 #endif
 #if !SHARED_COOLER && EXT4_EXTRUDER_COOLER_PIN > -1
 #if PDM_FOR_COOLER
@@ -913,7 +998,7 @@ ISR(PWM_TIMER_VECTOR) {
 #if PDM_FOR_EXTRUDER
     pulseDensityModulate(EXT5_HEATER_PIN, pwm_pos[5], pwm_pos_set[5], HEATER_PINS_INVERTED);
 #else
-    if(pwm_pos_set[5] == pwm_count_heater && pwm_pos_set[5] != HEATER_PWM_MASK) WRITE(EXT5_HEATER_PIN, HEATER_PINS_INVERTED);
+    if(pwm_pos_set[5] == HEATER_PWM_COUNT(5) && pwm_pos_set[5] != HEATER_PWM_MASK) WRITE(EXT5_HEATER_PIN, HEATER_PINS_INVERTED);
 #endif
 #if !SHARED_COOLER && EXT5_EXTRUDER_COOLER_PIN > -1
 #if PDM_FOR_COOLER
@@ -971,7 +1056,7 @@ ISR(PWM_TIMER_VECTOR) {
 #if PDM_FOR_EXTRUDER
     pulseDensityModulate(HEATED_BED_HEATER_PIN, pwm_pos[NUM_EXTRUDER], pwm_pos_set[NUM_EXTRUDER], HEATER_PINS_INVERTED);
 #else
-    if(pwm_pos_set[NUM_EXTRUDER] == pwm_count_heater && pwm_pos_set[NUM_EXTRUDER] != HEATER_PWM_MASK) WRITE(HEATED_BED_HEATER_PIN, HEATER_PINS_INVERTED);
+    if(pwm_pos_set[NUM_EXTRUDER] == HEATER_PWM_COUNT(NUM_EXTRUDER) && pwm_pos_set[NUM_EXTRUDER] != HEATER_PWM_MASK) WRITE(HEATED_BED_HEATER_PIN, HEATER_PINS_INVERTED);
 #endif
 #endif
     counterPeriodical++; // Approximate a 100ms timer
@@ -990,24 +1075,34 @@ ISR(PWM_TIMER_VECTOR) {
     if((ADCSRA & _BV(ADSC)) == 0) { // Conversion finished?
         osAnalogInputBuildup[osAnalogInputPos] += ADCW;
         if(++osAnalogInputCounter[osAnalogInputPos] >= _BV(ANALOG_INPUT_SAMPLE)) {
-            // update temperatures only when values have been read
-            if(executePeriodical == 0 || osAnalogInputPos >= NUM_ANALOG_TEMP_SENSORS) {
 #if ANALOG_INPUT_BITS + ANALOG_INPUT_SAMPLE < 12
-                osAnalogInputValues[osAnalogInputPos] =
-                    osAnalogInputBuildup[osAnalogInputPos] << (12 - ANALOG_INPUT_BITS - ANALOG_INPUT_SAMPLE);
+            uint value = osAnalogInputBuildup[osAnalogInputPos] << (12 - ANALOG_INPUT_BITS - ANALOG_INPUT_SAMPLE);
 #endif
 #if ANALOG_INPUT_BITS + ANALOG_INPUT_SAMPLE > 12
-                osAnalogInputValues[osAnalogInputPos] =
-                    osAnalogInputBuildup[osAnalogInputPos] >> (ANALOG_INPUT_BITS + ANALOG_INPUT_SAMPLE - 12);
+            uint value = osAnalogInputBuildup[osAnalogInputPos] >> (ANALOG_INPUT_BITS + ANALOG_INPUT_SAMPLE - 12);
 #endif
 #if ANALOG_INPUT_BITS + ANALOG_INPUT_SAMPLE == 12
-                osAnalogInputValues[osAnalogInputPos] = osAnalogInputBuildup[osAnalogInputPos];
+            uint value = osAnalogInputBuildup[osAnalogInputPos];
 #endif
-            }
+#if ANALOG_INPUT_FILTER
+            value = filterAnalogInput(osAnalogInputPos, value);
+#endif
+            // update temperatures only when values have been read
+            if(executePeriodical == 0 || osAnalogInputPos >= NUM_ANALOG_TEMP_SENSORS)
+                osAnalogInputValues[osAnalogInputPos] = value;
             osAnalogInputBuildup[osAnalogInputPos] = 0;
             osAnalogInputCounter[osAnalogInputPos] = 0;
             // Start next conversion
+#if ANALOG_INPUT_FILTER
+            do {
+                if(++osAnalogInputPos >= ANALOG_INPUTS) {
+                    osAnalogInputPos = 0;
+                    osAnalogInputRound++;
+                }
+            } while(skipAnalogInput(osAnalogInputPos));
+#else
             if(++osAnalogInputPos >= ANALOG_INPUTS) osAnalogInputPos = 0;
+#endif
             uint8_t channel = pgm_read_byte(&osAnalogInputChannels[osAnalogInputPos]);
 #if defined(ADCSRB) && defined(MUX5)
             if(channel & 8)  // Reading channel 0-7 or 8-15?
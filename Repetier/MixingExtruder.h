@@ -0,0 +1,94 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _MIXING_EXTRUDER_H
+#define _MIXING_EXTRUDER_H
+
+#include <stdint.h>
+
+/* Step distribution of the mixing extruder. The functions only need the members
+stepsPerMM, mixingW, mixingWB and mixingE of the extruders, so tools/mixing_test can
+run them on the host. */
+
+#define MIXING_WEIGHT_SUM 10000
+
+/** Scales the weights mixingW of the n extruders ext by their resolution to mixingWB, so
+each virtual step goes to the extruders in the wanted volume ratio. The rounding rest goes
+to the largest weight, so the balanced weights add up to MIXING_WEIGHT_SUM. Returns the sum
+of the balanced weights, 0 if all weights are 0. */
+template<class E> inline int balanceMixingWeights(E *ext, uint8_t n)
+{
+    uint8_t i, largest = 0;
+    int total = 0;
+    float sum = 0;
+    for(i = 0; i < n; i++)
+        sum += ext[i].stepsPerMM * ext[i].mixingW; // steps of virtual axis with original weights
+    for(i = 0; i < n; i++) {
+        ext[i].mixingWB = (sum > 0 ? static_cast<int>(static_cast<float>(MIXING_WEIGHT_SUM) * ext[i].stepsPerMM * ext[i].mixingW / sum) : 0);
+        if(ext[i].mixingWB > ext[largest].mixingWB)
+            largest = i;
+        total += ext[i].mixingWB;
+    }
+    if(total > 0) { // rounding rest goes to the largest weight so the ratio stays exact over long runs
+        ext[largest].mixingWB += MIXING_WEIGHT_SUM - total;
+        total = MIXING_WEIGHT_SUM;
+    }
+    return total;
+}
+
+/** Extruder that gets the next virtual step. Every extruder with weight gains its weight
+in the error mixingE, the one that is furthest behind gets the step and gives back the
+weight sum. Errors are kept when the weights change, so a ratio change starts where the
+last ratio ended. Returns 255 if no extruder has weight.
+\param weight Active balanced weights.
+\param sum Sum of the active weights.
+\param forward Direction of the virtual extruder.
+*/
+template<class E> inline uint8_t mixingStepExtruder(E *ext, const int *weight, int sum, uint8_t n, bool forward)
+{
+    uint8_t best = 255, i;
+    int bestError;
+    if(forward) {
+        bestError = -20000;
+        for(i = 0; i < n; i++) {
+            if(weight[i] == 0) continue;
+            if(ext[i].mixingE > bestError) {
+                bestError = ext[i].mixingE;
+                best = i;
+            }
+            ext[i].mixingE += weight[i];
+        }
+        if(best != 255)
+            ext[best].mixingE -= sum;
+    } else {
+        bestError = 20000;
+        for(i = 0; i < n; i++) {
+            if(weight[i] == 0) continue;
+            if(ext[i].mixingE < bestError) {
+                bestError = ext[i].mixingE;
+                best = i;
+            }
+            ext[i].mixingE -= weight[i];
+        }
+        if(best != 255)
+            ext[best].mixingE += sum;
+    }
+    return best;
+}
+
+#endif
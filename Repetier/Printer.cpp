@@ -622,6 +622,9 @@ void Printer::moveToParkPosition() {
 
 // This is for untransformed move to coordinates in printers absolute Cartesian space
 uint8_t Printer::moveTo(float x, float y, float z, float e, float f) {
+#if RETRACT_ON_TRAVEL
+    Extruder::flushRetractTravel(); // held back retraction moves go first
+#endif
     if(x != IGNORE_COORDINATE)
         destinationSteps[X_AXIS] = (x + Printer::offsetX) * axisStepsPerMM[X_AXIS];
     if(y != IGNORE_COORDINATE)
@@ -648,6 +651,9 @@ uint8_t Printer::moveTo(float x, float y, float z, float e, float f) {
 }
 
 uint8_t Printer::moveToReal(float x, float y, float z, float e, float f, bool pathOptimize) {
+#if RETRACT_ON_TRAVEL
+    Extruder::flushRetractTravel(); // held back retraction moves go first
+#endif
     if(x == IGNORE_COORDINATE)
         x = currentPosition[X_AXIS];
     else
@@ -1450,6 +1456,9 @@ void Printer::homeZAxis() { // Delta z homing
 }
 // This home axis is for delta
 void Printer::homeAxis(bool xaxis, bool yaxis, bool zaxis) { // Delta homing code
+#if RETRACT_ON_TRAVEL
+    Extruder::flushRetractTravel(); // held back retraction moves go first
+#endif
     bool nocheck = isNoDestinationCheck();
     setNoDestinationCheck(true);
 #if defined(SUPPORT_LASER) && SUPPORT_LASER
@@ -1874,6 +1883,9 @@ after doing some initialization work. The order of operation and some extra func
 \param zaxis True if homing of z axis is wanted.
 */
 void Printer::homeAxis(bool xaxis, bool yaxis, bool zaxis) { // home non-delta printer
+#if RETRACT_ON_TRAVEL
+    Extruder::flushRetractTravel(); // held back retraction moves go first
+#endif
     bool nocheck = isNoDestinationCheck();
     setNoDestinationCheck(true);
 
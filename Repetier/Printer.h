@@ -197,7 +197,9 @@ multiplying the ROTC coordinates with the axisStepsPerMM.
 
 If distortion correction is enabled, there is an additional factor for the z position that
 gets added: _zCorrectionStepsIncluded_ This value is recalculated by every move added to
-reflect the distortion at any given xyz position.
+reflect the distortion at any given xyz position. With DISTORTION_STEP_INJECTION xy moves
+keep their z and the stepper interrupt adds the correction difference while moving, so the
+value is the correction at the end of the last queued move.
 
 ### Nonlinear motor position coordinates (NMC)
 
@@ -299,6 +299,169 @@ inline void memcopy4(void *dest,void *source) {
 #endif
 #endif
 
+#ifndef DISTORTION_STEP_INJECTION
+#define DISTORTION_STEP_INJECTION 0
+#endif
+#if DISTORTION_STEP_INJECTION && (!DISTORTION_CORRECTION || DRIVE_SYSTEM == DELTA || DRIVE_SYSTEM == TUGA || DRIVE_SYSTEM == BIPOD || DRIVE_SYSTEM == XZ_GANTRY || DRIVE_SYSTEM == ZX_GANTRY || defined(FAST_COREXYZ))
+#undef DISTORTION_STEP_INJECTION
+#define DISTORTION_STEP_INJECTION 0
+#endif
+#if DISTORTION_STEP_INJECTION
+#ifndef DISTORTION_RAMP_PIECES
+#define DISTORTION_RAMP_PIECES 4
+#endif
+#if DISTORTION_RAMP_PIECES < 1 || DISTORTION_RAMP_PIECES > 8
+#error DISTORTION_RAMP_PIECES must be in range 1-8
+#endif
+#endif
+
+#ifndef FAST_TEMPERATURE_LOOKUP
+#define FAST_TEMPERATURE_LOOKUP 0
+#endif
+#ifndef TEMPERATURE_LOOKUP_SHIFT
+#define TEMPERATURE_LOOKUP_SHIFT 6
+#endif
+#ifndef TEMPERATURE_LOOKUP_SAMPLES
+#define TEMPERATURE_LOOKUP_SAMPLES 232
+#endif
+#if FAST_TEMPERATURE_LOOKUP && (TEMPERATURE_LOOKUP_SHIFT < 5 || TEMPERATURE_LOOKUP_SHIFT > 8)
+#error TEMPERATURE_LOOKUP_SHIFT must be in range 5-8
+#endif
+#if FAST_TEMPERATURE_LOOKUP && (TEMPERATURE_LOOKUP_SAMPLES > 256 || TEMPERATURE_LOOKUP_SAMPLES <= (4096 >> TEMPERATURE_LOOKUP_SHIFT))
+#error TEMPERATURE_LOOKUP_SAMPLES must be above the number of cells and at most 256
+#endif
+#ifndef TEMP_MODEL_CONTROL
+#define TEMP_MODEL_CONTROL 0
+#endif
+#ifndef HEATER_SCHEDULER
+#define HEATER_SCHEDULER 0
+#endif
+#if HEATER_SCHEDULER
+#ifndef HEATER_CURRENT_BUDGET
+#define HEATER_CURRENT_BUDGET 0
+#endif
+#ifndef HEATER_THROTTLE_HOLD
+#define HEATER_THROTTLE_HOLD 60000
+#endif
+#ifndef EXTRUDER_HEATER_CURRENT
+#define EXTRUDER_HEATER_CURRENT 3.4
+#endif
+#ifndef HEATED_BED_HEATER_CURRENT
+#define HEATED_BED_HEATER_CURRENT 11
+#endif
+#endif
+#ifndef MIXING_GRADIENT
+#define MIXING_GRADIENT 0
+#endif
+#if MIXING_GRADIENT && !MIXING_EXTRUDER
+#undef MIXING_GRADIENT
+#define MIXING_GRADIENT 0
+#endif
+#ifndef RETRACT_ON_TRAVEL
+#define RETRACT_ON_TRAVEL 0
+#endif
+#if RETRACT_ON_TRAVEL && !defined(RETRACT_TRAVEL_RAMP)
+#define RETRACT_TRAVEL_RAMP 1.0
+#endif
+#ifndef VOLUMETRIC_FLOW_LIMIT
+#define VOLUMETRIC_FLOW_LIMIT 0
+#endif
+#if VOLUMETRIC_FLOW_LIMIT
+#ifndef FILAMENT_DIAMETER
+#define FILAMENT_DIAMETER 1.75
+#endif
+#endif
+// also needed without the limit, EEPROM stores them for later use
+#ifndef EXT0_MAX_VOLUMETRIC_FLOW
+#define EXT0_MAX_VOLUMETRIC_FLOW 0
+#endif
+#ifndef EXT1_MAX_VOLUMETRIC_FLOW
+#define EXT1_MAX_VOLUMETRIC_FLOW 0
+#endif
+#ifndef EXT2_MAX_VOLUMETRIC_FLOW
+#define EXT2_MAX_VOLUMETRIC_FLOW 0
+#endif
+#ifndef EXT3_MAX_VOLUMETRIC_FLOW
+#define EXT3_MAX_VOLUMETRIC_FLOW 0
+#endif
+#ifndef EXT4_MAX_VOLUMETRIC_FLOW
+#define EXT4_MAX_VOLUMETRIC_FLOW 0
+#endif
+#ifndef EXT5_MAX_VOLUMETRIC_FLOW
+#define EXT5_MAX_VOLUMETRIC_FLOW 0
+#endif
+#ifndef TOOLCHANGE_PREHEAT
+#define TOOLCHANGE_PREHEAT 0
+#endif
+#if TOOLCHANGE_PREHEAT && (NUM_EXTRUDER < 2 || MIXING_EXTRUDER || SHARED_EXTRUDER_HEATER)
+#undef TOOLCHANGE_PREHEAT
+#define TOOLCHANGE_PREHEAT 0
+#endif
+#if TOOLCHANGE_PREHEAT
+#ifndef TOOLCHANGE_PREHEAT_TIME
+#define TOOLCHANGE_PREHEAT_TIME 30
+#endif
+#ifndef TOOLCHANGE_SCAN_BYTES
+#define TOOLCHANGE_SCAN_BYTES 16384
+#endif
+#define TOOLCHANGE_SCAN_CHUNK 64
+#endif
+#ifndef PREDICTIVE_HEATUP
+#define PREDICTIVE_HEATUP 0
+#endif
+#ifndef ANALOG_INPUT_FILTER
+#define ANALOG_INPUT_FILTER 0
+#endif
+#if ANALOG_INPUT_FILTER
+#ifndef ANALOG_INPUT_MEDIAN
+#define ANALOG_INPUT_MEDIAN 3
+#endif
+#ifndef ANALOG_INPUT_IIR_SHIFT
+#define ANALOG_INPUT_IIR_SHIFT 2
+#endif
+#ifndef ANALOG_BED_SAMPLE_DIVIDER
+#define ANALOG_BED_SAMPLE_DIVIDER 1
+#endif
+#ifndef ANALOG_THERMO_SAMPLE_DIVIDER
+#define ANALOG_THERMO_SAMPLE_DIVIDER 1
+#endif
+#if ANALOG_INPUT_MEDIAN != 1 && ANALOG_INPUT_MEDIAN != 3 && ANALOG_INPUT_MEDIAN != 5
+#error ANALOG_INPUT_MEDIAN must be 1, 3 or 5
+#endif
+#if ANALOG_INPUT_IIR_SHIFT > 4
+#error ANALOG_INPUT_IIR_SHIFT must not be larger than 4
+#endif
+#endif
+#ifndef TEMP_MODEL_AMBIENT
+#define TEMP_MODEL_AMBIENT 25
+#endif
+#if TEMP_MODEL_CONTROL
+#ifndef TEMP_MODEL_HORIZON
+#define TEMP_MODEL_HORIZON 4
+#endif
+#ifndef TEMP_MODEL_CORRECTION
+#define TEMP_MODEL_CORRECTION 0.5
+#endif
+#ifndef TEMP_MODEL_MAX_CORRECTION
+#define TEMP_MODEL_MAX_CORRECTION 40
+#endif
+#ifndef TEMP_MODEL_STEADY_RATE
+#define TEMP_MODEL_STEADY_RATE 1
+#endif
+#ifndef TEMP_MODEL_GAIN
+#define TEMP_MODEL_GAIN 1.6
+#endif
+#ifndef TEMP_MODEL_TIME_CONSTANT
+#define TEMP_MODEL_TIME_CONSTANT 120
+#endif
+#ifndef TEMP_MODEL_DEAD_TIME
+#define TEMP_MODEL_DEAD_TIME 3
+#endif
+#ifndef TEMP_MODEL_FEED_FORWARD
+#define TEMP_MODEL_FEED_FORWARD 6
+#endif
+#endif
+
 #ifndef MAX_ROOM_TEMPERATURE
 #define MAX_ROOM_TEMPERATURE 40
 #endif
@@ -380,6 +543,10 @@ inline void memcopy4(void *dest,void *source) {
 #else
 #define NONLINEAR_SYSTEM 0
 #endif
+#if RETRACT_ON_TRAVEL && (!FEATURE_RETRACTION || NONLINEAR_SYSTEM || MIXING_EXTRUDER)
+#undef RETRACT_ON_TRAVEL
+#define RETRACT_ON_TRAVEL 0
+#endif
 
 #ifdef FEATURE_Z_PROBE
 #define MANUAL_CONTROL 1
@@ -396,6 +563,16 @@ inline void memcopy4(void *dest,void *source) {
 #endif
 //After this count of steps a new SIN / COS calculation is started to correct the circle interpolation
 #define N_ARC_CORRECTION 25
+#ifndef ARC_ADAPTIVE_SEGMENTS
+#define ARC_ADAPTIVE_SEGMENTS 0
+#endif
+#ifndef BEZIER_SUPPORT
+#define BEZIER_SUPPORT 0
+#endif
+//Max. distance in mm between curve and chord for ARC_ADAPTIVE_SEGMENTS and BEZIER_SUPPORT
+#ifndef ARC_CHORD_TOLERANCE
+#define ARC_CHORD_TOLERANCE 0.01
+#endif
 
 // Test for shared cooler
 #if NUM_EXTRUDER == 6 && EXT0_EXTRUDER_COOLER_PIN > -1 && EXT0_EXTRUDER_COOLER_PIN == EXT1_EXTRUDER_COOLER_PIN && EXT2_EXTRUDER_COOLER_PIN == EXT3_EXTRUDER_COOLER_PIN && EXT4_EXTRUDER_COOLER_PIN == EXT5_EXTRUDER_COOLER_PIN && EXT0_EXTRUDER_COOLER_PIN == EXT2_EXTRUDER_COOLER_PIN && EXT0_EXTRUDER_COOLER_PIN == EXT4_EXTRUDER_COOLER_PIN
@@ -624,6 +801,104 @@ inline void memcopy4(void *dest,void *source) {
 #ifndef SDSUPPORT
 #define SDSUPPORT 0
 #endif
+#ifndef SD_READ_BUFFERS
+#define SD_READ_BUFFERS 0
+#endif
+#if SD_READ_BUFFERS && !SDSUPPORT
+#undef SD_READ_BUFFERS
+#define SD_READ_BUFFERS 0
+#endif
+#ifndef SD_INFO_CACHE
+#define SD_INFO_CACHE 0
+#endif
+#if SD_INFO_CACHE && (!SDSUPPORT || !JSON_OUTPUT)
+#undef SD_INFO_CACHE
+#define SD_INFO_CACHE 0
+#endif
+#ifndef SD_LAYER_INDEX
+#define SD_LAYER_INDEX 0
+#endif
+#if SD_LAYER_INDEX && !SDSUPPORT
+#undef SD_LAYER_INDEX
+#define SD_LAYER_INDEX 0
+#endif
+#if SD_LAYER_INDEX && !defined(SD_LAYER_SCAN_BYTES)
+#define SD_LAYER_SCAN_BYTES 512
+#endif
+#ifndef SD_CHECKPOINT
+#define SD_CHECKPOINT 0
+#endif
+#if SD_CHECKPOINT && (!SDSUPPORT || !NEW_COMMUNICATION)
+#undef SD_CHECKPOINT
+#define SD_CHECKPOINT 0
+#endif
+#if SD_CHECKPOINT
+#ifndef SD_CHECKPOINT_INTERVAL
+#define SD_CHECKPOINT_INTERVAL 10
+#endif
+#ifndef SD_CHECKPOINT_SLOTS
+#define SD_CHECKPOINT_SLOTS 16
+#endif
+#ifndef SD_CHECKPOINT_ZLIFT
+#define SD_CHECKPOINT_ZLIFT 5
+#endif
+#endif
+#ifndef SD_WRITE_BLOCKS
+#define SD_WRITE_BLOCKS 0
+#endif
+#if SD_WRITE_BLOCKS && !SDSUPPORT
+#undef SD_WRITE_BLOCKS
+#define SD_WRITE_BLOCKS 0
+#endif
+#ifndef SD_DIR_INDEX
+#define SD_DIR_INDEX 0
+#endif
+#if SD_DIR_INDEX && !SDSUPPORT
+#undef SD_DIR_INDEX
+#define SD_DIR_INDEX 0
+#endif
+#ifndef SD_DIR_SORT
+#define SD_DIR_SORT 0
+#endif
+#ifndef SD_ESTIMATE
+#define SD_ESTIMATE 0
+#endif
+#if SD_ESTIMATE && !SDSUPPORT
+#undef SD_ESTIMATE
+#define SD_ESTIMATE 0
+#endif
+#ifndef SD_PARSE_AHEAD
+#define SD_PARSE_AHEAD 0
+#endif
+#if SD_PARSE_AHEAD && (!SDSUPPORT || !NEW_COMMUNICATION)
+#undef SD_PARSE_AHEAD
+#define SD_PARSE_AHEAD 0
+#endif
+#ifndef SD_BLOCK_CACHE
+#define SD_BLOCK_CACHE 0
+#endif
+#if SD_BLOCK_CACHE && !SDSUPPORT
+#undef SD_BLOCK_CACHE
+#define SD_BLOCK_CACHE 0
+#endif
+#ifndef SD_COMPILED_JOBS
+#define SD_COMPILED_JOBS 0
+#endif
+#if SD_COMPILED_JOBS && !SDSUPPORT
+#undef SD_COMPILED_JOBS
+#define SD_COMPILED_JOBS 0
+#endif
+#ifndef SD_COMPILED_KEYFRAME
+#define SD_COMPILED_KEYFRAME 64
+#endif
+#if SD_READ_BUFFERS
+#ifndef SD_READ_BUFFER_SIZE
+#define SD_READ_BUFFER_SIZE 512
+#endif
+#if (SD_READ_BUFFER_SIZE & (SD_READ_BUFFER_SIZE - 1)) != 0 || SD_READ_BUFFER_SIZE > 512
+#error SD_READ_BUFFER_SIZE must be a power of 2 and not larger than 512
+#endif
+#endif
 
 #if SDSUPPORT
 #include "src/SdFat/SdFat.h"
@@ -912,6 +1187,11 @@ extern const uint8 osAnalogInputChannels[] PROGMEM;
 //extern uint8 osAnalogInputPos; // Current sampling position
 #if ANALOG_INPUTS > 0
 extern volatile uint osAnalogInputValues[ANALOG_INPUTS];
+#if ANALOG_INPUT_FILTER
+extern volatile uint osAnalogInputNoise[ANALOG_INPUTS]; // 16 x mean deviation of readings from filtered value
+extern volatile uint osAnalogInputPeak[ANALOG_INPUTS]; // largest deviation since last report
+extern volatile uint osAnalogInputRound; // completed sampling rounds
+#endif
 #endif
 #define PWM_HEATED_BED    NUM_EXTRUDER
 #define PWM_BOARD_FAN     PWM_HEATED_BED + 1
@@ -920,6 +1200,9 @@ extern volatile uint osAnalogInputValues[ANALOG_INPUTS];
 #define PWM_FAN_THERMO    PWM_FAN2 + 1
 #define NUM_PWM           PWM_FAN_THERMO + 1
 extern uint8_t pwm_pos[NUM_PWM]; // 0-NUM_EXTRUDER = Heater 0-NUM_EXTRUDER of extruder, NUM_EXTRUDER = Heated bed, NUM_EXTRUDER+1 Board fan, NUM_EXTRUDER+2 = Fan
+#if HEATER_SCHEDULER
+extern uint8_t heaterPhase[PWM_HEATED_BED + 1]; // pwm counter value where the heater switches on
+#endif
 #if USE_ADVANCE
 #if ENABLE_QUADRATIC_ADVANCE
 extern int maxadv;
@@ -929,6 +1212,10 @@ extern float maxadvspeed;
 #endif
 
 
+#include "TemperatureTable.h"
+#include "TemperatureModel.h"
+#include "MixingExtruder.h"
+#include "CompiledJob.h"
 #include "Extruder.h"
 
 void manage_inactivity(uint8_t debug);
@@ -960,6 +1247,7 @@ extern void microstepInit();
 
 #include "Printer.h"
 #include "motion.h"
+#include "Bezier.h"
 extern long baudrate;
 
 // #include "HAL.h"
@@ -983,6 +1271,38 @@ extern char fullName[LONG_FILENAME_LENGTH*SD_MAX_FOLDER_DEPTH+SD_MAX_FOLDER_DEPT
 #include "src/SdFat/SdFat.h"
 
 enum LsAction {LS_SerialPrint,LS_Count,LS_GetFilename};
+#if SD_CHECKPOINT
+#define SD_CHECKPOINT_PATH (LONG_FILENAME_LENGTH * (SD_MAX_FOLDER_DEPTH + 1) + SD_MAX_FOLDER_DEPTH + 2)
+/** Job state stored in one block of the checkpoint file. */
+struct SDCheckpoint {
+    uint32_t magic;
+    uint32_t sequence;      ///< Highest valid sequence is the latest checkpoint
+    uint32_t offset;        ///< Start of first command with unfinished moves, 0xffffffff = job done
+    uint32_t filesize;
+    float pos[3];           ///< Position in global coordinates
+    float coordinateOffset[3];
+    float e;                ///< E position in file coordinates
+    float feedrate;         ///< Feedrate in mm/s
+    float temperature[NUM_EXTRUDER + 1]; ///< Target temperatures, last is bed
+    int16_t feedrateMultiply;
+    int16_t extrudeMultiply;
+    uint8_t fanSpeed;
+    uint8_t tool;
+    uint8_t flags;          ///< 1 = relative e, 2 = relative coordinates
+    char path[SD_CHECKPOINT_PATH];
+    uint32_t checksum;
+};
+static_assert(sizeof(SDCheckpoint) <= 512, "SDCheckpoint must fit into one sd block, reduce MAX_VFAT_ENTRIES");
+#endif
+#if SD_LAYER_INDEX
+struct SDLayerEntry {
+    uint32_t offset; ///< File position of the line moving to the layer
+    float z;         ///< Layer height in file coordinates
+    float e;         ///< E position in file coordinates before offset
+    float f;         ///< Feedrate in mm/min active before offset
+    uint8_t flags;   ///< 1 = relative e, 2 = relative coordinates
+};
+#endif
 class SDCard
 {
 public:
@@ -1005,6 +1325,9 @@ public:
     //int16_t n;
     bool savetosd;
     SdBaseFile parentFound;
+#if SD_DIR_INDEX
+    uint8_t dirGeneration; // changes when files get added or removed
+#endif
 
     SDCard();
     void initsd();
@@ -1016,24 +1339,83 @@ public:
     void pausePrint(bool intern = false);
     void continuePrint(bool intern = false);
     void stopPrint();
+#if SD_COMPILED_JOBS
+    bool compiledJob; // selected file starts with a M37 header
+#endif
     inline void setIndex(uint32_t  newpos)
     {
         if(!sdactive) return;
         sdpos = newpos;
         file.seekSet(sdpos);
+#if SD_READ_BUFFERS
+        resetReadBuffers();
+#endif
+#if SD_COMPILED_JOBS
+        GCode::resetPackedCoordinates();
+#endif
+#if SD_PARSE_AHEAD
+        GCode::resetReadAheadSD();
+#endif
+#if TOOLCHANGE_PREHEAT
+        resetToolchangeScan();
+#endif
+#if SD_CHECKPOINT
+        checkpointStart = newpos;
+        checkpointPending = false;
+#endif
+#if SD_LAYER_INDEX
+        layerCursor = 0; // progress catches up in layerIndexStep
+        layerNextOffset = 0xffffffffUL;
+#endif
+    }
+#if TOOLCHANGE_PREHEAT
+    uint32_t toolchangePos; ///< File position of next tool change found by scanToolchange
+    int8_t scanToolchange();
+    void resetToolchangeScan();
+#endif
+#if SD_READ_BUFFERS
+    /** Returns the next byte of the print file or -1 on read errors. */
+    inline int readByte()
+    {
+        if(readBufferPos >= readBufferFill[readBufferActive] && !nextReadBuffer())
+            return -1;
+        sdpos++;
+        return readBuffer[readBufferActive][readBufferPos++];
     }
+    void resetReadBuffers();
+    void prefetch();
+#endif
+#if SD_LAYER_INDEX
+    void layerIndexStep();
+    bool seekLayer(int32_t layer, float z);
+#endif
+#if SD_CHECKPOINT
+    void checkpointCommand(GCode *com);
+    void checkpointStep();
+    void finishCheckpoint();
+    void reportCheckpoint();
+    bool resumeCheckpoint();
+#endif
     void printStatus();
     void ls();
 #if JSON_OUTPUT
     void lsJSON(const char *filename);
     void JSONFileInfo(const char *filename);
+#if SD_INFO_CACHE
+    bool cachedFileInfo(FatFile *dir, SdFile &target, GCodeFileInfo *info, bool onlyMissing = false);
+    void infoCacheBuild();
+    FatFile infoCacheDir; ///< Directory completed in the background
+#endif
     static void printEscapeChars(const char *s);
 #endif
-    void startWrite(char *filename);
+    void startWrite(char *filename, uint32_t announcedSize = 0);
     void deleteFile(char *filename);
     void finishWrite();
     char *createFilename(char *buffer,const dir_t &p);
     void makeDirectory(char *filename);
+#if SD_ESTIMATE
+    void estimateFile(const char *filename);
+#endif
     bool showFilename(const uint8_t *name);
     void automount();
 #ifdef GLENN_DEBUG
@@ -1041,6 +1423,76 @@ public:
 #endif
 private:
     uint8_t lsRecursive(SdBaseFile *parent,uint8_t level,char *findFilename);
+#if SD_INFO_CACHE || SD_LAYER_INDEX
+    bool openParentDir(FatFile &dir, const char *filename);
+#endif
+#if SD_WRITE_BLOCKS
+    uint8_t writeBuffer[SD_WRITE_BLOCKS * 512]; // M28 data not yet written
+    uint16_t writeFill;
+    bool writePipeline; // writes go through writeBuffer
+    millis_t writeStartTime;
+    void flushWriteBuffer();
+#endif
+    void writeBytes(uint8_t *buf, uint8_t len);
+#if SD_CHECKPOINT
+    char checkpointPath[SD_CHECKPOINT_PATH]; // absolute path of selected file
+    uint32_t checkpointBlock; // first block of checkpoint file, 0 = none
+    uint32_t checkpointSequence;
+    uint32_t checkpointStart; // end of last executed sd command
+    uint32_t checkpointOffset; // resume offset of pending checkpoint
+    uint32_t checkpointLines; // moves to finish before pending checkpoint is valid
+    bool checkpointPending;
+    float checkpointPos[4]; // x, y, z and e of pending checkpoint
+    float checkpointFeedrate;
+    uint8_t checkpointFlags;
+    millis_t checkpointNext; // earliest time for next checkpoint
+    uint32_t checkpointWrites;
+    uint16_t checkpointLastMs, checkpointMaxMs;
+    void startCheckpoint(bool create);
+    bool readCheckpoint(SDCheckpoint &cp);
+    void writeCheckpoint();
+#endif
+#if SD_LAYER_INDEX
+    FatFile layerIndex; // index file of selected file
+    FatFile layerScanFile; // second read handle of the selected file for the layer scan
+    int32_t layerCount; // layers indexed
+    bool layerReady; // index complete
+    int32_t layerCursor; // layer being printed
+    uint32_t layerNextOffset; // start of layer after layerCursor
+    uint32_t layerScanPos; // next byte to scan
+    uint32_t layerLineStart;
+    uint8_t layerLineLength;
+    bool layerComment; // rest of line is a comment
+    char layerLine[MAX_CMD_SIZE];
+    float layerCurZ, layerCurE, layerFeedrate; // file state at scan position
+    float layerZ; // height of last indexed layer
+    uint8_t layerFlags; // 1 = relative e, 2 = relative coordinates
+    SDLayerEntry layerPending; // state before last z change
+    void startLayerIndex(const char *filename);
+    void scanLayerLine();
+    bool readLayer(int32_t layer, SDLayerEntry &entry);
+    void writeLayerHeader();
+#endif
+#if SD_COMPILED_JOBS
+    JobCompiler compiler; // packing state and header values of the job written by M28
+    void startCompile();
+    void writeJobHeader();
+    static bool readJobHeader(SdFile &f, uint8_t *header);
+#endif
+#if SD_READ_BUFFERS
+    uint8_t readBuffer[2][SD_READ_BUFFER_SIZE];
+    uint16_t readBufferFill[2]; // valid bytes in buffer, 0 = needs refill
+    uint16_t readBufferPos; // next byte in active buffer
+    uint8_t readBufferActive;
+    bool fillReadBuffer(uint8_t idx);
+    bool nextReadBuffer();
+#endif
+#if TOOLCHANGE_PREHEAT
+    FatFile toolScanFile; // second read handle of the print file for scanToolchange
+    uint32_t toolScanPos; // file position scanned up to
+    uint8_t toolScanState; // 0 = inside line, 1 = line start, 2 = T read
+    int8_t toolchangeTool;
+#endif
 // SdFile *getDirectory(char* name);
 };
 
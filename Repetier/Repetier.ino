@@ -74,7 +74,7 @@ RepRap M Codes
 - M105 - Read current temp
 - M106 S<speed> P<fan> I<ignore> - Fan on speed = 0..255, P = 0 or 1, 0 is default and can be omitted, I1 = Ignore M106/M107 from now on, I0 = disable ignore
 - M107 P<fan> - Fan off, P = 0 or 1, 0 is default and can be omitted
-- M109 - Wait for extruder current temp to reach target temp. Same params as M104
+- M109 - Wait for extruder current temp to reach target temp. Same params as M104. With PREDICTIVE_HEATUP the wait is deferred to the first extruding move
 - M114 S1 - Display current position, S1 = also write position in steps
 
 Custom M Codes
@@ -89,11 +89,15 @@ Custom M Codes
 - M24  - Start/resume SD print
 - M25  - Pause SD print
 - M26  - Set SD position in bytes (M26 S12345)
-- M27  - Report SD print status
-- M28  - Start SD write (M28 filename.g)
+- M26 L<layer> or Z<height> - Continue SD file at layer L or first layer at height Z (needs SD_LAYER_INDEX)
+- M27  - Report SD print status, with SD_LAYER_INDEX also the current layer
+- M28  - Start SD write (M28 filename.g), with SD_WRITE_BLOCKS M28 filename.g S<bytes> preallocates the file
 - M29  - Stop SD write
 - M30 <filename> - Delete file on sd card
 - M32 <dirname> create subdirectory
+- M37 P<layers> S<seconds> Z<height> E<filament> I<layerHeight> - Job header written by M28 into compiled SD jobs (needs SD_COMPILED_JOBS)
+- M38 <filename> - Estimate print time per layer and filament by planning the file without moving (needs SD_ESTIMATE)
+- M39 [S0] - Report hit rate of the SD block cache, S0 resets the counters (needs SD_BLOCK_CACHE)
 - M42 P<pin number> S<value 0..255> - Change output of pin P to S. Does not work on most important pins.
 - M80  - Turn on power supply
 - M81  - Turn off power supply
@@ -111,7 +115,7 @@ Custom M Codes
             1 = echo commands, 2 = info, 4 = errors, 8 = dry run mode, 16 = only communication, no actions 
 - M112 - Emergency kill
 - M115- Capabilities string
-- M116 - Wait for all temperatures in a +/- 1 degree range
+- M116 - Wait for all temperatures in a +/- 1 degree range. With PREDICTIVE_HEATUP the wait is deferred to the first extruding move
 - M117 <message> - Write message in status row on lcd
 - M119 - Report endstop status
 - M140 S<temp> H1 O<offset> F1 - Set bed target temp, F1 makes a beep when temperature is reached the first time
@@ -119,7 +123,7 @@ Custom M Codes
 - M163 S<extruderNum> P<weight>  - Set weight for this mixing extruder drive
 - M164 S<virtNum> P<0 = dont store eeprom,1 = store to eeprom> - Store weights as virtual extruder S
 - M170 B<bedtemp> T<extruderid> S<extrudertemp> L0 - Set preset temperatures for extruder (T+S) or bed (B) or list settings (L0)
-- M190 - Wait for bed current temp to reach target temp. Same params as M109
+- M190 - Wait for bed current temp to reach target temp. Same params as M109. With PREDICTIVE_HEATUP the wait is deferred to the first extruding move
 - M200 T<extruder> D<diameter> - Use volumetric extrusion. Set D0 or omit D to disable volumetric extr. Omit T for current extruder.
 - M201 - Set max acceleration in units/s^2 for print moves (M201 X1000 Y1000)
 - M202 - Set max acceleration in units/s^2 for travel moves (M202 X1000 Y1000)
@@ -144,6 +148,9 @@ Custom M Codes
 - M302 S<0 or 1> - allow cold extrusion. Without S parameter it will allow. S1 will allow, S0 will disallow.
 - M303 P<extruder/bed> S<printTemerature> X0 R<Repetitions> C<method>- Auto detect pid values. Use P<NUM_EXTRUDER> for heated bed. X0 saves result in EEPROM. R is number of cycles.
 				method 0 = classic, 1 = some overshoot, 2 = no overshoot, 3 = pessen, 4 = Tyreus-Lyben
+				5 = identify model for heat manager 4 (needs TEMP_MODEL_CONTROL), X0 stores model and selects heat manager 4
+				F1 fits a first order model with dead time from one heating step and a short cool-down instead of
+				relay cycles. Reports fit quality and derives PID values with method 0-4, or dead time for dead time control.
 - M320 S<0/1> - Activate auto level, S1 stores it in eeprom
 - M321 S<0/1> - Deactivate auto level, S1 stores it in eeprom
 - M322 - Reset auto level matrix
@@ -151,11 +158,15 @@ Custom M Codes
 - M340 P<servoId> S<pulseInUS> R<autoOffIn ms>: servoID = 0..3, Servos are controlled by a pulse with normally between 500 and 2500 with 1500ms in center position. 0 turns servo off. R allows automatic disabling after a while.
 - M350 S<mstepsAll> X<mstepsX> Y<mstepsY> Z<mstepsZ> E<mstepsE0> P<mstespE1> : Set micro stepping on RAMBO board
 - M355 S<0/1> - Turn case light on/off, no S = report status
+- M356 - Report mean and peak noise of analog inputs in ADC units (needs ANALOG_INPUT_FILTER)
+- M357 - Report heater current demand, used current and budget utilization (needs HEATER_SCHEDULER)
+- M358 T<extruder> S<mm^3/s> - Set max. volumetric flow, without S report the percentage of printing moves limited by it (needs VOLUMETRIC_FLOW_LIMIT)
 - M360 - show configuration
 - M400 - Wait until move buffers empty.
 - M401 - Store x, y and z position.
 - M402 - Go to stored position. If X, Y or Z is specified, only these coordinates are used. F changes feedrate for that move.
 - M408 S<0-5> - Return status as json string (requires matching feature) for PanelDue
+- M413 - Report power loss checkpoint and its write times, M413 S1 resumes the job (needs SD_CHECKPOINT)
 - M450 - Reports printer mode
 - M451 - Set printer mode to FFF
 - M452 - Set printer mode to laser
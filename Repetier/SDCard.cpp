@@ -34,6 +34,9 @@ SDCard::SDCard() {
     sdmode = 0;
     sdactive = false;
     savetosd = false;
+#if SD_DIR_INDEX
+    dirGeneration = 0;
+#endif
     Printer::setAutomount(false);
 }
 
@@ -109,6 +112,9 @@ void SDCard::initsd() {
     }
     Com::printFLN(PSTR("Card successfully initialized."));
     sdactive = true;
+#if SD_DIR_INDEX
+    dirGeneration++;
+#endif
     Printer::setMenuMode(MENU_MODE_SD_MOUNTED, true);
     HAL::pingWatchdog();
 
@@ -132,6 +138,23 @@ void SDCard::unmount() {
     sdmode = 0;
     sdactive = false;
     savetosd = false;
+#if SD_DIR_INDEX
+    dirGeneration++;
+#endif
+#if SD_INFO_CACHE
+    infoCacheDir.close();
+#endif
+#if SD_LAYER_INDEX
+    layerIndex.close();
+    layerScanFile.close();
+#endif
+#if TOOLCHANGE_PREHEAT
+    toolScanFile.close();
+#endif
+#if SD_CHECKPOINT
+    checkpointBlock = 0;
+    checkpointPending = false;
+#endif
     Printer::setAutomount(false);
     Printer::setMenuMode(MENU_MODE_SD_MOUNTED + MENU_MODE_PAUSED + MENU_MODE_SD_PRINTING, false);
 #if UI_DISPLAY_TYPE != NO_DISPLAY && SDSUPPORT
@@ -150,12 +173,135 @@ void SDCard::startPrint() {
     Printer::setPrinting(true);
     Printer::maxLayer = 0;
     Printer::currentLayer = 0;
+#if SD_LAYER_INDEX
+    if(layerReady)
+        Printer::maxLayer = layerCount;
+    Printer::currentLayer = layerCursor;
+#endif
+#if SD_CHECKPOINT
+    startCheckpoint(true);
+#endif
     UI_STATUS_F(PSTR(""));
 #if NEW_COMMUNICATION
     GCodeSource::registerSource(&sdSource);
 #endif
 }
 
+#if SD_READ_BUFFERS
+void SDCard::resetReadBuffers() {
+    readBufferFill[0] = readBufferFill[1] = 0;
+    readBufferPos = 0;
+    readBufferActive = 0;
+}
+
+/** Reads the next chunk of the file into buffer idx. Chunks end at multiples of
+SD_READ_BUFFER_SIZE, so after the first one all reads are block aligned. */
+bool SDCard::fillReadBuffer(uint8_t idx) {
+    uint32_t pos = file.curPosition();
+    if(pos >= filesize) return false;
+    uint16_t size = SD_READ_BUFFER_SIZE - (pos & (SD_READ_BUFFER_SIZE - 1));
+    int n = file.read(readBuffer[idx], size);
+    if(n <= 0) {
+        Com::printFLN(Com::tSDReadError);
+        UI_ERROR("SD Read Error");
+        // Second try in case of recoverable errors
+        file.seekSet(pos);
+        n = file.read(readBuffer[idx], size);
+        if(n <= 0) {
+            Com::printErrorFLN(PSTR("SD error did not recover!"));
+            return false;
+        }
+        UI_ERROR("SD error fixed");
+    }
+    readBufferFill[idx] = n;
+    return true;
+}
+
+/** Switches to the other buffer once the active one is consumed. */
+bool SDCard::nextReadBuffer() {
+    if(readBufferFill[readBufferActive] != 0) {
+        readBufferFill[readBufferActive] = 0;
+        readBufferActive ^= 1;
+    }
+    readBufferPos = 0;
+    return readBufferFill[readBufferActive] != 0 || fillReadBuffer(readBufferActive);
+}
+
+/** Refills the buffer not being parsed. Called while the firmware waits anyway. */
+void SDCard::prefetch() {
+    if(sdmode != 1) return;
+    uint8_t idx = readBufferActive ^ 1;
+    if(readBufferFill[idx] == 0 && readBufferFill[readBufferActive] != 0)
+        fillReadBuffer(idx);
+}
+#endif
+
+#if TOOLCHANGE_PREHEAT
+void SDCard::resetToolchangeScan() {
+    toolScanPos = sdpos;
+    toolScanState = (sdpos == 0 ? 1 : 0);
+    toolchangeTool = -1;
+}
+
+/** Scans the file ahead of the read position for the next T command. Reads the rest of
+the current block in chunks of TOOLCHANGE_SCAN_CHUNK bytes per call, chunks never cross a
+block. Uses its own handle toolScanFile, so the position of the print file stays untouched.
+Seeks stay within the block, only jumps of the print position seek further.
+Returns the tool or -1 if none was found yet. */
+int8_t SDCard::scanToolchange() {
+    if(sdmode != 1 || !toolScanFile.isOpen()) return -1;
+    if(toolchangeTool >= 0) {
+        if(toolchangePos >= sdpos) return toolchangeTool;
+        toolchangeTool = -1; // already read, search next one
+    }
+#if SD_READ_BUFFERS
+    // The read buffers already hold the file up to the file position. Tool changes in them
+    // come too late for a preheat, and rereading them costs card reads.
+    uint32_t readPos = file.curPosition();
+#else
+    uint32_t readPos = sdpos;
+#endif
+    if(toolScanPos < readPos) {
+        toolScanPos = readPos;
+        toolScanState = 0;
+    }
+    if(toolScanPos >= filesize || toolScanPos - sdpos > TOOLCHANGE_SCAN_BYTES) return -1;
+    if(toolScanFile.curPosition() != toolScanPos && !toolScanFile.seekSet(toolScanPos))
+        return -1;
+    uint8_t buf[TOOLCHANGE_SCAN_CHUNK];
+    do {
+        uint16_t size = 512 - (toolScanPos & 511);
+        int n = toolScanFile.read(buf, size < TOOLCHANGE_SCAN_CHUNK ? size : TOOLCHANGE_SCAN_CHUNK);
+        if(n <= 0) return -1;
+        for(int i = 0; i < n; i++) {
+            uint8_t c = buf[i];
+            if(c == '\n' || c == '\r')
+                toolScanState = 1;
+            else if(toolScanState == 1) {
+                if(c & 128) { // binary file, nothing to find
+                    toolScanPos = filesize;
+                    return -1;
+                }
+                if(c == 'T')
+                    toolScanState = 2;
+                else if(c != ' ' && c != '\t')
+                    toolScanState = 0;
+            } else if(toolScanState == 2) {
+                toolScanState = 0;
+                if(c >= '0' && c <= '9') {
+                    toolchangePos = toolScanPos + i;
+                    toolScanPos += i + 1;
+                    toolchangeTool = c - '0';
+                    return toolchangeTool;
+                }
+            }
+        }
+        toolScanPos += n;
+    } while((toolScanPos & 511) != 0 && toolScanPos < filesize); // block is in the cache now
+    return -1;
+}
+#endif
+
 void SDCard::pausePrint(bool intern) {
     if(!sdactive) return;
     sdmode = 2; // finish running line
@@ -169,6 +315,9 @@ void SDCard::pausePrint(bool intern) {
     if(EVENT_SD_PAUSE_START(intern)) {
         if(intern) {
             Commands::waitUntilEndOfAllBuffers();
+#if RETRACT_ON_TRAVEL
+            Extruder::flushRetractTravel(); // nothing left to merge with
+#endif
             //sdmode = 0; // why ?
             Printer::MemoryPosition();
             Printer::moveToReal(IGNORE_COORDINATE, IGNORE_COORDINATE, IGNORE_COORDINATE,
@@ -213,6 +362,12 @@ void SDCard::stopPrint() {
     Printer::setPrinting(0);
 #if NEW_COMMUNICATION
     GCodeSource::removeSource(&sdSource);
+#endif
+#if SD_PARSE_AHEAD
+    GCode::resetReadAheadSD();
+#endif
+#if SD_CHECKPOINT
+    finishCheckpoint(); // no resume of aborted jobs
 #endif
     if(EVENT_SD_STOP_START) {
         GCode::executeFString(PSTR(SD_RUN_ON_STOP));
@@ -224,168 +379,80 @@ void SDCard::stopPrint() {
     EVENT_SD_STOP_END;
 }
 
+#if SD_COMPILED_JOBS
+void SDCard::startCompile() {
+    compiler.start();
+    writeJobHeader(); // placeholder, rewritten by finishWrite
+}
+
+/** Writes the M37 job header. Has always SD_JOB_HEADER_SIZE bytes. */
+void SDCard::writeJobHeader() {
+    GCode code;
+    compiler.header(code);
+    compiler.valid = 0; // unpacked, so the size never changes
+    writeCommand(&code);
+    compiler.valid = 0; // header values are no base for packed coordinates
+}
+
+/** Reads the M37 header of a compiled job into header. Returns false for
+plain gcode files. Leaves the file position at 0. */
+bool SDCard::readJobHeader(SdFile &f, uint8_t *header) {
+    bool ok = false;
+    f.seekSet(0);
+    if(f.read(header, SD_JOB_HEADER_SIZE) == SD_JOB_HEADER_SIZE)
+        ok = JobCompiler::isHeader(header);
+    f.seekSet(0);
+    return ok;
+}
+#endif
+
+/** Writes code in binary format, packed in compiled jobs. The encoding is in
+CompiledJob.h, shared with tools/gcode_compile. */
 void SDCard::writeCommand(GCode *code) {
-    unsigned int sum1 = 0, sum2 = 0; // for fletcher-16 checksum
     uint8_t buf[100];
-    uint8_t p = 2;
     file.clearWriteError();
-    uint16_t params = 128 | (code->params & ~1);
-    memcopy2(buf, &params);
-    //*(int*)buf = params;
-    if(code->isV2()) { // Read G,M as 16 bit value
-        memcopy2(&buf[p], &code->params2);
-        //*(int*)&buf[p] = code->params2;
-        p += 2;
-        if(code->hasString())
-            buf[p++] = strlen(code->text);
-        if(code->hasM()) {
-            memcopy2(&buf[p], &code->M);
-            //*(int*)&buf[p] = code->M;
-            p += 2;
-        }
-        if(code->hasG()) {
-            memcopy2(&buf[p], &code->G);
-            //*(int*)&buf[p]= code->G;
-            p += 2;
-        }
-    } else {
-        if(code->hasM()) {
-            buf[p++] = (uint8_t)code->M;
-        }
-        if(code->hasG()) {
-            buf[p++] = (uint8_t)code->G;
-        }
-    }
-    if(code->hasX()) {
-        memcopy4(&buf[p], &code->X);
-        //*(float*)&buf[p] = code->X;
-        p += 4;
-    }
-    if(code->hasY()) {
-        memcopy4(&buf[p], &code->Y);
-        //*(float*)&buf[p] = code->Y;
-        p += 4;
-    }
-    if(code->hasZ()) {
-        memcopy4(&buf[p], &code->Z);
-        //*(float*)&buf[p] = code->Z;
-        p += 4;
-    }
-    if(code->hasE()) {
-        memcopy4(&buf[p], &code->E);
-        //*(float*)&buf[p] = code->E;
-        p += 4;
-    }
-    if(code->hasF()) {
-        memcopy4(&buf[p], &code->F);
-        //*(float*)&buf[p] = code->F;
-        p += 4;
-    }
-    if(code->hasT()) {
-        buf[p++] = code->T;
-    }
-    if(code->hasS()) {
-        memcopy4(&buf[p], &code->S);
-        //*(int32_t*)&buf[p] = code->S;
-        p += 4;
-    }
-    if(code->hasP()) {
-        memcopy4(&buf[p], &code->P);
-        //*(int32_t*)&buf[p] = code->P;
-        p += 4;
-    }
-    if(code->hasI()) {
-        memcopy4(&buf[p], &code->I);
-        //*(float*)&buf[p] = code->I;
-        p += 4;
-    }
-    if(code->hasJ()) {
-        memcopy4(&buf[p], &code->J);
-        //*(float*)&buf[p] = code->J;
-        p += 4;
-    }
-    if(code->hasR()) {
-        memcopy4(&buf[p], &code->R);
-        //*(float*)&buf[p] = code->R;
-        p += 4;
-    }
-    if(code->hasD()) {
-        memcopy4(&buf[p], &code->D);
-        //*(float*)&buf[p] = code->D;
-        p += 4;
-    }
-    if(code->hasC()) {
-        memcopy4(&buf[p], &code->C);
-        //*(float*)&buf[p] = code->C;
-        p += 4;
-    }
-    if(code->hasH()) {
-        memcopy4(&buf[p], &code->H);
-        //*(float*)&buf[p] = code->H;
-        p += 4;
-    }
-    if(code->hasA()) {
-        memcopy4(&buf[p], &code->A);
-        //*(float*)&buf[p] = code->A;
-        p += 4;
-    }
-    if(code->hasB()) {
-        memcopy4(&buf[p], &code->B);
-        //*(float*)&buf[p] = code->B;
-        p += 4;
-    }
-    if(code->hasK()) {
-        memcopy4(&buf[p], &code->K);
-        //*(float*)&buf[p] = code->K;
-        p += 4;
-    }
-    if(code->hasL()) {
-        memcopy4(&buf[p], &code->L);
-        //*(float*)&buf[p] = code->L;
-        p += 4;
-    }
-    if(code->hasO()) {
-        memcopy4(&buf[p], &code->O);
-        //*(float*)&buf[p] = code->O;
-        p += 4;
-    }
-    if(code->hasString()) { // read 16 uint8_t into string
-        char *sp = code->text;
-        if(code->isV2()) {
-            uint8_t i = strlen(code->text);
-            for(; i; i--) buf[p++] = *sp++;
-        } else {
-            for(uint8_t i = 0; i < 16; ++i) buf[p++] = *sp++;
-        }
-    }
-    uint8_t *ptr = buf;
-    uint8_t len = p;
-    while (len) {
-        uint8_t tlen = len > 21 ? 21 : len;
-        len -= tlen;
-        do {
-            sum1 += *ptr++;
-            if(sum1 >= 255) sum1 -= 255;
-            sum2 += sum1;
-            if(sum2 >= 255) sum2 -= 255;
-        } while (--tlen);
-    }
-    buf[p++] = sum1;
-    buf[p++] = sum2;
-    // Debug
-    /*Com::printF(PSTR("Buf: "));
-    for(int i=0;i<p;i++)
-    Com::printF(PSTR(" "),(int)buf[i]);
-    Com::println();*/
-    if(params == 128) {
+#if SD_COMPILED_JOBS
+    uint8_t len = encodeBinaryCommand(code, buf, &compiler);
+#else
+    uint8_t len = encodeBinaryCommand(code, buf, static_cast<JobCompiler *>(NULL));
+#endif
+    if(len == 0) {
         Com::printErrorFLN(Com::tAPIDFinished);
     } else
-        file.write(buf, p);
+        writeBytes(buf, len);
     if (file.getWriteError()) {
         Com::printFLN(Com::tErrorWritingToFile);
     }
 }
 
+void SDCard::writeBytes(uint8_t *buf, uint8_t len) {
+#if SD_WRITE_BLOCKS
+    if(writePipeline) {
+        while(len > 0) {
+            uint16_t n = RMath::min(static_cast<uint16_t>(len), static_cast<uint16_t>(sizeof(writeBuffer) - writeFill));
+            memcpy(&writeBuffer[writeFill], buf, n);
+            writeFill += n;
+            buf += n;
+            len -= n;
+            if(writeFill == sizeof(writeBuffer))
+                flushWriteBuffer();
+        }
+        return;
+    }
+#endif
+    file.write(buf, len);
+}
+
+#if SD_WRITE_BLOCKS
+/** Writes the collected data. Full buffers start block aligned, so SdFat sends
+them with one multi block write without using its cache. */
+void SDCard::flushWriteBuffer() {
+    if(writeFill == 0) return;
+    file.write(writeBuffer, writeFill);
+    writeFill = 0;
+}
+#endif
+
 char *SDCard::createFilename(char *buffer, const dir_t &p) {
     char *pos = buffer, *src = (char*)p.name;
     for (uint8_t i = 0; i < 11; i++, src++) {
@@ -450,8 +517,83 @@ void SDCard::lsJSON(const char *filename) {
     Com::printF(Com::tJSONFiles);
     dir.lsJSON();
     Com::printFLN(Com::tJSONArrayEnd);
+#if SD_INFO_CACHE
+    infoCacheDir = dir; // file info of this directory will probably be requested next
+    infoCacheDir.rewind();
+#endif
 }
 
+#if SD_INFO_CACHE
+#define INFO_CACHE_RECORD (8 + sizeof(GCodeFileInfo))
+/** Gets the file info of target in dir from the .gcinfo cache of dir. Entries
+are stored at the directory index of the file and valid while name hash, size
+and date match. Missing entries get computed and stored unless a print runs.
+With onlyMissing existing entries are not read. Returns false if the info
+could neither be read nor stored. */
+bool SDCard::cachedFileInfo(FatFile *dir, SdFile &target, GCodeFileInfo *info, bool onlyMissing) {
+    uint32_t key[2];
+    dir_t entry;
+    if(!target.dirEntry(&entry)) return false;
+    key[0] = 2166136261UL; // FNV-1a hash of long name
+    target.getName(tempLongFilename, LONG_FILENAME_LENGTH);
+    for(char *s = tempLongFilename; *s; s++)
+        key[0] = (key[0] ^ static_cast<uint8_t>(*s)) * 16777619UL;
+    key[1] = (static_cast<uint32_t>(entry.lastWriteDate) << 16) | entry.lastWriteTime;
+    uint32_t pos = static_cast<uint32_t>(target.dirIndex()) * INFO_CACHE_RECORD;
+    uint8_t record[INFO_CACHE_RECORD];
+    SdFile cache;
+    if(cache.open(dir, ".gcinfo", O_READ)) {
+        bool found = cache.seekSet(pos) && cache.read(record, INFO_CACHE_RECORD) == INFO_CACHE_RECORD
+                     && memcmp(record, key, 8) == 0;
+        cache.close();
+        if(found) {
+            memcpy(info, &record[8], sizeof(GCodeFileInfo));
+            if(info->fileSize == target.fileSize()) {
+                if(onlyMissing) return false;
+                return true;
+            }
+        }
+    }
+    if(sdmode != 0 || savetosd) return false; // no writes while printing
+    info->init(target);
+    if(!cache.open(dir, ".gcinfo", O_RDWR | O_CREAT)) return true;
+    memcpy(record, key, 8);
+    memcpy(&record[8], info, sizeof(GCodeFileInfo));
+    if(cache.fileSize() < pos) { // fill gap so the record lands at its index
+        cache.seekEnd();
+        memset(tempLongFilename, 0, 16);
+        for(uint32_t i = cache.fileSize(); i < pos; i += 16)
+            cache.write(tempLongFilename, RMath::min(static_cast<uint32_t>(16), pos - i));
+    }
+    cache.seekSet(pos);
+    cache.write(record, INFO_CACHE_RECORD);
+    cache.close();
+    return true;
+}
+
+/** Adds at most one missing cache entry of the last listed directory. Only runs
+while the printer is idle, parsing a file would stall a running print. */
+void SDCard::infoCacheBuild() {
+    if(!sdactive || sdmode != 0 || savetosd || !infoCacheDir.isOpen()) return;
+    if(Printer::isPrinting() || PrintLine::linesCount != 0) return;
+    SdFile f;
+    GCodeFileInfo info;
+    while(f.openNext(&infoCacheDir, O_READ)) {
+        bool skip = f.isDir() || f.isHidden();
+        if(!skip) {
+            f.getName(tempLongFilename, LONG_FILENAME_LENGTH);
+            skip = tempLongFilename[0] == '.';
+        }
+        uint32_t next = infoCacheDir.curPosition(); // opening the cache file moves it
+        bool computed = !skip && cachedFileInfo(&infoCacheDir, f, &info, true);
+        f.close();
+        infoCacheDir.seekSet(next);
+        if(computed) return; // one file per call
+    }
+    infoCacheDir.close(); // directory complete
+}
+#endif
+
 void SDCard::printEscapeChars(const char *s) {
     for (unsigned int i = 0; i < strlen(s); ++i) {
         switch (s[i]) {
@@ -484,7 +626,13 @@ void SDCard::JSONFileInfo(const char* filename) {
             return;
         }
         info = &tmpInfo;
+#if SD_INFO_CACHE
+        FatFile dir;
+        if(!openParentDir(dir, filename) || !cachedFileInfo(&dir, targetFile, info))
+            info->init(targetFile);
+#else
         info->init(targetFile);
+#endif
     }
     if (!targetFile.isOpen()) {
         Com::printF(Com::tJSONErrorStart);
@@ -516,6 +664,456 @@ void SDCard::JSONFileInfo(const char* filename) {
 
 #endif
 
+#if SD_INFO_CACHE || SD_LAYER_INDEX
+/** Opens the directory containing filename, relative to the working directory. */
+bool SDCard::openParentDir(FatFile &dir, const char *filename) {
+    const char *slash = strrchr(filename, '/');
+    if(slash == NULL) {
+        dir = *fat.vwd();
+    } else if(slash == filename) {
+        dir.openRoot(fat.vol());
+    } else {
+        uint8_t len = RMath::min(static_cast<int>(slash - filename), static_cast<int>(sizeof(fullName) - 1));
+        memcpy(fullName, filename, len);
+        fullName[len] = 0;
+        dir.open(fat.vwd(), fullName, O_READ);
+    }
+    return dir.isOpen();
+}
+#endif
+
+#if SD_LAYER_INDEX
+#define LAYER_INDEX_MAGIC 0x3152594cUL // "LYR1"
+#define LAYER_INDEX_HEADER 16
+#define LAYER_INDEX_COMPLETE 0x80000000UL
+
+/** Opens or creates the layer index ".<name>.lyr" of the selected file. An index
+belongs to the file while size and date match. Incomplete indices get rebuilt. */
+void SDCard::startLayerIndex(const char *filename) {
+    layerIndex.close();
+    layerCount = 0;
+    layerReady = false;
+    layerCursor = 0;
+    layerNextOffset = 0xffffffffUL;
+    layerScanPos = 0;
+    layerLineStart = 0;
+    layerLineLength = 0;
+    layerComment = false;
+    layerCurZ = layerCurE = layerZ = 0;
+    layerFeedrate = 0;
+    layerFlags = 0;
+    layerPending.offset = 0;
+    layerPending.z = layerPending.e = layerPending.f = 0;
+    layerPending.flags = 0;
+    layerScanFile.close();
+    dir_t entry;
+    FatFile dir;
+    if(!file.dirEntry(&entry) || !layerScanFile.open(fat.vwd(), filename, O_READ) || !openParentDir(dir, filename)) return;
+    const char *base = strrchr(filename, '/');
+    base = (base == NULL ? filename : base + 1);
+    size_t len = strlen(base);
+    if(len + 5 > LONG_FILENAME_LENGTH) return;
+    memmove(tempLongFilename + 1, base, len); // filename may be tempLongFilename
+    tempLongFilename[0] = '.';
+    strcpy(tempLongFilename + len + 1, ".lyr");
+    uint32_t header[4], stored[4];
+    header[0] = LAYER_INDEX_MAGIC;
+    header[1] = filesize;
+    header[2] = (static_cast<uint32_t>(entry.lastWriteDate) << 16) | entry.lastWriteTime;
+    if(!layerIndex.open(&dir, tempLongFilename, O_RDWR | O_CREAT)) {
+        layerScanFile.close();
+        return;
+    }
+    if(layerIndex.read(stored, LAYER_INDEX_HEADER) == LAYER_INDEX_HEADER && memcmp(stored, header, 12) == 0
+            && (stored[3] & LAYER_INDEX_COMPLETE) != 0) {
+        layerCount = stored[3] & ~LAYER_INDEX_COMPLETE;
+        layerReady = true;
+        layerScanFile.close();
+        return;
+    }
+    layerIndex.truncate(0);
+    header[3] = 0;
+    layerIndex.write(header, LAYER_INDEX_HEADER);
+    layerIndex.sync();
+}
+
+void SDCard::writeLayerHeader() {
+    uint32_t count = layerCount | (layerReady ? LAYER_INDEX_COMPLETE : 0);
+    layerIndex.seekSet(12);
+    layerIndex.write(&count, 4);
+    layerIndex.sync();
+}
+
+bool SDCard::readLayer(int32_t layer, SDLayerEntry &entry) {
+    if(layer < 0 || layer >= layerCount) return false;
+    return layerIndex.seekSet(LAYER_INDEX_HEADER + static_cast<uint32_t>(layer) * sizeof(SDLayerEntry))
+           && layerIndex.read(&entry, sizeof(SDLayerEntry)) == sizeof(SDLayerEntry);
+}
+
+/** Tracks the state of the scanned file and adds a layer on the first extrusion
+above the last layer. The layer starts at the line that moved z there. */
+void SDCard::scanLayerLine() {
+    GCode code;
+    layerLine[layerLineLength] = 0;
+    uint32_t lineNumber = GCode::actLineNumber;
+    bool ok = code.parseAscii(layerLine, false);
+    GCode::actLineNumber = lineNumber;
+    if(!ok) return;
+    if(code.hasM()) {
+        if(code.M == 82) layerFlags &= ~1;
+        else if(code.M == 83) layerFlags |= 1;
+        return;
+    }
+    if(!code.hasG()) return;
+    if(code.G == 90) layerFlags &= ~2;
+    else if(code.G == 91) layerFlags |= 2;
+    else if(code.G == 92) {
+        if(code.hasZ()) layerCurZ = code.Z;
+        if(code.hasE()) layerCurE = code.E;
+    } else if(code.G <= 3) {
+        if(code.hasZ()) {
+            float z = (layerFlags & 2) ? layerCurZ + code.Z : code.Z;
+            if(z != layerCurZ) {
+                layerPending.offset = layerLineStart;
+                layerPending.e = layerCurE;
+                layerPending.f = layerFeedrate;
+                layerPending.flags = layerFlags;
+                layerCurZ = z;
+            }
+        }
+        if(code.hasF() && code.F > 0.1) layerFeedrate = code.F;
+        if(code.hasE()) {
+            bool extrudes;
+            if(layerFlags) { // G91 makes e relative, too
+                extrudes = code.E > 0;
+                layerCurE += code.E;
+            } else {
+                extrudes = code.E > layerCurE;
+                layerCurE = code.E;
+            }
+            if(extrudes && layerCurZ > layerZ + 0.001f) { // ignores z hops
+                layerZ = layerPending.z = layerCurZ;
+                layerIndex.seekSet(LAYER_INDEX_HEADER + static_cast<uint32_t>(layerCount) * sizeof(SDLayerEntry));
+                if(layerIndex.write(&layerPending, sizeof(SDLayerEntry)) == sizeof(SDLayerEntry))
+                    layerCount++;
+            }
+        }
+    }
+}
+
+/** Updates the current layer of a running print and scans the next bytes of the
+selected file for layer changes, SD_LAYER_SCAN_BYTES during a SD print and
+8 * SD_LAYER_SCAN_BYTES while the printer is idle. The scan reads with its own
+handle layerScanFile, so the position of the print file stays untouched. */
+void SDCard::layerIndexStep() {
+    if(!layerIndex.isOpen() || savetosd) return;
+    if(sdmode != 0) {
+        SDLayerEntry entry;
+        for(uint8_t i = 0; i < 16 && layerCursor < layerCount; i++) {
+            if(layerNextOffset == 0xffffffffUL) {
+                if(!readLayer(layerCursor, entry)) break;
+                layerNextOffset = entry.offset;
+            }
+            if(sdpos <= layerNextOffset) break;
+            Printer::currentLayer = ++layerCursor;
+            layerNextOffset = 0xffffffffUL;
+        }
+    }
+    if(layerReady || !layerScanFile.isOpen()) return;
+    if(sdmode == 0 && (Printer::isPrinting() || PrintLine::linesCount != 0)) return; // host print or moves queued
+    uint16_t budget = (sdmode != 0 ? SD_LAYER_SCAN_BYTES : 8 * SD_LAYER_SCAN_BYTES);
+    uint8_t buf[64];
+    while(budget > 0 && layerScanPos < filesize) {
+        int n = layerScanFile.read(buf, RMath::min(budget, static_cast<uint16_t>(sizeof(buf))));
+        if(n <= 0) break;
+        for(int i = 0; i < n; i++) {
+            uint8_t c = buf[i];
+            if(c == '\n' || c == '\r') {
+                if(layerLineLength > 0)
+                    scanLayerLine();
+                layerLineLength = 0;
+                layerComment = false;
+                layerLineStart = layerScanPos + i + 1;
+            } else if(layerLineLength == 0 && (c & 128)) { // binary file, no layers to find
+                layerScanFile.close();
+                layerIndex.close();
+                return;
+            } else if(c == ';')
+                layerComment = true;
+            else if(!layerComment && layerLineLength < MAX_CMD_SIZE - 1)
+                layerLine[layerLineLength++] = c;
+        }
+        layerScanPos += n;
+        budget -= n;
+    }
+    if(layerScanPos >= filesize) {
+        if(layerLineLength > 0)
+            scanLayerLine();
+        layerReady = true;
+        layerScanFile.close();
+        writeLayerHeader();
+        if(Printer::isMenuMode(MENU_MODE_SD_PRINTING)) // running or paused print
+            Printer::maxLayer = layerCount;
+    }
+}
+
+/** Continues the selected file at a layer, given by number starting with 1 or
+by the first layer at or above height z. Restores e position, feedrate and
+coordinate modes of the file at that position. */
+bool SDCard::seekLayer(int32_t layer, float z) {
+    SDLayerEntry entry;
+    if(!sdactive || !layerIndex.isOpen() || layerCount == 0) return false;
+    if(layer <= 0) { // binary search first layer with entry.z >= z
+        int32_t lo = 0, hi = layerCount - 1;
+        while(lo < hi) {
+            int32_t mid = (lo + hi) >> 1;
+            if(!readLayer(mid, entry)) return false;
+            if(entry.z < z - 0.001f) lo = mid + 1;
+            else hi = mid;
+        }
+        layer = lo + 1;
+    }
+    if(!readLayer(layer - 1, entry) || entry.z < z - 0.001f) return false;
+    setIndex(entry.offset);
+    Printer::relativeExtruderCoordinateMode = (entry.flags & 1) != 0;
+    Printer::relativeCoordinateMode = (entry.flags & 2) != 0;
+    Printer::destinationSteps[E_AXIS] = Printer::currentPositionSteps[E_AXIS] = Printer::convertToMM(entry.e) * Printer::axisStepsPerMM[E_AXIS];
+    if(entry.f > 0.1)
+        Printer::feedrate = entry.f * (float)Printer::feedrateMultiply * 0.00016666666f;
+    layerCursor = layer;
+    Printer::currentLayer = layer;
+    Com::printF(PSTR("Layer:"), layer);
+    Com::printF(PSTR(" Z:"), entry.z, 3);
+    Com::printFLN(PSTR(" Byte:"), entry.offset);
+    return true;
+}
+#endif
+
+#if SD_CHECKPOINT
+#define CHECKPOINT_MAGIC 0x31504b43UL // "CKP1"
+#define CHECKPOINT_DONE 0xffffffffUL
+
+static uint32_t checkpointChecksum(const SDCheckpoint *cp) {
+    const uint8_t *p = reinterpret_cast<const uint8_t*>(cp);
+    const uint8_t *end = reinterpret_cast<const uint8_t*>(&cp->checksum);
+    uint32_t h = 2166136261UL; // FNV-1a
+    while(p < end)
+        h = (h ^ *p++) * 16777619UL;
+    return h;
+}
+
+/** Finds the blocks of /.checkpoint, creating it if requested. The file must be
+contiguous so checkpoints get written as raw blocks without touching the FAT. */
+void SDCard::startCheckpoint(bool create) {
+    if(checkpointBlock == 0) {
+        FatFile root, f;
+        uint32_t first, last;
+        if(!root.openRoot(fat.vol())) return;
+        bool created = false;
+        if(f.open(&root, ".checkpoint", O_RDWR) && f.fileSize() < SD_CHECKPOINT_SLOTS * 512UL)
+            f.remove(); // slot count was increased
+        if(!f.isOpen()) {
+            if(!create || !f.createContiguous(&root, ".checkpoint", SD_CHECKPOINT_SLOTS * 512UL)) return;
+            created = true;
+        }
+        bool ok = f.contiguousRange(&first, &last) && last - first + 1 >= SD_CHECKPOINT_SLOTS;
+        f.close();
+        if(!ok) {
+            Com::printErrorFLN(PSTR("Checkpoint file not contiguous"));
+            return;
+        }
+        checkpointBlock = first;
+        checkpointSequence = 0;
+        if(created) { // remove stale data of the new clusters
+            cache_t *block = fat.vol()->cacheClear();
+            if(block == NULL) return;
+            memset(block->data, 0, 512);
+            for(uint8_t i = 0; i < SD_CHECKPOINT_SLOTS; i++)
+                fat.card()->writeBlock(checkpointBlock + i, block->data);
+        } else {
+            SDCheckpoint cp;
+            readCheckpoint(cp); // continue the sequence of older jobs
+        }
+    }
+    checkpointPending = false;
+    checkpointNext = HAL::timeInMilliseconds() + SD_CHECKPOINT_INTERVAL * 1000UL;
+}
+
+/** Reads the newest valid checkpoint. */
+bool SDCard::readCheckpoint(SDCheckpoint &cp) {
+    bool found = false;
+    for(uint8_t i = 0; i < SD_CHECKPOINT_SLOTS; i++) {
+        cache_t *block = fat.vol()->cacheClear();
+        if(block == NULL || !fat.card()->readBlock(checkpointBlock + i, block->data)) return found;
+        const SDCheckpoint *slot = reinterpret_cast<const SDCheckpoint*>(block->data);
+        if(slot->magic != CHECKPOINT_MAGIC || slot->checksum != checkpointChecksum(slot)
+                || (found && slot->sequence <= cp.sequence))
+            continue;
+        memcpy(&cp, slot, sizeof(SDCheckpoint));
+        found = true;
+    }
+    if(found && cp.sequence > checkpointSequence)
+        checkpointSequence = cp.sequence;
+    return found;
+}
+
+/** Remembers the state before an sd command as next checkpoint. It gets written
+once the moves of all earlier commands are finished. */
+void SDCard::checkpointCommand(GCode *com) {
+    if(checkpointBlock != 0 && sdmode == 1 && !checkpointPending
+            && static_cast<int32_t>(HAL::timeInMilliseconds() - checkpointNext) >= 0) {
+        checkpointOffset = checkpointStart;
+        checkpointLines = PrintLine::linesPushed;
+        for(fast8_t i = 0; i < 3; i++)
+            checkpointPos[i] = Printer::lastCmdPos[i];
+        checkpointPos[E_AXIS] = Printer::currentPositionSteps[E_AXIS] * Printer::invAxisStepsPerMM[E_AXIS];
+        checkpointFeedrate = Printer::feedrate;
+        checkpointFlags = (Printer::relativeExtruderCoordinateMode ? 1 : 0) | (Printer::relativeCoordinateMode ? 2 : 0);
+        checkpointPending = true;
+    }
+    checkpointStart = com->sdPos;
+}
+
+/** Marks the job as done once all queued moves are finished. */
+void SDCard::finishCheckpoint() {
+    if(checkpointBlock == 0) return;
+    checkpointOffset = CHECKPOINT_DONE;
+    checkpointLines = PrintLine::linesPushed;
+    checkpointPending = true;
+}
+
+void SDCard::checkpointStep() {
+    if(!checkpointPending || !sdactive || savetosd) return;
+    if(static_cast<int32_t>(PrintLine::linesPushed - PrintLine::getLinesCount() - checkpointLines) < 0)
+        return; // printer did not reach the state yet
+    writeCheckpoint();
+}
+
+/** Writes the pending checkpoint into the next slot with a single block write. */
+void SDCard::writeCheckpoint() {
+    millis_t start = HAL::timeInMilliseconds();
+    checkpointPending = false;
+    cache_t *block = fat.vol()->cacheClear();
+    if(block == NULL) return;
+    memset(block->data, 0, 512);
+    SDCheckpoint *cp = reinterpret_cast<SDCheckpoint*>(block->data);
+    cp->magic = CHECKPOINT_MAGIC;
+    cp->sequence = ++checkpointSequence;
+    cp->offset = checkpointOffset;
+    cp->filesize = filesize;
+    for(fast8_t i = 0; i < 3; i++) {
+        cp->pos[i] = checkpointPos[i];
+        cp->coordinateOffset[i] = Printer::coordinateOffset[i];
+    }
+    cp->e = checkpointPos[E_AXIS];
+    cp->feedrate = checkpointFeedrate;
+    for(fast8_t i = 0; i < NUM_EXTRUDER; i++)
+        cp->temperature[i] = extruder[i].tempControl.targetTemperatureC;
+#if HAVE_HEATED_BED
+    cp->temperature[NUM_EXTRUDER] = heatedBedController.targetTemperatureC;
+#endif
+    cp->feedrateMultiply = Printer::feedrateMultiply;
+    cp->extrudeMultiply = Printer::extrudeMultiply;
+    cp->fanSpeed = Printer::fanSpeed;
+    cp->tool = Extruder::current->id;
+    cp->flags = checkpointFlags;
+    strcpy(cp->path, checkpointPath);
+    cp->checksum = checkpointChecksum(cp);
+    if(fat.card()->writeBlock(checkpointBlock + checkpointSequence % SD_CHECKPOINT_SLOTS, block->data))
+        checkpointWrites++;
+    millis_t cost = HAL::timeInMilliseconds() - start;
+    checkpointLastMs = cost;
+    if(cost > checkpointMaxMs)
+        checkpointMaxMs = cost;
+    // slow cards get fewer checkpoints, at most 0.1% of the time is spent here
+    millis_t interval = cost * 1000;
+    if(interval < SD_CHECKPOINT_INTERVAL * 1000UL)
+        interval = SD_CHECKPOINT_INTERVAL * 1000UL;
+    checkpointNext = HAL::timeInMilliseconds() + interval;
+}
+
+void SDCard::reportCheckpoint() {
+    SDCheckpoint cp;
+    startCheckpoint(false);
+    if(checkpointBlock != 0 && readCheckpoint(cp) && cp.offset != CHECKPOINT_DONE) {
+        Com::printF(PSTR("Checkpoint:"), cp.path);
+        Com::printF(PSTR(" Byte:"), cp.offset);
+        Com::printFLN(PSTR(" Z:"), cp.pos[Z_AXIS], 3);
+    } else
+        Com::printFLN(PSTR("No checkpoint"));
+    Com::printF(PSTR("Checkpoint writes:"), checkpointWrites);
+    Com::printF(PSTR(" last ms:"), static_cast<int>(checkpointLastMs));
+    Com::printFLN(PSTR(" max ms:"), static_cast<int>(checkpointMaxMs));
+}
+
+/** Continues the job of the newest checkpoint. Lifts z and homes x and y before heating up, so
+the nozzle does not ooze into the part, restores tool, fan and coordinate modes and returns to the
+saved position. */
+bool SDCard::resumeCheckpoint() {
+    SDCheckpoint cp;
+    if(!sdactive) return false;
+    if(sdmode != 0) {
+        Com::printErrorFLN(PSTR("Stop the running SD print before resuming a checkpoint"));
+        return false;
+    }
+    startCheckpoint(false);
+    if(checkpointBlock == 0 || !readCheckpoint(cp) || cp.offset == CHECKPOINT_DONE) {
+        Com::printErrorFLN(PSTR("No checkpoint"));
+        return false;
+    }
+    fat.chdir();
+    if(!selectFile(cp.path) || filesize != cp.filesize || cp.offset > filesize) {
+        Com::printErrorFLN(PSTR("Checkpoint does not match file"));
+        return false;
+    }
+#if SD_COMPILED_JOBS
+    if(compiledJob) { // checkpoints are not on keyframes, packed coordinates would miss their base
+        Com::printErrorFLN(PSTR("Compiled jobs can not resume from a checkpoint"));
+        return false;
+    }
+#endif
+    Printer::feedrateMultiply = cp.feedrateMultiply;
+    Printer::extrudeMultiply = cp.extrudeMultiply;
+#if HAVE_HEATED_BED
+    Extruder::setHeatedBedTemperature(cp.temperature[NUM_EXTRUDER]);
+#endif
+    for(fast8_t i = 0; i < NUM_EXTRUDER; i++)
+        Extruder::setTemperatureForExtruder(cp.temperature[i], i);
+#if DRIVE_SYSTEM == DELTA
+    Printer::homeAxis(true, true, true);
+#else
+    // z kept its position, x and y need homing
+    Printer::currentPosition[Z_AXIS] = cp.pos[Z_AXIS];
+    Printer::updateCurrentPositionSteps();
+    Printer::setZHomed(true);
+    PrintLine::moveRelativeDistanceInSteps(0, 0, SD_CHECKPOINT_ZLIFT * Printer::axisStepsPerMM[Z_AXIS], 0, Printer::homingFeedrate[Z_AXIS], true, true);
+    Printer::homeAxis(true, true, false);
+#endif
+#if HAVE_HEATED_BED
+    heatedBedController.waitForTargetTemperature();
+#endif
+    for(fast8_t i = 0; i < NUM_EXTRUDER; i++)
+        if(cp.temperature[i] > 0)
+            Extruder::setTemperatureForExtruder(cp.temperature[i], i, false, true);
+    Extruder::selectExtruderById(cp.tool); // tool change moves need a homed printer
+    Printer::moveToReal(cp.pos[X_AXIS], cp.pos[Y_AXIS], IGNORE_COORDINATE, IGNORE_COORDINATE, Printer::homingFeedrate[X_AXIS]);
+    Printer::moveToReal(IGNORE_COORDINATE, IGNORE_COORDINATE, cp.pos[Z_AXIS], IGNORE_COORDINATE, Printer::homingFeedrate[Z_AXIS]);
+    Commands::waitUntilEndOfAllMoves();
+    for(fast8_t i = 0; i < 3; i++)
+        Printer::lastCmdPos[i] = cp.pos[i];
+    Printer::setOrigin(cp.coordinateOffset[X_AXIS], cp.coordinateOffset[Y_AXIS], cp.coordinateOffset[Z_AXIS]);
+    Printer::destinationSteps[E_AXIS] = Printer::currentPositionSteps[E_AXIS] = cp.e * Printer::axisStepsPerMM[E_AXIS];
+    Printer::relativeExtruderCoordinateMode = (cp.flags & 1) != 0;
+    Printer::relativeCoordinateMode = (cp.flags & 2) != 0;
+    Printer::feedrate = cp.feedrate;
+    Commands::setFanSpeed(cp.fanSpeed, true);
+    setIndex(cp.offset);
+    Com::printFLN(PSTR("Resume at byte "), cp.offset);
+    startPrint();
+    return true;
+}
+#endif
+
 bool SDCard::selectFile(const char* filename, bool silent) {
     const char* oldP = filename;
 
@@ -524,6 +1122,13 @@ bool SDCard::selectFile(const char* filename, bool silent) {
     sdmode = 0;
 
     file.close();
+#if SD_LAYER_INDEX
+    layerIndex.close();
+    layerScanFile.close();
+#endif
+#if TOOLCHANGE_PREHEAT
+    toolScanFile.close();
+#endif
     // Filename for progress view
     strncpy(Printer::printName, filename, 20);
     Printer::printName[20] = 0;
@@ -542,6 +1147,40 @@ bool SDCard::selectFile(const char* filename, bool silent) {
 #endif
         sdpos = 0;
         filesize = file.fileSize();
+#if SD_PARSE_AHEAD
+        GCode::resetReadAheadSD();
+#endif
+#if SD_CHECKPOINT
+        checkpointStart = 0;
+        checkpointPending = false;
+        checkpointPath[0] = '/';
+        checkpointPath[1] = 0;
+#if UI_DISPLAY_TYPE != NO_DISPLAY
+        if(!fat.vwd()->isRoot())
+            strcpy(checkpointPath, uid.cwd);
+#endif
+        if(filename[0] == '/')
+            checkpointPath[0] = 0;
+        strncat(checkpointPath, filename, sizeof(checkpointPath) - 1 - strlen(checkpointPath));
+#endif
+#if SD_COMPILED_JOBS
+        GCode::resetPackedCoordinates();
+        {
+            uint8_t header[SD_JOB_HEADER_SIZE];
+            compiledJob = readJobHeader(file, header);
+        }
+#endif
+#if SD_READ_BUFFERS
+        file.seekSet(0); // file info may have read parts of the file
+        resetReadBuffers();
+#endif
+#if TOOLCHANGE_PREHEAT
+        resetToolchangeScan();
+        toolScanFile.open(fat.vwd(), filename, O_READ); // without it there is no file scan
+#endif
+#if SD_LAYER_INDEX
+        startLayerIndex(filename);
+#endif
         Com::printFLN(Com::tFileSelected);
         return true;
     } else {
@@ -554,31 +1193,85 @@ bool SDCard::selectFile(const char* filename, bool silent) {
 void SDCard::printStatus() {
     if(sdactive) {
         Com::printF(Com::tSDPrintingByte, sdpos);
+#if SD_LAYER_INDEX
+        Com::printF(Com::tSlash, filesize);
+        if(layerIndex.isOpen()) {
+            Com::printF(PSTR(" Layer:"), layerCursor);
+            if(layerReady)
+                Com::printF(Com::tSlash, layerCount);
+        }
+        Com::println();
+#else
         Com::printFLN(Com::tSlash, filesize);
+#endif
     } else {
         Com::printFLN(Com::tNotSDPrinting);
     }
 }
 
-void SDCard::startWrite(char *filename) {
+void SDCard::startWrite(char *filename, uint32_t announcedSize) {
     if(!sdactive) return;
     file.close();
+#if SD_LAYER_INDEX
+    layerIndex.close();
+    layerScanFile.close();
+#endif
+#if TOOLCHANGE_PREHEAT
+    toolScanFile.close();
+#endif
     sdmode = 0;
     fat.chdir();
+#if SD_WRITE_BLOCKS
+    writeFill = 0;
+    writePipeline = true;
+    writeStartTime = HAL::timeInMilliseconds();
+    if(announcedSize > 0) { // preallocate, if no contiguous space is left the file grows as usual
+        fat.remove(filename);
+        file.createContiguous(fat.vwd(), filename, announcedSize);
+    }
+    if(!file.isOpen() && !file.open(filename, O_CREAT | O_WRITE | O_TRUNC)) { // no append, data goes into preallocated space
+#elif SD_COMPILED_JOBS
+    if(!file.open(filename, O_CREAT | O_WRITE | O_TRUNC)) { // no append, header gets rewritten
+#else
     if(!file.open(filename, O_CREAT | O_APPEND | O_WRITE | O_TRUNC)) {
+#endif
         Com::printFLN(Com::tOpenFailedFile, filename);
     } else {
         UI_STATUS_F(Com::translatedF(UI_TEXT_UPLOADING_ID));
         savetosd = true;
+#if SD_DIR_INDEX
+        dirGeneration++;
+#endif
+#if SD_COMPILED_JOBS
+        startCompile();
+#endif
         Com::printFLN(Com::tWritingToFile, filename);
     }
 }
 
 void SDCard::finishWrite() {
     if(!savetosd) return; // already closed or never opened
+#if SD_WRITE_BLOCKS
+    flushWriteBuffer();
+    writePipeline = false;
+    uint32_t written = file.curPosition();
+    if(file.fileSize() > written)
+        file.truncate(written); // free unused preallocated clusters
+    millis_t duration = HAL::timeInMilliseconds() - writeStartTime;
+    Com::printF(PSTR("Upload bytes:"), written);
+    Com::printF(PSTR(" ms:"), static_cast<uint32_t>(duration));
+    Com::printFLN(PSTR(" bytes/s:"), static_cast<uint32_t>(duration > 0 ? written * 1000.0f / duration : 0));
+#endif
+#if SD_COMPILED_JOBS
+    file.seekSet(0);
+    writeJobHeader();
+#endif
     file.sync();
     file.close();
     savetosd = false;
+#if SD_DIR_INDEX
+    dirGeneration++; // new modification date
+#endif
     Com::printFLN(Com::tDoneSavingFile);
     UI_CLEAR_STATUS;
 }
@@ -587,6 +1280,9 @@ void SDCard::deleteFile(char *filename) {
     if(!sdactive) return;
     sdmode = 0;
     file.close();
+#if SD_DIR_INDEX
+    dirGeneration++;
+#endif
     if(fat.remove(filename)) {
         Com::printFLN(Com::tFileDeleted);
     } else {
@@ -601,6 +1297,9 @@ void SDCard::makeDirectory(char *filename) {
     if(!sdactive) return;
     sdmode = 0;
     file.close();
+#if SD_DIR_INDEX
+    dirGeneration++;
+#endif
     if(fat.mkdir(filename)) {
         Com::printFLN(Com::tDirectoryCreated);
     } else {
@@ -608,6 +1307,200 @@ void SDCard::makeDirectory(char *filename) {
     }
 }
 
+#if SD_ESTIMATE
+#define ESTIMATE_MARKS 4
+static uint32_t estimateMarks[ESTIMATE_MARKS]; // first line of the next layers
+static float estimateMarkZ[ESTIMATE_MARKS];
+static uint8_t estimateMarkCount;
+static uint16_t estimateLayer;
+static float estimateLayerZ, estimateLayerStart;
+
+// Call with interrupts disabled
+static void estimateActivateMark() {
+    PrintLine::estimateMark = estimateMarks[0];
+    if(PrintLine::linesPushed - PrintLine::linesCount > estimateMarks[0]) // already dropped
+        PrintLine::estimateMarkTime = PrintLine::estimateTime;
+}
+
+static void estimateAddLayer(uint32_t mark, float z) {
+    if(estimateMarkCount == ESTIMATE_MARKS) // layers with only a few moves get merged
+        estimateMarkCount--;
+    estimateMarks[estimateMarkCount] = mark;
+    estimateMarkZ[estimateMarkCount] = z;
+    if(estimateMarkCount++ == 0) {
+        InterruptProtectedBlock noInts;
+        estimateActivateMark();
+    }
+}
+
+static void estimateReportLayer(float end) {
+    if(estimateLayer > 0) {
+        Com::printF(PSTR("Estimate Layer:"), static_cast<int32_t>(estimateLayer));
+        Com::printF(PSTR(" Z:"), estimateLayerZ, 2);
+        Com::printFLN(PSTR(" Time:"), end - estimateLayerStart, 1);
+    }
+}
+
+/** Reports all layers whose first line has been dropped by the stepper interrupt. */
+static void estimateReportLayers() {
+    while(estimateMarkCount > 0) {
+        InterruptProtectedBlock noInts;
+        if(PrintLine::linesPushed - PrintLine::linesCount <= estimateMarks[0])
+            return;
+        float t = PrintLine::estimateMarkTime;
+        float z = estimateMarkZ[0];
+        estimateMarkCount--;
+        memmove(estimateMarks, estimateMarks + 1, estimateMarkCount * sizeof(uint32_t));
+        memmove(estimateMarkZ, estimateMarkZ + 1, estimateMarkCount * sizeof(float));
+        if(estimateMarkCount > 0)
+            estimateActivateMark();
+        noInts.unprotect();
+        estimateReportLayer(t);
+        estimateLayer++;
+        estimateLayerZ = z;
+        estimateLayerStart = t; // time before first layer counts only for the total
+    }
+}
+
+/** Runs the moves of an ascii file through the path planner like a print. The
+stepper interrupt sums the trapezoid times of the planned lines and drops them
+instead of moving. Layers start with the line that moved z to the height of
+the next extrusion above the last layer. Position, modes and feedrate are
+restored afterwards, the printer does not move. */
+void SDCard::estimateFile(const char *filename) {
+    if(!sdactive) return;
+    if(sdmode != 0 || savetosd) {
+        Com::printErrorFLN(PSTR("Estimate not possible while printing"));
+        return;
+    }
+    FatFile in;
+    if(!in.open(fat.vwd(), filename, O_READ)) {
+        Com::printFLN(Com::tOpenFailedFile, filename);
+        return;
+    }
+    Commands::waitUntilEndOfAllMoves();
+    int32_t positionSteps[E_AXIS_ARRAY], destinationSteps[E_AXIS_ARRAY];
+    float position[Z_AXIS_ARRAY], cmdPos[Z_AXIS_ARRAY], offset[Z_AXIS_ARRAY];
+    memcpy(positionSteps, Printer::currentPositionSteps, sizeof(positionSteps));
+    memcpy(destinationSteps, Printer::destinationSteps, sizeof(destinationSteps));
+    memcpy(position, Printer::currentPosition, sizeof(position));
+    memcpy(cmdPos, Printer::lastCmdPos, sizeof(cmdPos));
+    memcpy(offset, Printer::coordinateOffset, sizeof(offset));
+#if NONLINEAR_SYSTEM
+    int32_t nonlinearSteps[E_TOWER_ARRAY];
+    memcpy(nonlinearSteps, Printer::currentNonlinearPositionSteps, sizeof(nonlinearSteps));
+#endif
+    float feedrate = Printer::feedrate;
+    uint8_t relative = Printer::relativeCoordinateMode;
+    uint8_t relativeE = Printer::relativeExtruderCoordinateMode;
+    uint8_t coldExtrusion = Printer::isColdExtrusionAllowed();
+    uint8_t noDestinationCheck = Printer::isNoDestinationCheck();
+    Printer::setColdExtrusionAllowed(true);
+    Printer::setNoDestinationCheck(true);
+    estimateMarkCount = 0;
+    estimateLayer = 0;
+    estimateLayerZ = estimateLayerStart = 0;
+    PrintLine::estimateTime = PrintLine::estimateMarkTime = 0;
+    PrintLine::estimateESteps = 0;
+    PrintLine::estimateMark = 0xffffffffUL;
+    PrintLine::estimating = 1;
+
+    char line[MAX_CMD_SIZE];
+    uint8_t buf[64];
+    uint8_t length = 0;
+    bool comment = false, binary = false;
+    uint32_t zMark = 0;
+    float layerZ = -1000;
+    int n;
+    do {
+        n = in.read(buf, sizeof(buf));
+        for(int i = 0; i <= n; i++) { // i == n terminates a last line without newline
+            uint8_t c = (i < n ? buf[i] : '\n');
+            if(c != '\n' && c != '\r') {
+                if(length == 0 && (c & 128)) { // compiled job, contains its own M37 estimate
+                    binary = true;
+                    break;
+                }
+                if(c == ';')
+                    comment = true;
+                else if(!comment && length < MAX_CMD_SIZE - 1)
+                    line[length++] = c;
+                continue;
+            }
+            if(length == 0) {
+                comment = false;
+                continue;
+            }
+            line[length] = 0;
+            length = 0;
+            comment = false;
+            GCode code;
+            uint32_t lineNumber = GCode::actLineNumber;
+            bool ok = code.parseAscii(line, false);
+            GCode::actLineNumber = lineNumber;
+            if(!ok) continue;
+            code.internalCommand = false; // no mode messages
+            if(code.hasG() && code.G == 4) { // dwell
+                InterruptProtectedBlock noInts;
+                PrintLine::estimateTime += code.getP(0) * 0.001f + code.getS(0);
+                continue;
+            }
+            if(!(code.hasG() && (code.G <= 3 || code.G == 5 || (code.G >= 90 && code.G <= 92)))
+                    && !(code.hasM() && (code.M == 82 || code.M == 83)))
+                continue; // no motion, ignored
+#if NEW_COMMUNICATION
+            code.source = GCodeSource::activeSource;
+#endif
+            uint32_t pushed = PrintLine::linesPushed;
+            float z = Printer::currentPosition[Z_AXIS];
+            int32_t e = Printer::currentPositionSteps[E_AXIS];
+            Commands::executeGCode(&code);
+            if(!code.hasG() || code.G >= 90) continue;
+            if(Printer::currentPosition[Z_AXIS] != z)
+                zMark = pushed;
+            if(Printer::currentPositionSteps[E_AXIS] > e && Printer::currentPosition[Z_AXIS] > layerZ + 0.001f) { // ignores z hops
+                layerZ = Printer::currentPosition[Z_AXIS];
+                estimateAddLayer(zMark, layerZ);
+            }
+            estimateReportLayers();
+            Commands::checkForPeriodicalActions(false);
+            GCode::keepAlive(Processing);
+        }
+    } while(n > 0 && !binary);
+    in.close();
+#if RETRACT_ON_TRAVEL
+    if(Extruder::travelTailPending || Extruder::retractPendingSteps != 0)
+        Extruder::flushRetractTravel();
+#endif
+    PrintLine::estimating = 2; // no more lines to come, drop the rest
+    Commands::waitUntilEndOfAllMoves();
+    estimateReportLayers();
+    PrintLine::estimating = 0;
+    estimateReportLayer(PrintLine::estimateTime);
+
+    memcpy(Printer::currentPositionSteps, positionSteps, sizeof(positionSteps));
+    memcpy(Printer::destinationSteps, destinationSteps, sizeof(destinationSteps));
+    memcpy(Printer::currentPosition, position, sizeof(position));
+    memcpy(Printer::lastCmdPos, cmdPos, sizeof(cmdPos));
+    memcpy(Printer::coordinateOffset, offset, sizeof(offset));
+#if NONLINEAR_SYSTEM
+    memcpy(Printer::currentNonlinearPositionSteps, nonlinearSteps, sizeof(nonlinearSteps));
+#endif
+    Printer::feedrate = feedrate;
+    Printer::relativeCoordinateMode = relative;
+    Printer::relativeExtruderCoordinateMode = relativeE;
+    Printer::setColdExtrusionAllowed(coldExtrusion);
+    Printer::setNoDestinationCheck(noDestinationCheck);
+    if(binary) {
+        Com::printFLN(PSTR("Estimate not possible for compiled jobs"));
+        return;
+    }
+    Com::printF(PSTR("Estimate Time:"), static_cast<int32_t>(PrintLine::estimateTime + 0.5f));
+    Com::printF(PSTR(" Filament:"), PrintLine::estimateESteps * Printer::invAxisStepsPerMM[E_AXIS], 1);
+    Com::printFLN(PSTR(" Layers:"), static_cast<int32_t>(estimateLayer));
+}
+#endif
+
 #ifdef GLENN_DEBUG
 void SDCard::writeToFile() {
     size_t nbyte;
@@ -640,6 +1533,17 @@ void GCodeFileInfo::init(SdFile &file) {
     this->objectHeight = 0.0;
     this->layerHeight = 0.0;
     if (!file.isOpen()) return;
+#if SD_COMPILED_JOBS
+    // Compiled jobs carry all values in the M37 header
+    uint8_t header[SD_JOB_HEADER_SIZE];
+    if(SDCard::readJobHeader(file, header)) {
+        memcopy4(&this->objectHeight, &header[6]);
+        memcopy4(&this->filamentNeeded, &header[10]);
+        memcopy4(&this->layerHeight, &header[22]);
+        strcpy_P(this->generatedBy, PSTR("M28"));
+        return;
+    }
+#endif
     bool genByFound = false, layerHeightFound = false, filamentNeedFound = false;
 #if CPU_ARCH==ARCH_AVR
 #define GCI_BUF_SIZE 120
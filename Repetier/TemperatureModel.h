@@ -0,0 +1,76 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _TEMPERATURE_MODEL_H
+#define _TEMPERATURE_MODEL_H
+
+#include <math.h>
+#include <stdint.h>
+
+/* Output of heat manager HTR_MODEL. Needs only TEMP_MODEL_HORIZON and TEMP_MODEL_AMBIENT,
+so tools/heater_sim can run it against a simulated hotend. */
+
+#if TEMP_MODEL_CONTROL
+/** Heater block as first order system with dead time. */
+struct TemperatureModel {
+    float gain; ///< Steady state temperature rise above ambient per pwm unit.
+    float timeConstant; ///< Time constant of heater block in seconds.
+    float dead; ///< Delay between heater and sensor in seconds.
+    float feedForward; ///< Additional pwm per mm/s filament speed.
+
+    /** Heater output in pwm units without integral correction and limits.
+
+    The sensor temperature is extrapolated over the dead time. Then the steady state temperature
+    is computed that moves the first order model from there to target within TEMP_MODEL_HORIZON
+    seconds. The power for that steady state plus feed-forward for the filament speed gives the
+    output.
+    \param current Current sensor temperature.
+    \param raising Temperature change of the last second.
+    \param target Target temperature.
+    \param extrusionSpeed Filament speed expected in the next seconds in mm/s.
+    */
+    inline float output(float current, float raising, float target, float extrusionSpeed) const
+    {
+        float predicted = current + raising * dead;
+        float decay = exp(-TEMP_MODEL_HORIZON / timeConstant);
+        float steady = (target - predicted * decay) / (1.0f - decay);
+        return (steady - TEMP_MODEL_AMBIENT) / gain + feedForward * extrusionSpeed;
+    }
+    /** Heater output for one control pass every 100 ms. Adds the integral correction that
+    removes model errors and updates it only while the temperature is steady, so the
+    correction does not wind up during heat up, and only while the output is not saturated.
+    \param correction Integral correction in pwm units, kept within +-TEMP_MODEL_MAX_CORRECTION.
+    */
+    inline uint8_t control(float current, float raising, float target, float extrusionSpeed, uint8_t maxOutput, float &correction) const
+    {
+        float out = output(current, raising, target, extrusionSpeed) + correction;
+        if(out > 0 && out < maxOutput && fabs(raising) < TEMP_MODEL_STEADY_RATE) {
+            correction += (target - current) * (TEMP_MODEL_CORRECTION * 0.1f);
+            if(correction > TEMP_MODEL_MAX_CORRECTION)
+                correction = TEMP_MODEL_MAX_CORRECTION;
+            else if(correction < -TEMP_MODEL_MAX_CORRECTION)
+                correction = -TEMP_MODEL_MAX_CORRECTION;
+        }
+        if(out < 0)
+            return 0;
+        return out > maxOutput ? maxOutput : static_cast<uint8_t>(out);
+    }
+};
+#endif
+
+#endif
@@ -0,0 +1,172 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _TEMPERATURE_TABLE_H
+#define _TEMPERATURE_TABLE_H
+
+#include <stdint.h>
+
+/* Conversion of raw sensor values with thermistor and PTC tables. Needs only
+ANALOG_REDUCE_BITS, so tools/temperature_test can check it on the host. */
+
+#ifndef pgm_read_word
+#define pgm_read_word(addr) (*(addr))
+#endif
+
+/** Location of a sensor table, entries are pairs of raw value and temperature in 1/8 degC. */
+struct SensorTable {
+    const int16_t *table;
+    uint8_t num; ///< Number of entries
+    bool inverted; ///< Table uses (1023 << 2) - raw
+    bool ram; ///< Generated table in ram, else in flash
+
+    inline int16_t raw(uint8_t k) const
+    {
+        return ram ? table[k << 1] : pgm_read_word(&table[k << 1]);
+    }
+    inline int16_t temp(uint8_t k) const
+    {
+        return ram ? table[(k << 1) + 1] : pgm_read_word(&table[(k << 1) + 1]);
+    }
+    /** Raw sensor value of table entry k. */
+    inline int16_t knot(uint8_t k) const
+    {
+        return inverted ? (1023 << (2 - ANALOG_REDUCE_BITS)) - raw(k) : raw(k);
+    }
+    /** Temperature in 1/8 degC for raw sensor value rawValue. Interpolates between the table
+    entries around it, below the first entry the first segment gets extrapolated and above
+    the last entry the last temperature is returned. */
+    float value(int16_t rawValue) const
+    {
+        if(inverted)
+            rawValue = (1023 << (2 - ANALOG_REDUCE_BITS)) - rawValue;
+        int16_t oldraw = raw(0);
+        int16_t oldtemp = temp(0);
+        int16_t newraw, newtemp = 0;
+        for(uint8_t i = 1; i < num; i++) {
+            newraw = raw(i);
+            newtemp = temp(i);
+            if (newraw > rawValue)
+                return oldtemp + (float)(rawValue - oldraw) * (float)(newtemp - oldtemp) / (newraw - oldraw);
+            oldtemp = newtemp;
+            oldraw = newraw;
+        }
+        // Overflow: Set to last value in the table
+        return newtemp;
+    }
+};
+
+#if FAST_TEMPERATURE_LOOKUP
+#define TEMPERATURE_LOOKUP_CELLS ((4096 >> ANALOG_REDUCE_BITS) >> TEMPERATURE_LOOKUP_SHIFT)
+
+/** \brief Lookup table for the conversion of a sensor table.
+
+The raw range is split into cells of 2^TEMPERATURE_LOOKUP_SHIFT raw units. Each cell holds
+samples of the table conversion at a power of two distance, so converting is one shift,
+two sample reads and an integer interpolation. Cells without table entries inside need
+only one sample, cells with strongly bent parts of the table get finer samples.
+*/
+class TemperatureLookup {
+public:
+    uint8_t first[TEMPERATURE_LOOKUP_CELLS]; ///< Index of the first sample of each cell
+    uint8_t shift[TEMPERATURE_LOOKUP_CELLS]; ///< Samples of the cell are 2^shift raw units apart
+    int16_t samples[TEMPERATURE_LOOKUP_SAMPLES]; ///< Temperature in 1/16 degC
+    uint8_t tolerance; ///< Maximum deviation from the table conversion in 1/16 degC
+
+    /** Temperature in 1/16 degC for raw sensor value rawValue. */
+    inline int16_t convert(int16_t rawValue) const
+    {
+        if(rawValue < 0)
+            rawValue = 0;
+        else if(rawValue >= (TEMPERATURE_LOOKUP_CELLS << TEMPERATURE_LOOKUP_SHIFT))
+            rawValue = (TEMPERATURE_LOOKUP_CELLS << TEMPERATURE_LOOKUP_SHIFT) - 1;
+        uint16_t cell = rawValue >> TEMPERATURE_LOOKUP_SHIFT;
+        uint8_t s = shift[cell];
+        uint8_t offset = rawValue & ((1 << TEMPERATURE_LOOKUP_SHIFT) - 1);
+        const int16_t *p = &samples[first[cell] + (offset >> s)];
+        return p[0] + static_cast<int16_t>(((static_cast<int32_t>(p[1]) - p[0]) * (offset & ((1 << s) - 1))) >> s);
+    }
+    /** Fills the lookup for table st. The tolerance starts at 1/8 degC and doubles until
+    all samples fit. Returns false if even 4 degC need more than TEMPERATURE_LOOKUP_SAMPLES
+    samples. */
+    bool build(const SensorTable &st)
+    {
+        for(tolerance = 2; tolerance <= 64; tolerance <<= 1) {
+            uint16_t n = 1;
+            for(uint16_t cell = 0; cell < TEMPERATURE_LOOKUP_CELLS; cell++) {
+                shift[cell] = cellShift(st, cell << TEMPERATURE_LOOKUP_SHIFT);
+                n += 1 << (TEMPERATURE_LOOKUP_SHIFT - shift[cell]);
+            }
+            if(n > TEMPERATURE_LOOKUP_SAMPLES)
+                continue;
+            n = 0;
+            for(uint16_t cell = 0; cell < TEMPERATURE_LOOKUP_CELLS; cell++) {
+                first[cell] = n;
+                for(uint8_t j = 0; j < (1 << (TEMPERATURE_LOOKUP_SHIFT - shift[cell])); j++)
+                    samples[n++] = sample(st, (cell << TEMPERATURE_LOOKUP_SHIFT) + (j << shift[cell]));
+            }
+            samples[n] = sample(st, TEMPERATURE_LOOKUP_CELLS << TEMPERATURE_LOOKUP_SHIFT);
+            return true;
+        }
+        return false;
+    }
+    /** Table conversion in 1/16 degC, limited to the int16_t range. Repeated raw values in
+    a table divide by zero, these end at the limit like all other too hot values. */
+    static int16_t sample(const SensorTable &st, int16_t rawValue)
+    {
+        float v = 2.0f * st.value(rawValue);
+        if(!(v < 32767.0f))
+            return 32767;
+        if(v < -32768.0f)
+            return -32768;
+        return static_cast<int16_t>(v < 0 ? v - 0.5f : v + 0.5f);
+    }
+private:
+    /** Largest sample distance for the cell starting at raw value start. The table conversion
+    is linear between table entries, so the interpolation error is largest at the entries
+    or, for repeated raw values, right next to them. */
+    uint8_t cellShift(const SensorTable &st, int16_t start) const
+    {
+        for(uint8_t s = TEMPERATURE_LOOKUP_SHIFT; s > 0; s--) {
+            bool fits = true;
+            for(int16_t a = start; fits && a < start + (1 << TEMPERATURE_LOOKUP_SHIFT); a += 1 << s) {
+                int16_t sa = sample(st, a);
+                int16_t sb = sample(st, a + (1 << s));
+                for(uint8_t k = 0; fits && k < st.num; k++) {
+                    // next to the entry to catch jumps of repeated raw values
+                    for(int16_t x = st.knot(k) - 1; x <= st.knot(k) + 1; x++) {
+                        if(x <= a || x >= a + (1 << s))
+                            continue;
+                        int32_t interpolated = sa + (((static_cast<int32_t>(sb) - sa) * (x - a)) >> s);
+                        int32_t error = interpolated - sample(st, x);
+                        if(error > tolerance || -error > tolerance) {
+                            fits = false;
+                            break;
+                        }
+                    }
+                }
+            }
+            if(fits)
+                return s;
+        }
+        return 0;
+    }
+};
+#endif
+
+#endif
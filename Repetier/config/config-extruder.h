@@ -15,6 +15,16 @@
  */
 #define MIXING_EXTRUDER 0
 
+/**
+ * With a mixing extruder every move keeps the mixing ratio that was set when
+ * it was queued. Ratio changes by M163 or virtual extruder selection then
+ * apply from the next queued move on without waiting for the move queue to
+ * empty, so gradients can change the ratio for every segment. The step
+ * distribution keeps its error across ratio changes. Costs 2 bytes per
+ * extruder and move cache entry.
+ */
+#define MIXING_GRADIENT 0
+
 /*
  * Minimum temperature for extruder operation
  * 
@@ -127,6 +137,24 @@
  */
 #define EXTRUDER_SWITCH_XY_SPEED 100
 
+/**
+ * Heat the next tool ahead of a tool change. The firmware looks for T commands
+ * in the command buffer and, when printing from sd card, up to
+ * TOOLCHANGE_SCAN_BYTES ahead in the file. The time until the change is
+ * estimated from the bytes per second read from the file. From
+ * TOOLCHANGE_PREHEAT_TIME seconds before the change, an idle tool with standby
+ * temperature is heated to the temperature it had when it was last active and
+ * standby temperatures sent for it are ignored. If the print passes the
+ * change without selecting the tool, it returns to its standby temperature.
+ * The file is scanned with a second file handle. With SD_READ_BUFFERS the
+ * scan starts behind the buffered bytes and the print takes the scanned
+ * blocks from the block cache, without them each scanned block replaces the
+ * cached block of the print once. Needs separate heaters.
+ */
+#define TOOLCHANGE_PREHEAT 0
+#define TOOLCHANGE_PREHEAT_TIME 30
+#define TOOLCHANGE_SCAN_BYTES 16384
+
 /** 
  * Extruder offsets in steps not mm!
  */
@@ -248,6 +276,19 @@
 #define EXT0_MAX_START_FEEDRATE 10
 #define EXT1_MAX_START_FEEDRATE 12
 
+/**
+ * Limit extrusion to the volume in mm^3/s the hotend can melt. Only moves
+ * that would extrude faster get slowed down. FILAMENT_DIAMETER is used to
+ * convert into filament speed if no diameter was set with M200.
+ * 0 = no limit for that extruder.
+ *
+ * Overridden if EEPROM activated. M358 reports how many moves were limited.
+ */
+#define VOLUMETRIC_FLOW_LIMIT 0
+#define FILAMENT_DIAMETER 1.75
+#define EXT0_MAX_VOLUMETRIC_FLOW 15
+#define EXT1_MAX_VOLUMETRIC_FLOW 15
+
 /**
  * Acceleration in mm/s^2
  * 
@@ -263,6 +304,10 @@
  * 1 = PID Temperature control. Is better but needs good PID values. Defaults
  *     are a good start for most extruder.
  * 3 = Dead-time control. PID_P becomes dead-time in seconds.
+ * 4 = Model control. Needs TEMP_MODEL_CONTROL and a model from M303 C5.
+ *
+ * M303 F1 tunes PID or dead time from one heating step and a short cool-down
+ * in a fraction of the time of the relay autotune.
  * 
  * Overridden if EEPROM activated.
 */
@@ -550,6 +595,18 @@
 #define RETRACTION_UNDO_EXTRA_LONG_LENGTH 0
 #define RETRACTION_UNDO_SPEED 20
 
+/**
+ * Merge firmware retractions into travel moves instead of stopping for them.
+ * G10 or an auto retract does not move at once. The following travel move
+ * retracts over its first RETRACT_TRAVEL_RAMP mm. The end of a travel move
+ * made while retracted is held back until the next command is known. If that
+ * is G11 or an auto unretract, the last RETRACT_TRAVEL_RAMP mm unretract.
+ * Ramps get longer if the extruder would exceed RETRACTION_SPEED or
+ * RETRACTION_UNDO_SPEED. Retractions with z lift use separate moves.
+ */
+#define RETRACT_ON_TRAVEL 0
+#define RETRACT_TRAVEL_RAMP 1.0
+
 
 /**
  * #############################################################################
@@ -609,6 +666,16 @@
  */
 #define SKIP_M109_IF_WITHIN 2
 
+/**
+ * Overlap heat-up with homing and leveling. M109, M190 and M116 only set the
+ * target and remember the wait. Following commands that do not extrude like
+ * G28, G29, G32 or probing run while the heaters approach target. The first
+ * extruding move (G0-G3 with E, G10, G11) or tool change then waits until all
+ * remembered heaters are within 1 degree of target. The remaining time is
+ * estimated from the heating rate observed so far.
+ */
+#define PREDICTIVE_HEATUP 0
+
 /**
  * Set PID scaling
  * 
@@ -632,6 +699,42 @@
  */
 #define HEATER_PWM_SPEED 1 
 
+/**
+ * Heater output scheduler. Without it all heaters switch on together at the
+ * start of a pwm period. With it each heater starts where the previous one
+ * switched off, so two heaters are never on at the same time while the sum of
+ * all duty cycles stays below 100%. Staggering needs PDM_FOR_EXTRUDER 0.
+ *
+ * If HEATER_CURRENT_BUDGET is > 0, the average current of all heaters is
+ * limited to that value in ampere. Heaters furthest below their target get
+ * power first. EXTRUDER_HEATER_CURRENT and HEATED_BED_HEATER_CURRENT are the
+ * currents in ampere of one heater when fully on. M357 reports utilization.
+ * A throttled heater postpones its decoupling test for at most
+ * HEATER_THROTTLE_HOLD ms, then the test runs as usual.
+ */
+#define HEATER_SCHEDULER 0
+#define HEATER_CURRENT_BUDGET 0
+#define HEATER_THROTTLE_HOLD 60000
+#define EXTRUDER_HEATER_CURRENT 3.4
+#define HEATED_BED_HEATER_CURRENT 11
+
+/**
+ * Analog input filter. Every oversampled reading goes through a median of the
+ * last ANALOG_INPUT_MEDIAN readings, which removes single spikes, and an IIR
+ * low pass y += (x - y) / 2^ANALOG_INPUT_IIR_SHIFT. Both run in the interrupt
+ * with integer math. ANALOG_INPUT_MEDIAN must be 1 (off), 3 or 5.
+ *
+ * Hotend sensors need fast readings, bed and chamber sensors change slowly.
+ * The bed sensor is only converted every ANALOG_BED_SAMPLE_DIVIDER round and
+ * the chamber sensor every ANALOG_THERMO_SAMPLE_DIVIDER round, so the other
+ * channels get updated more often. M356 reports noise per analog input.
+ */
+#define ANALOG_INPUT_FILTER 0
+#define ANALOG_INPUT_MEDIAN 3
+#define ANALOG_INPUT_IIR_SHIFT 2
+#define ANALOG_BED_SAMPLE_DIVIDER 4
+#define ANALOG_THERMO_SAMPLE_DIVIDER 4
+
 
 
 
@@ -792,6 +895,54 @@ If you need the generic table, uncomment the following define.
 Value is used for all generic tables created. */
 #define GENERIC_THERM_NUM_ENTRIES 33
 
+/** Convert table based sensors with a lookup table created at startup instead of
+searching the whole thermistor table. The raw range is split into cells of
+2^TEMPERATURE_LOOKUP_SHIFT raw units (5-8). Each cell holds samples of the table
+conversion at a power of two distance, so a conversion is one shift, two reads and
+an integer interpolation. Cells around strongly bent parts of the table get finer
+samples. At startup the lookup is built as exact as TEMPERATURE_LOOKUP_SAMPLES
+(at most 256) allows, starting at 1/8 degC. With the defaults all built in tables
+stay within 1/4 degC of the normal conversion (see tools/temperature_test). Ram per
+table based temperature controller is 2 * TEMPERATURE_LOOKUP_SAMPLES +
+(8192 >> TEMPERATURE_LOOKUP_SHIFT) bytes. */
+#define FAST_TEMPERATURE_LOOKUP 0
+#define TEMPERATURE_LOOKUP_SHIFT 6
+#define TEMPERATURE_LOOKUP_SAMPLES 232
+
+/** Enables heat manager 4 for extruders. It models the hotend as first order system with
+dead time, computes the heater power that reaches the target within TEMP_MODEL_HORIZON
+seconds and adds feed-forward for the filament speed of the queued moves, so flow changes
+get compensated before the temperature drops. M303 C5 identifies gain, time constant and
+dead time with the step autotune. The TEMP_MODEL_ values below are used until the model
+is stored in EEPROM.
+
+- TEMP_MODEL_GAIN: Steady state temperature rise in degC per pwm unit.
+- TEMP_MODEL_TIME_CONSTANT: Time constant of the heater block in seconds.
+- TEMP_MODEL_DEAD_TIME: Delay between heater and sensor in seconds.
+- TEMP_MODEL_FEED_FORWARD: Additional pwm per mm/s filament speed.
+- TEMP_MODEL_CORRECTION: Integral correction of model errors in pwm per degC and second.
+- TEMP_MODEL_STEADY_RATE: The correction only changes while the temperature changes less
+  than this in degC per second, so it does not wind up during heat up.
+
+The autotune does not extrude, so the feed-forward has to be measured by hand: Hold the
+target with the model, note the heater output (@: in M105) once idle and once after a few
+seconds of extruding at a known speed, e.g. G1 E50 F300 for 5 mm/s. Feed-forward is the
+output difference divided by the speed. Store it in the EEPROM entry
+"model feed-forward [pwm/(mm/s)]". tools/heater_sim compares model and PID control
+on a simulated hotend.
+*/
+#define TEMP_MODEL_CONTROL 0
+/** Ambient temperature in degC for the model and the step autotune M303 F1. */
+#define TEMP_MODEL_AMBIENT 25
+#define TEMP_MODEL_HORIZON 4
+#define TEMP_MODEL_GAIN 1.6
+#define TEMP_MODEL_TIME_CONSTANT 120
+#define TEMP_MODEL_DEAD_TIME 3
+#define TEMP_MODEL_FEED_FORWARD 6
+#define TEMP_MODEL_CORRECTION 0.5
+#define TEMP_MODEL_MAX_CORRECTION 40
+#define TEMP_MODEL_STEADY_RATE 1
+
 // uncomment the following line for MAX6675 support.
 //#define SUPPORT_MAX6675
 // uncomment the following line for MAX31855 support.
@@ -18,6 +18,84 @@ Separate commands by \n */
 #define SD_RUN_ON_STOP ""
 /** Disable motors and heaters when print was stopped. */
 #define SD_STOP_HEATER_AND_MOTORS_ON_STOP 1
+/** Read print files in chunks into two buffers instead of byte by byte. One
+buffer gets parsed while the other one is refilled when the firmware waits
+for free moves. With 512 byte buffers whole blocks are read directly without
+the copy through the SdFat cache. Needs 2 * SD_READ_BUFFER_SIZE bytes of ram,
+size must be a power of 2. */
+#define SD_READ_BUFFERS 0
+#define SD_READ_BUFFER_SIZE 512
+/** Store files uploaded with M28 as compiled jobs. The file starts with a M37
+header holding layer count, estimated time, object height, filament and layer
+height. Coordinates are stored as 16 bit deltas in um to the last value of the
+same axis where possible. Every SD_COMPILED_KEYFRAME commands and on every z
+change all coordinates are stored in full again, so M26 must point to a layer
+start. tools/gcode_compile converts G-code files into compiled jobs on the host,
+copy them to the card and print them with M23/M24. */
+#define SD_COMPILED_JOBS 0
+#define SD_COMPILED_KEYFRAME 64
+/** Keep the file info returned by M36 in a hidden .gcinfo file per directory.
+Entries are found by directory position and checked against name, size and
+date, so a query needs only one record read. Missing entries of the last
+listed directory are added in the background while no print runs. Needs
+JSON_OUTPUT. */
+#define SD_INFO_CACHE 0
+/** Index the layers of the selected ASCII file in the background. For every
+layer the byte position, z height, e position and feedrate are stored in a
+hidden file "." + filename + ".lyr" next to the file, so the index survives
+failed prints. M26 L<layer> or M26 Z<height> then continue a job at a layer
+and M27 reports the layer progress. Every 100 ms SD_LAYER_SCAN_BYTES bytes get
+scanned during a SD print and 8 * SD_LAYER_SCAN_BYTES while the printer is idle,
+so a print started right after M23 gets its index while it runs. The scan
+pauses during host prints. */
+#define SD_LAYER_INDEX 0
+#define SD_LAYER_SCAN_BYTES 512
+/** Power loss recovery for SD prints. At most every SD_CHECKPOINT_INTERVAL
+seconds the start of the first command with unfinished moves gets saved with
+position, e, temperatures, fan, tool and speed factors. Checkpoints rotate
+over SD_CHECKPOINT_SLOTS blocks of the contiguous file /.checkpoint and cost
+one block write each. If a write takes longer than 1/1000 of the interval, the
+interval grows accordingly. M413 reports checkpoint and write times, M413 S1
+continues the job: lift z by SD_CHECKPOINT_ZLIFT mm, home x/y, heat up and
+return to the saved position. Z must not have moved while power was off. */
+#define SD_CHECKPOINT 0
+#define SD_CHECKPOINT_INTERVAL 10
+#define SD_CHECKPOINT_SLOTS 16
+#define SD_CHECKPOINT_ZLIFT 5
+/** Collect M28 uploads in a buffer of SD_WRITE_BLOCKS blocks of 512 bytes and
+write it with one multi block command. With M28 S<bytes> filename the file
+gets created with contiguous clusters of that size, so FAT and directory entry
+are only updated by M29, which also reports the upload speed. Costs
+SD_WRITE_BLOCKS * 512 bytes RAM, 0 disables it. */
+#define SD_WRITE_BLOCKS 0
+/** Keep a sorted index of the directory shown in the lcd file browser, so
+scrolling opens only the visible entries instead of enumerating the directory
+for every row. Holds up to SD_DIR_INDEX entries at 6 bytes RAM each, larger
+directories are listed unsorted as before. The index gets rebuilt after the
+folder changed or files were written, deleted or created.
+SD_DIR_SORT 0 sorts by name, 1 lists newest files first. Folders come first. */
+#define SD_DIR_INDEX 0
+#define SD_DIR_SORT 0
+/** M38 filename estimates print time and filament of an ascii file. The moves
+get planned with the real path planner, acceleration and jerk settings, but the
+stepper interrupt drops them instead of moving, so the file runs much faster
+than real time. Temperature commands, homing and tool changes are ignored, G4
+dwells are added. Reports the time of every layer and the totals. The printer
+must be idle, host commands wait until the estimate is done. */
+#define SD_ESTIMATE 0
+/** Parse up to SD_PARSE_AHEAD commands of a running SD print in advance. The
+queue gets filled while the command loop waits for free moves, so bursts of
+short segments are already parsed when the move cache accepts them. Costs
+about 90 bytes RAM per command, 0 disables it. */
+#define SD_PARSE_AHEAD 0
+
+/** Keep the last SD_BLOCK_CACHE FAT and directory blocks in a small LRU cache
+behind the SdFat block cache, so cluster chain walks and directory scans do not
+reread the same blocks from the card. Costs about 520 bytes RAM per block, so
+only use it on boards with enough RAM. Listings only hit when the directory has
+fewer blocks than the cache, a block holds about 3 files with long names.
+tools/sd_cache_bench counts the card reads. M39 reports the hit rate, 0 disables it. */
+#define SD_BLOCK_CACHE 0
 
 
 
@@ -92,6 +92,19 @@
  */
 #define Z_PROBE_SPEED 2
 
+/**
+ * Probe with a fast approach first. After the trigger z goes up by
+ * Z_PROBE_SWITCHING_DISTANCE and touches again with Z_PROBE_SPEED. Following
+ * points in the same probing run approach fast to Z_PROBE_LEARN_MARGIN mm above
+ * the last trigger height. Repetitions stop when two touches differ by at most
+ * Z_PROBE_REPEATABILITY mm.
+ */
+#define Z_PROBE_FAST_APPROACH 0
+/** Speed of z-axis in mm/s for the fast approach */
+#define Z_PROBE_FAST_SPEED 10
+#define Z_PROBE_LEARN_MARGIN 1.0
+#define Z_PROBE_REPEATABILITY 0.01
+
 /**
  * Speed of x-axis and y-axis in mms/s when probing
  */
@@ -110,8 +123,11 @@
 /**
  * 0 = use average of measurements
  * 1 = use middle value
+ * 2 = drop values deviating more than Z_PROBE_MAD_FACTOR times the median
+ *     absolute deviation (at least one step) from the median and average the rest
  */
 #define Z_PROBE_USE_MEDIAN 0 
+#define Z_PROBE_MAD_FACTOR 3
 
 /** 
  * These scripts are run before resp. after the z-probe is done. Add here code 
@@ -153,6 +169,11 @@
  * bending to both sides of the axis. So probe points 2 and 3 build the symmetric axis and
  * point 1 is mirrored to 1m across the axis. Using the symmetry we then remove the bending
  * from 1 and use that as plane.
+ *
+ * BED_LEVELING_METHOD 3
+ * Adaptive grid. Same grid as method 1, but starts with corners and center and only refines
+ * cells where a point deviates more than BED_LEVELING_ADAPTIVE_THRESHOLD mm from the
+ * regression plane. Stops as soon as all points fit the plane.
 */
 #define BED_LEVELING_METHOD 1
 
@@ -168,6 +189,11 @@
  */
 #define BED_LEVELING_GRID_SIZE 4
 
+/**
+ * Max. deviation in mm from the plane before method 3 probes more points
+ */
+#define BED_LEVELING_ADAPTIVE_THRESHOLD 0.05
+
 /**
  * Repetitions for motorized bed leveling
  */
@@ -265,4 +291,27 @@
  */
 #define DISTORTION_EXTRAPOLATE_CORNERS 0
 
+/**
+ * How distortion correction gets applied to xy moves on cartesian printers.
+ *
+ * 0 = split moves into lines of max. 10 mm and add the correction to z of
+ *     every line. Each line needs its own entry in the move cache.
+ * 1 = keep a xy move as one entry in the move cache and let the stepper
+ *     interrupt inject the correction as additional z steps. The correction
+ *     follows a ramp of DISTORTION_RAMP_PIECES linear pieces of max. 10 mm,
+ *     so moves up to DISTORTION_RAMP_PIECES * 10 mm need only one entry.
+ *     Injected steps stay within z feedrate, jerk and acceleration, the
+ *     rest of the correction follows with the next move.
+ *
+ * Moves with z changes always use method 0. Not available for delta and
+ * xz/zx gantry systems.
+ */
+#define DISTORTION_STEP_INJECTION 0
+
+/**
+ * Number of linear pieces of the z correction ramp per move. Each piece costs
+ * 6 bytes per move cache entry.
+ */
+#define DISTORTION_RAMP_PIECES 4
+
 #endif
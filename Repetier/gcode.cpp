@@ -42,6 +42,21 @@ uint8_t  GCode::formatErrors = 0;
 PGM_P GCode::fatalErrorMsg = NULL; ///< message unset = no fatal error 
 millis_t GCode::lastBusySignal = 0; ///< When was the last busy signal
 uint32_t GCode::keepAliveInterval = KEEP_ALIVE_INTERVAL;
+#if SD_COMPILED_JOBS
+int32_t  GCode::packedBase[4];
+uint8_t  GCode::packedValid = 0;
+#endif
+#if SD_PARSE_AHEAD
+GCode GCode::sdAhead[SD_PARSE_AHEAD];
+uint8_t GCode::sdAheadLine[MAX_CMD_SIZE];
+uint8_t GCode::sdAheadRead = 0;
+uint8_t GCode::sdAheadCount = 0;
+uint8_t GCode::sdAheadLength = 0;
+uint8_t GCode::sdAheadSize = 0;
+bool GCode::sdAheadBinary = false;
+bool GCode::sdAheadComment = false;
+bool GCode::sdAheadText = false;
+#endif
 #if NEW_COMMUNICATION == 0
 int8_t   GCode::waitingForResend = -1; ///< Waiting for line to be resend. -1 = no wait.
 uint32_t GCode::lastLineNumber = 0; ///< Last line number received.
@@ -92,7 +107,7 @@ Gcode Letter to Bit and Datatype:
 - S : Bit 10 : 32 Bit Value
 - P : Bit 11 : 32 Bit Integer
 - V2 : Bit 12 : Version 2 command for additional commands/sizes
-- Ext : Bit 13 : There are 2 more uint8_ts following with Bits, only for future versions
+- Packed : Bit 13 : X, Y, Z and E are 16 bit deltas in um to the last value (compiled SD jobs only)
 - Int :Bit 14 : Marks it as internal command,
 - Text : Bit 15 : 16 Byte ASCII String terminated with 0
 Second word if V2:
@@ -106,17 +121,27 @@ Second word if V2:
 - B : Bit 7 : 32-Bit float
 - K : Bit 8 : 32-Bit float
 - L : Bit 9 : 32-Bit float
-- O : Bit 0 : 32-Bit float
+- O : Bit 10 : 32-Bit float
+- Q : Bit 11 : 32-Bit float
+- P : Bit 12 : 32-Bit float, P with fractional part. The integer P is sent as well.
 */
-uint8_t GCode::computeBinarySize(char *ptr)  // unsigned int bitfield) {
+uint8_t GCode::computeBinarySize(char *ptr, bool fromSD)  // unsigned int bitfield) {
 {
     uint8_t s = 4; // include checksum and bitfield
     uint16_t bitfield = *(uint16_t*)ptr;
     if(bitfield & 1) s += 2;
+#if SD_COMPILED_JOBS
+    uint8_t coordSize = (fromSD && (bitfield & 8192) ? 2 : 4); // packed only in compiled sd jobs
+    if(bitfield & 8) s += coordSize;
+    if(bitfield & 16) s += coordSize;
+    if(bitfield & 32) s += coordSize;
+    if(bitfield & 64) s += coordSize;
+#else
     if(bitfield & 8) s += 4;
     if(bitfield & 16) s += 4;
     if(bitfield & 32) s += 4;
     if(bitfield & 64) s += 4;
+#endif
     if(bitfield & 256) s += 4;
     if(bitfield & 512) s += 1;
     if(bitfield & 1024) s += 4;
@@ -448,6 +473,26 @@ void GCode::readFromSerial()
 #if NEW_COMMUNICATION
     bool lastWTA = Com::writeToAll;
     Com::writeToAll = false;
+#if SD_PARSE_AHEAD
+    if(GCodeSource::activeSource == &sdSource) { // sd commands come already parsed
+        if(sdAheadCount == 0)
+            readAheadSD(1);
+        if(sdAheadCount > 0 && sd.sdmode == 1) {
+            GCode *act = &commandsBuffered[bufferWriteIndex];
+            *act = sdAhead[sdAheadRead];
+            if(++sdAheadRead == SD_PARSE_AHEAD)
+                sdAheadRead = 0;
+            sdAheadCount--;
+            if(act->hasN())
+                actLineNumber = act->N;
+            act->checkAndPushCommand();
+        } else if(sdAheadCount == 0)
+            sdSource.dataAvailable(); // closes source at end of file
+        GCodeSource::rotateSource();
+        Com::writeToAll = lastWTA;
+        return;
+    }
+#endif
     if(!GCodeSource::activeSource->dataAvailable())
     {
         if(GCodeSource::activeSource->closeOnError()) { // this device does not support resends so all errors are final and we always expect there is a new char!
@@ -504,11 +549,18 @@ void GCode::readFromSerial()
         {
             if(commandsReceivingWritePosition < 2 ) continue;
             if(commandsReceivingWritePosition == 5 || commandsReceivingWritePosition == 4)
+#if SD_COMPILED_JOBS
+            binaryCommandSize = computeBinarySize((char*)commandReceiving, GCodeSource::activeSource == &sdSource);
+#else
             binaryCommandSize = computeBinarySize((char*)commandReceiving);
+#endif
             if(commandsReceivingWritePosition == binaryCommandSize)
             {
                 GCode *act = &commandsBuffered[bufferWriteIndex];
                 act->source = GCodeSource::activeSource; // we need to know where to write answers to
+#if SD_CHECKPOINT
+                act->sdPos = sd.sdpos;
+#endif
                 if(act->parseBinary(commandReceiving, true)) {  // Success
                   act->checkAndPushCommand();
                 } else {
@@ -540,6 +592,9 @@ void GCode::readFromSerial()
                 }
                 GCode *act = &commandsBuffered[bufferWriteIndex];
                 act->source = GCodeSource::activeSource; // we need to know where to write answers to
+#if SD_CHECKPOINT
+                act->sdPos = sd.sdpos;
+#endif
                 if(act->parseAscii((char *)commandReceiving, true)) {  // Success
                   act->checkAndPushCommand();
                 } else {
@@ -668,6 +723,14 @@ void GCode::readFromSerial()
     while( sd.filesize > sd.sdpos && commandsReceivingWritePosition < MAX_CMD_SIZE)    // consume data until no data or buffer full
     {
         timeOfLastDataPacket = HAL::timeInMilliseconds();
+#if SD_READ_BUFFERS
+        int n = sd.readByte();
+        if(n == -1)
+        {
+            sd.sdmode = 0;
+            break;
+        }
+#else
         int n = sd.file.read();
         if(n == -1)
         {
@@ -686,6 +749,7 @@ void GCode::readFromSerial()
             UI_ERROR("SD error fixed");
         }
         sd.sdpos++; // = file.curPosition();
+#endif
         commandReceiving[commandsReceivingWritePosition++] = (uint8_t)n;
 
         // first lets detect, if we got an old type ascii command
@@ -697,7 +761,7 @@ void GCode::readFromSerial()
         {
             if(commandsReceivingWritePosition < 2 ) continue;
             if(commandsReceivingWritePosition == 4 || commandsReceivingWritePosition == 5)
-                binaryCommandSize = computeBinarySize((char*)commandReceiving);
+                binaryCommandSize = computeBinarySize((char*)commandReceiving, true);
             if(commandsReceivingWritePosition == binaryCommandSize)
             {
                 GCode *act = &commandsBuffered[bufferWriteIndex];
@@ -753,6 +817,37 @@ void GCode::readFromSerial()
   Converts a binary uint8_tfield containing one GCode line into a GCode structure.
   Returns true if checksum was correct.
 */
+#if SD_COMPILED_JOBS
+/** Reads a coordinate of a binary command. Packed values are deltas to the last
+coordinate of the axis read from the sd card. */
+float GCode::readCoordinate(fast8_t axis, uint8_t *&p)
+{
+    if(params & 8192)
+    {
+        if((packedValid & (1 << axis)) == 0)   // seek into the middle of a keyframe
+        {
+            Com::printErrorFLN(PSTR("Packed coordinate without base, job must continue at a keyframe"));
+            setFormatError();
+        }
+        int16_t delta;
+        memcopy2(&delta, p);
+        p += 2;
+        packedBase[axis] += delta;
+        return packedBase[axis] * 0.001f;
+    }
+    float f = *(float *)p;
+    p += 4;
+#if NEW_COMMUNICATION
+    if(source == &sdSource)
+#endif
+    {
+        packedBase[axis] = lroundf(f * 1000.0f);
+        packedValid |= 1 << axis;
+    }
+    return f;
+}
+#endif
+
 bool GCode::parseBinary(uint8_t *buffer,bool fromSerial)
 {
     internalCommand = !fromSerial;
@@ -787,6 +882,14 @@ bool GCode::parseBinary(uint8_t *buffer,bool fromSerial)
     p = buffer;
     params = *(uint16_t *)p;
     p += 2;
+#if SD_COMPILED_JOBS
+#if NEW_COMMUNICATION
+    if(source != &sdSource)
+#else
+    if(fromSerial)
+#endif
+        params &= ~8192; // packed coordinates exist only in compiled sd jobs
+#endif
     uint8_t textlen = 16;
     if(isV2())
     {
@@ -826,6 +929,20 @@ bool GCode::parseBinary(uint8_t *buffer,bool fromSerial)
         }
     }
     //if(code->params & 8) {memcpy(&code->X,p,4);p+=4;}
+#if SD_COMPILED_JOBS
+    if(hasX())
+        X = readCoordinate(X_AXIS, p);
+    if(hasY())
+        Y = readCoordinate(Y_AXIS, p);
+    if(hasZ())
+        Z = readCoordinate(Z_AXIS, p);
+    if(hasE())
+        E = readCoordinate(E_AXIS, p);
+    if(hasM() && M == 37) // header values are no base for packed coordinates
+        packedValid = 0;
+    if(hasFormatError())
+        return false;
+#else
     if(hasX())
     {
         X = *(float *)p;
@@ -846,6 +963,7 @@ bool GCode::parseBinary(uint8_t *buffer,bool fromSerial)
         E = *(float *)p;
         p += 4;
     }
+#endif
     if(hasF())
     {
         F = *(float *)p;
@@ -920,6 +1038,23 @@ bool GCode::parseBinary(uint8_t *buffer,bool fromSerial)
         O = *(float *)p;
         p += 4;
     }
+    if(hasQ())
+    {
+        Q = *(float *)p;
+        p += 4;
+    }
+#if BEZIER_SUPPORT
+    if(params2 & 4096)
+    {
+        PF = *(float *)p;
+        p += 4;
+    }
+    else if(hasP())
+        PF = P;
+#else
+    if(params2 & 4096) // fractional P
+        p += 4;
+#endif
     if(hasString())   // set text pointer to string
     {
         text = (char*)p;
@@ -940,6 +1075,9 @@ bool GCode::parseAscii(char *line,bool fromSerial)
     params2 = 0;
     internalCommand = !fromSerial;
 	bool hasChecksum = false;
+#if SD_WRITE_BLOCKS
+    char *textEnd = NULL;
+#endif
     char c;
     while ( (c = *(pos++)) )
     {
@@ -969,7 +1107,7 @@ bool GCode::parseAscii(char *line,bool fromSerial)
             params |= 2;
             if(M > 255) params |= 4096;
             // handle non standard text arguments that some M codes have
-            if (M == 20 || M == 23 || M == 28 || M == 29 || M == 30 || M == 32 || M == 36 || M == 117 || M == 531)
+            if (M == 20 || M == 23 || M == 28 || M == 29 || M == 30 || M == 32 || M == 36 || M == 38 || M == 117 || M == 531)
             {
                 // after M command we got a filename or text
                 char digit;
@@ -990,6 +1128,11 @@ bool GCode::parseAscii(char *line,bool fromSerial)
                     if((M != 117 && M != 20 && M != 531 && *pos==' ') || *pos=='*') break;
                     pos++; // find a space as file name end
                 }
+#if SD_WRITE_BLOCKS
+                if(M == 28 && *pos == ' ')
+                    textEnd = pos; // parse announced size S behind filename, terminated after checksum test
+                else
+#endif
                 *pos = 0; // truncate filename by erasing space with null, also skips checksum
                 waitUntilAllCommandsAreParsed = true; // don't risk string be deleted
                 params |= 32768;
@@ -1050,6 +1193,13 @@ bool GCode::parseAscii(char *line,bool fromSerial)
         {
             P = parseLongValue(pos);
             params |= 2048;
+#if BEZIER_SUPPORT
+            PF = parseFloatValue(pos);
+            if(PF != static_cast<float>(P)) { // fractional part needs its own float for saving
+                params2 |= 4096;
+                params |= 4096; // Needs V2 for saving
+            }
+#endif
             break;
         }
         case 'I':
@@ -1140,6 +1290,14 @@ bool GCode::parseAscii(char *line,bool fromSerial)
 	        params |= 4096; // Needs V2 for saving
 	        break;
         }
+        case 'Q':
+        case 'q':
+        {
+	        Q = parseFloatValue(pos);
+	        params2 |= 2048;
+	        params |= 4096; // Needs V2 for saving
+	        break;
+        }
         case '*' : //checksum
         {
             uint8_t checksum_given = parseLongValue(pos);
@@ -1163,6 +1321,10 @@ bool GCode::parseAscii(char *line,bool fromSerial)
             break;
         }// end switch
     }// end while
+#if SD_WRITE_BLOCKS
+    if(textEnd != NULL)
+        *textEnd = 0;
+#endif
 #if NEW_COMMUNICATION
 	if(GCodeSource::activeSource->wasLastCommandReceivedAsBinary && !hasChecksum && fromSerial && !waitUntilAllCommandsAreParsed) {
 #else    
@@ -1280,6 +1442,10 @@ void GCode::printCommand()
     {
         Com::printF(Com::tO,O);
     }
+    if(hasQ())
+    {
+        Com::printF(Com::tQ,Q);
+    }
     if(hasString())
     {
         Com::print(text);
@@ -1452,6 +1618,81 @@ void SerialGCodeSource::close() {
 }    
 // ----- SD card source -----
 
+#if SD_PARSE_AHEAD
+void GCode::resetReadAheadSD() {
+    sdAheadRead = sdAheadCount = sdAheadLength = 0;
+    sdAheadComment = sdAheadText = false;
+}
+
+/** Parses up to maxCommands commands of the running sd print into the read
+ahead queue. Stops behind commands with a string, because the string stays in
+sdAheadLine until the command is executed. */
+void GCode::readAheadSD(uint8_t maxCommands) {
+    if(sd.sdmode != 1) return;
+    if(sdAheadText) {
+        if(sdAheadCount > 0 || bufferLength > 0) return;
+        sdAheadText = false;
+    }
+    while(maxCommands > 0 && sdAheadCount < SD_PARSE_AHEAD && sd.sdpos < sd.filesize) {
+        uint8_t c = sdSource.readByte();
+        if(sd.sdmode != 1) return; // read error closed the source
+        sdAheadLine[sdAheadLength++] = c;
+        if(sdAheadLength == 1 && !sdAheadComment)
+            sdAheadBinary = (c & 128) != 0;
+        if(sdAheadBinary) {
+            if(sdAheadLength == 4 || sdAheadLength == 5)
+                sdAheadSize = computeBinarySize((char*)sdAheadLine, true);
+            if(sdAheadLength < 4 || sdAheadLength != sdAheadSize)
+                continue;
+        } else {
+            bool end = (c == 0 || c == '\n' || c == '\r');
+            if(c == ';')
+                sdAheadComment = true;
+            if(end || sdAheadComment)
+                sdAheadLength--;
+            if(!end && sd.sdpos < sd.filesize) {
+                if(sdAheadLength >= MAX_CMD_SIZE - 1) { // line too long
+                    sdSource.close();
+                    return;
+                }
+                continue;
+            }
+            sdAheadComment = false;
+            if(sdAheadLength == 0) continue; // empty line
+            sdAheadLine[sdAheadLength] = 0;
+        }
+        uint8_t pos = sdAheadRead + sdAheadCount;
+        if(pos >= SD_PARSE_AHEAD)
+            pos -= SD_PARSE_AHEAD;
+        GCode *act = &sdAhead[pos];
+        act->source = &sdSource;
+#if SD_CHECKPOINT
+        act->sdPos = sd.sdpos;
+#endif
+        // parsing checks protocol and size of the active source, which may be a host
+        // connection with a partial command pending
+        GCodeSource *lastSource = GCodeSource::activeSource;
+        uint8_t lastSize = binaryCommandSize;
+        GCodeSource::activeSource = &sdSource;
+        binaryCommandSize = sdAheadSize;
+        bool ok = (sdAheadBinary ? act->parseBinary(sdAheadLine, true) : act->parseAscii((char *)sdAheadLine, true));
+        GCodeSource::activeSource = lastSource;
+        binaryCommandSize = lastSize;
+        sdAheadLength = 0;
+        if(!ok) { // sd card can not resend
+            sdSource.close();
+            return;
+        }
+        sdAheadCount++;
+        maxCommands--;
+        if(act->hasString()) {
+            sdAheadText = true;
+            return;
+        }
+    }
+}
+#endif
+
 #if SDSUPPORT
 bool SDCardGCodeSource::isOpen() {
     return (sd.sdmode > 0 && sd.sdmode < 100);
@@ -1473,6 +1714,14 @@ bool SDCardGCodeSource::dataAvailable() { // would read return a new byte?
     return false;
 }
 int SDCardGCodeSource::readByte() {
+#if SD_READ_BUFFERS
+    int n = sd.readByte();
+    if(n == -1) {
+        close();
+        return 0;
+    }
+    return n;
+#else
     int n = sd.file.read();
     if(n == -1) {
         Com::printFLN(Com::tSDReadError);
@@ -1490,12 +1739,20 @@ int SDCardGCodeSource::readByte() {
     }
     sd.sdpos++; // = file.curPosition();
     return n;
+#endif
 }
 void SDCardGCodeSource::writeByte(uint8_t byte) {
     // dummy
 }
 void SDCardGCodeSource::close() {
     sd.sdmode = 0;    
+#if SD_PARSE_AHEAD
+    GCode::resetReadAheadSD();
+#endif
+#if SD_CHECKPOINT
+    if(sd.sdpos >= sd.filesize)
+        sd.finishCheckpoint(); // keep checkpoint on read errors
+#endif
     GCodeSource::removeSource(this);  
     Printer::setPrinting(false);
     Printer::setMenuMode(MENU_MODE_SD_PRINTING,false);
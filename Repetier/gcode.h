@@ -103,6 +103,9 @@ public:
     float F; ///< G-code F value if set
     int32_t S; ///< G-code S value if set
     int32_t P; ///< G-code P value if set
+#if BEZIER_SUPPORT
+    float PF; ///< G-code P value as float if set, keeps the fractional part
+#endif
     float I; ///< G-code I value if set
     float J; ///< G-code J value if set
     float R; ///< G-code R value if set
@@ -114,6 +117,7 @@ public:
     float K; ///< G-code K value if set
     float L; ///< G-code L value if set
     float O; ///< G-code O value if set
+    float Q; ///< G-code Q value if set
 
     char *text; ///< Text message of g-code if present.
     //moved the byte to the end and aligned ints on short boundary
@@ -232,6 +236,10 @@ public:
     {
         return ((params2 & 1024)!=0);
     }
+    inline bool hasQ()
+    {
+        return ((params2 & 2048)!=0);
+    }
     inline long getS(long def)
     {
         return (hasS() ? S : def);
@@ -255,9 +263,18 @@ public:
     static GCode *peekCurrentCommand();
     /** Frees the cache used by the last command fetched. */
     static void readFromSerial();
+#if SD_PARSE_AHEAD
+    static void readAheadSD(uint8_t maxCommands);
+    static void resetReadAheadSD();
+#endif
     static void pushCommand();
     static void executeFString(FSTRINGPARAM(cmd));
-    static uint8_t computeBinarySize(char *ptr);
+    static uint8_t computeBinarySize(char *ptr, bool fromSD = false);
+#if SD_COMPILED_JOBS
+    static void resetPackedCoordinates() {
+        packedValid = 0;
+    }
+#endif
 	static void fatalError(FSTRINGPARAM(message));
 	static void reportFatalError();
 	static void resetFatalError();
@@ -268,9 +285,27 @@ public:
 	static uint32_t keepAliveInterval;
     friend class SDCard;
     friend class UIDisplay;
+    friend class Extruder;
+    friend class JobCompiler;
+    template<class C> friend uint8_t encodeBinaryCommand(C *code, uint8_t *buf, class JobCompiler *job);
 	static FSTRINGPARAM(fatalErrorMsg);
     friend class GCodeSource;    
 protected:
+#if SD_PARSE_AHEAD
+    static GCode sdAhead[SD_PARSE_AHEAD]; ///< SD commands parsed ahead
+    static uint8_t sdAheadLine[MAX_CMD_SIZE]; ///< SD line being read, holds text of last parsed command
+    static uint8_t sdAheadRead; ///< Read position in sdAhead
+    static uint8_t sdAheadCount; ///< Number of commands in sdAhead
+    static uint8_t sdAheadLength; ///< Bytes in sdAheadLine
+    static uint8_t sdAheadSize; ///< Expected size of binary command
+    static bool sdAheadBinary, sdAheadComment;
+    static bool sdAheadText; ///< Last parsed command has a string in sdAheadLine
+#endif
+#if SD_COMPILED_JOBS
+    static int32_t packedBase[4]; ///< Last coordinate per axis in um of compiled SD jobs
+    static uint8_t packedValid; ///< Bit per axis with valid packedBase
+    float readCoordinate(fast8_t axis, uint8_t *&p);
+#endif
     void debugCommandBuffer();
     void checkAndPushCommand();
     static void requestResend();
@@ -312,6 +347,9 @@ protected:
 #else
 public:
     GCodeSource *source;    
+#if SD_CHECKPOINT
+    uint32_t sdPos; ///< File position behind the command if read from sd card
+#endif
 #endif    
 };
 
@@ -76,6 +76,9 @@ int maxadv2 = 0;
 float maxadvspeed = 0;
 #endif
 uint8_t pwm_pos[NUM_PWM]; // 0-NUM_EXTRUDER = Heater 0-NUM_EXTRUDER of extruder, NUM_EXTRUDER = Heated bed, NUM_EXTRUDER+1 Board fan, NUM_EXTRUDER+2 = Fan
+#if HEATER_SCHEDULER
+uint8_t heaterPhase[PWM_HEATED_BED + 1];
+#endif
 volatile int waitRelax = 0; // Delay filament relax at the end of print, could be a simple timeout
 
 PrintLine PrintLine::lines[PRINTLINE_CACHE_SIZE]; ///< Cache for print moves.
@@ -85,7 +88,24 @@ volatile bool PrintLine::nlFlag = false;
 #endif
 ufast8_t PrintLine::linesWritePos = 0;            ///< Position where we write the next cached line move.
 volatile ufast8_t PrintLine::linesCount = 0;      ///< Number of lines cached 0 = nothing to do.
+#if SD_CHECKPOINT || SD_ESTIMATE
+uint32_t PrintLine::linesPushed = 0;
+#endif
+#if SD_ESTIMATE
+volatile uint8_t PrintLine::estimating = 0;
+float PrintLine::estimateTime = 0;
+int32_t PrintLine::estimateESteps = 0;
+uint32_t PrintLine::estimateMark = 0;
+float PrintLine::estimateMarkTime = 0;
+#endif
 ufast8_t PrintLine::linesPos = 0;                 ///< Position for executing line movement.
+#if ARC_SUPPORT || BEZIER_SUPPORT
+bool PrintLine::arcSegmentJoin = false;           ///< Next queued line continues the current arc.
+#endif
+#if VOLUMETRIC_FLOW_LIMIT
+uint32_t PrintLine::extrudingMoves = 0;
+uint32_t PrintLine::flowLimitedMoves = 0;
+#endif
 
 /**
 Move printer the given number of steps. Puts the move into the queue. Used by e.g. homing commands.
@@ -197,12 +217,24 @@ void PrintLine::moveRelativeDistanceInStepsReal(int32_t x, int32_t y, int32_t z,
 
 #if !NONLINEAR_SYSTEM
 #if DISTORTION_CORRECTION
-/* Special version which adds distortion correction to z. Gets called from queueCartesianMove if needed. */
-void PrintLine::queueCartesianSegmentTo(uint8_t check_endstops, uint8_t pathOptimize) {
-
-    // Correct the bumps
-    Printer::zCorrectionStepsIncluded = Printer::distortion.correct(Printer::destinationSteps[X_AXIS], Printer::destinationSteps[Y_AXIS], Printer::destinationSteps[Z_AXIS]);
-    Printer::destinationSteps[Z_AXIS] += Printer::zCorrectionStepsIncluded;
+/* Special version which adds distortion correction to z. Gets called from queueCartesianMove if needed.
+ With injectCorrection set the z position is kept and the correction gets added by the stepper interrupt
+ following a ramp. Only allowed for moves without z change. */
+void PrintLine::queueCartesianSegmentTo(uint8_t check_endstops, uint8_t pathOptimize, bool injectCorrection) {
+#if DISTORTION_STEP_INJECTION
+    int32_t rampStartX = Printer::currentPositionSteps[X_AXIS];
+    int32_t rampStartY = Printer::currentPositionSteps[Y_AXIS];
+    int32_t rampStartCorrection = Printer::zCorrectionStepsIncluded;
+    if(injectCorrection) {
+        // Stay at current z, correction steps get injected during move
+        Printer::destinationSteps[Z_AXIS] += Printer::zCorrectionStepsIncluded;
+    } else
+#endif
+    {
+        // Correct the bumps
+        Printer::zCorrectionStepsIncluded = Printer::distortion.correct(Printer::destinationSteps[X_AXIS], Printer::destinationSteps[Y_AXIS], Printer::destinationSteps[Z_AXIS]);
+        Printer::destinationSteps[Z_AXIS] += Printer::zCorrectionStepsIncluded;
+    }
 #if DEBUG_DISTORTION
     Com::printF(PSTR("zCorr:"), Printer::zCorrectionStepsIncluded * Printer::invAxisStepsPerMM[Z_AXIS], 3);
     Com::printF(PSTR(" atX:"), Printer::destinationSteps[X_AXIS]*Printer::invAxisStepsPerMM[X_AXIS]);
@@ -218,10 +250,16 @@ void PrintLine::queueCartesianSegmentTo(uint8_t check_endstops, uint8_t pathOpti
     if(Printer::isAllEMotors()) {
         p->flags |= FLAG_ALL_E_MOTORS;
     }
+#if MIXING_GRADIENT
+    p->storeMixingWeights();
+#endif
 #endif
     p->joinFlags = 0;
     if(!pathOptimize) p->setEndSpeedFixed(true);
     p->dir = 0;
+#if DISTORTION_STEP_INJECTION
+    p->zCorrPieces = 0;
+#endif
     //Find direction
     //Printer::zCorrectionStepsIncluded = 0;
     for(uint8_t axis = 0; axis < 4; axis++) {
@@ -257,6 +295,9 @@ void PrintLine::queueCartesianSegmentTo(uint8_t check_endstops, uint8_t pathOpti
     float xydist2;
 #if ENABLE_BACKLASH_COMPENSATION
     if((p->isXYZMove()) && ((p->dir & XYZ_DIRPOS) ^ (Printer::backlashDir & XYZ_DIRPOS)) & (Printer::backlashDir >> 3)) { // We need to compensate backlash, add a move
+#if ARC_SUPPORT || BEZIER_SUPPORT
+        arcSegmentJoin = false; // neither the backlash move nor the real move after it continue an arc
+#endif
         PrintLine::waitForXFreeLines(2);
         uint8_t wpos2 = PrintLine::linesWritePos + 1;
         if(wpos2 >= PRINTLINE_CACHE_SIZE) wpos2 = 0;
@@ -305,9 +346,77 @@ void PrintLine::queueCartesianSegmentTo(uint8_t check_endstops, uint8_t pathOpti
             p->distance = RMath::max((float)sqrt(xydist2), fabs(axisDistanceMM[E_AXIS]));
     } else
         p->distance = fabs(axisDistanceMM[E_AXIS]);
+#if DISTORTION_STEP_INJECTION
+    if(injectCorrection) {
+        int32_t rampEndCorrection = p->computeZCorrectionRamp(rampStartX, rampStartY, rampStartCorrection);
+        Printer::currentPositionSteps[Z_AXIS] += rampEndCorrection - Printer::zCorrectionStepsIncluded;
+        Printer::zCorrectionStepsIncluded = rampEndCorrection;
+    }
+#endif
     p->calculateMove(axisDistanceMM, pathOptimize, p->primaryAxis);
 
 }
+
+#if DISTORTION_STEP_INJECTION
+/** \brief Computes the z correction ramp for a xy move.
+
+The move is divided into DISTORTION_RAMP_PIECES pieces of equal length. At the end of each piece the
+exact correction is computed and the stepper interrupt distributes the difference to the previous
+piece end linearly over the piece. Destination must already be stored in destinationSteps.
+Steps per piece are limited by the z feedrate and the speed change between pieces by z jerk and
+z acceleration, assuming the move runs at full feedrate. The remaining correction is added by
+the next move.
+
+\param startX x position at move start in CMC steps.
+\param startY y position at move start in CMC steps.
+\param startCorrection Correction in z steps included at move start.
+\return Correction in z steps included at move end.
+*/
+int32_t PrintLine::computeZCorrectionRamp(int32_t startX, int32_t startY, int32_t startCorrection) {
+    int32_t dx = Printer::destinationSteps[X_AXIS] - startX;
+    int32_t dy = Printer::destinationSteps[Y_AXIS] - startY;
+    int32_t z = Printer::destinationSteps[Z_AXIS] - startCorrection; // correction is not included in z for lookup
+    int32_t correction = startCorrection;
+    int32_t pieceStart = stepsRemaining;
+    bool hasSteps = false;
+    zCorrDirs = 0;
+    float dxMM = dx * Printer::invAxisStepsPerMM[X_AXIS];
+    float dyMM = dy * Printer::invAxisStepsPerMM[Y_AXIS];
+    float pieceTime = sqrt(dxMM * dxMM + dyMM * dyMM) / (DISTORTION_RAMP_PIECES * Printer::feedrate); // shortest possible duration
+    float zStepsPerSpeed = pieceTime * Printer::axisStepsPerMM[Z_AXIS]; // steps per piece for 1 mm/s z speed
+    int32_t maxSteps = static_cast<int32_t>(Printer::maxFeedrate[Z_AXIS] * zStepsPerSpeed);
+    int32_t maxChange = RMath::max(static_cast<int32_t>((Printer::maxZJerk + Printer::maxAccelerationMMPerSquareSecond[Z_AXIS] * pieceTime) * zStepsPerSpeed), static_cast<int32_t>(1));
+    int32_t lastSteps = 0;
+    for(fast8_t i = 0; i < DISTORTION_RAMP_PIECES; i++) {
+        int32_t pieceEnd = stepsRemaining - (stepsRemaining * (i + 1)) / DISTORTION_RAMP_PIECES;
+        int32_t target = Printer::distortion.correct(startX + (dx * (i + 1)) / DISTORTION_RAMP_PIECES, startY + (dy * (i + 1)) / DISTORTION_RAMP_PIECES, z);
+        int32_t steps = target - correction;
+        int32_t length = pieceStart - pieceEnd;
+        // We can add at most one z step per primary axis step
+        if(steps > length) steps = length;
+        else if(steps < -length) steps = -length;
+        if(steps > maxSteps) steps = maxSteps;
+        else if(steps < -maxSteps) steps = -maxSteps;
+        if(steps > lastSteps + maxChange) steps = lastSteps + maxChange;
+        else if(steps < lastSteps - maxChange) steps = lastSteps - maxChange;
+        lastSteps = steps;
+        if(steps > 0)
+            zCorrDirs |= 1 << i;
+        zCorrSteps[i] = static_cast<uint16_t>(labs(steps));
+        zCorrEnd[i] = pieceEnd;
+        if(steps) hasSteps = true;
+        correction += steps;
+        pieceStart = pieceEnd;
+    }
+    zCorrPieces = (hasSteps ? DISTORTION_RAMP_PIECES : 0);
+    zCorrPiece = 0;
+#if DEBUG_DISTORTION
+    Com::printF(PSTR("zRamp:"), (correction - startCorrection) * Printer::invAxisStepsPerMM[Z_AXIS], 3);
+    Com::printFLN(PSTR(" pieces:"), (int)zCorrPieces);
+#endif
+    return correction;
+}
+#endif
 #endif
 /**
   Put a move to the current destination coordinates into the movement cache.
@@ -342,6 +451,27 @@ void PrintLine::queueCartesianMove(uint8_t check_endstops, uint8_t pathOptimize)
         float dx = Printer::invAxisStepsPerMM[X_AXIS] * deltas[X_AXIS];
         float dy = Printer::invAxisStepsPerMM[Y_AXIS] * deltas[Y_AXIS];
         float len = dx * dx + dy * dy;
+#if DISTORTION_STEP_INJECTION
+        if(deltas[Z_AXIS] == 0) { // pure xy move, stepper interrupt adds correction
+            if(len < 100.0 * DISTORTION_RAMP_PIECES * DISTORTION_RAMP_PIECES) {
+                queueCartesianSegmentTo(check_endstops, pathOptimize, true);
+                return;
+            }
+            len = sqrt(len);
+            int segments = (static_cast<int>(len) + 10 * DISTORTION_RAMP_PIECES - 1) / (10 * DISTORTION_RAMP_PIECES);
+#if DEBUG_DISTORTION
+            Com::printF(PSTR("Split ramp line len:"), len);
+            Com::printFLN(PSTR(" segments:"), segments);
+#endif
+            for(int i = 1; i <= segments; i++) {
+                for(fast8_t j = 0; j < E_AXIS_ARRAY; j++) {
+                    Printer::destinationSteps[j] = start[j] + (i * deltas[j]) / segments;
+                }
+                queueCartesianSegmentTo(check_endstops, pathOptimize, true);
+            }
+            return;
+        }
+#endif
         if(len < 100) { // no splitting required
             queueCartesianSegmentTo(check_endstops, pathOptimize);
             return;
@@ -372,10 +502,16 @@ void PrintLine::queueCartesianMove(uint8_t check_endstops, uint8_t pathOptimize)
     if(Printer::isAllEMotors()) {
         p->flags |= FLAG_ALL_E_MOTORS;
     }
+#if MIXING_GRADIENT
+    p->storeMixingWeights();
+#endif
 #endif
     p->joinFlags = 0;
     if(!pathOptimize) p->setEndSpeedFixed(true);
     p->dir = 0;
+#if DISTORTION_STEP_INJECTION
+    p->zCorrPieces = 0;
+#endif
     //Find direction
     Printer::zCorrectionStepsIncluded = 0;
     for(uint8_t axis = 0; axis < 4; axis++) {
@@ -411,6 +547,9 @@ void PrintLine::queueCartesianMove(uint8_t check_endstops, uint8_t pathOptimize)
     float xydist2;
 #if ENABLE_BACKLASH_COMPENSATION
     if((p->isXYZMove()) && ((p->dir & XYZ_DIRPOS) ^ (Printer::backlashDir & XYZ_DIRPOS)) & (Printer::backlashDir >> 3)) { // We need to compensate backlash, add a move
+#if ARC_SUPPORT || BEZIER_SUPPORT
+        arcSegmentJoin = false; // neither the backlash move nor the real move after it continue an arc
+#endif
         waitForXFreeLines(2);
         uint8_t wpos2 = linesWritePos + 1;
         if(wpos2 >= PRINTLINE_CACHE_SIZE) wpos2 = 0;
@@ -481,6 +620,10 @@ void PrintLine::calculateMove(float axisDistanceMM[], uint8_t pathOptimize, fast
         //critical = true;
     }
     timeInTicks = timeForMove;
+#if ARC_SUPPORT || BEZIER_SUPPORT
+    if(arcSegmentJoin)
+        flags |= FLAG_ARC_JOIN;
+#endif
     UI_MEDIUM; // do check encoder
     // Compute the slowest allowed interval (ticks/step), so maximum feedrate is not violated
     int32_t limitInterval0;
@@ -507,6 +650,18 @@ void PrintLine::calculateMove(float axisDistanceMM[], uint8_t pathOptimize, fast
     if(isEMove()) {
         axisInterval[E_AXIS] = axisDistanceMM[E_AXIS] * toTicks / Printer::maxFeedrate[E_AXIS];
         limitInterval = RMath::max(axisInterval[E_AXIS], limitInterval);
+#if VOLUMETRIC_FLOW_LIMIT
+        // Printing moves must not extrude more than the hotend can melt. Retracts and primes are not limited.
+        if(isEPositiveMove() && !isEOnlyMove() && Extruder::current->maxVolumetricFlow > 0) {
+            float diameter = (Extruder::current->diameter > 0 ? Extruder::current->diameter : FILAMENT_DIAMETER);
+            int32_t flowInterval = axisDistanceMM[E_AXIS] * toTicks * diameter * diameter * 0.785398163f / Extruder::current->maxVolumetricFlow;
+            extrudingMoves++;
+            if(flowInterval > limitInterval) {
+                limitInterval = flowInterval;
+                flowLimitedMoves++;
+            }
+        }
+#endif
     } else axisInterval[E_AXIS] = 0;
 #if DRIVE_SYSTEM == DELTA
     if(axisDistanceMM[VIRTUAL_AXIS] >= 0) {// only for deltas all speeds in all directions have same limit
@@ -848,6 +1003,11 @@ inline void PrintLine::computeMaxJunctionSpeed(PrintLine *previous, PrintLine *c
         lengthFactor = static_cast<float>(MAX_JERK_DISTANCE * MAX_JERK_DISTANCE) / (previous->distance * previous->distance);
 #endif
     float maxJoinSpeed = RMath::min(current->fullSpeed, previous->fullSpeed);
+#if ARC_SUPPORT || BEZIER_SUPPORT
+    // Segments of the same arc or curve. The centripetal limit is already part of fullSpeed,
+    // so the small direction change between the chords needs no xy jerk limit. Z and E jerk still apply.
+    if((current->flags & FLAG_ARC_JOIN) == 0) {
+#endif
 #if (DRIVE_SYSTEM == DELTA) // No point computing Z Jerk separately for delta moves
 #ifdef ALTERNATIVE_JERK
     float jerk = maxJoinSpeed * lengthFactor * (1.0 - (current->speedX * previous->speedX + current->speedY * previous->speedY + current->speedZ * previous->speedZ) / (current->fullSpeed * previous->fullSpeed));
@@ -871,6 +1031,9 @@ inline void PrintLine::computeMaxJunctionSpeed(PrintLine *previous, PrintLine *c
         if(factor * maxJoinSpeed * 2.0 < Printer::maxJerk)
             factor = Printer::maxJerk / (2.0 * maxJoinSpeed);
     }
+#if ARC_SUPPORT || BEZIER_SUPPORT
+    }
+#endif
 #if DRIVE_SYSTEM != DELTA
     if((previous->dir | current->dir) & ZSTEP) {
         float dz = fabs(current->speedZ - previous->speedZ);
@@ -1835,6 +1998,9 @@ inline void PrintLine::queueEMove(int32_t extrudeDiff, uint8_t check_endstops, u
     if(Printer::isAllEMotors()) {
         p->flags |= FLAG_ALL_E_MOTORS;
     }
+#if MIXING_GRADIENT
+    p->storeMixingWeights();
+#endif
 #endif
     p->joinFlags = 0;
     if(!pathOptimize) p->setEndSpeedFixed(true);
@@ -2005,6 +2171,9 @@ uint8_t PrintLine::queueNonlinearMove(uint8_t check_endstops, uint8_t pathOptimi
         if(Printer::isAllEMotors()) {
             p->flags |= FLAG_ALL_E_MOTORS;
         }
+#if MIXING_GRADIENT
+        p->storeMixingWeights();
+#endif
 #endif
         p->numNonlinearSegments = segmentsPerLine;
 
@@ -2059,6 +2228,69 @@ uint8_t PrintLine::queueNonlinearMove(uint8_t check_endstops, uint8_t pathOptimi
 
 #endif
 
+#if TEMP_MODEL_CONTROL
+/** Average filament speed in mm/s of the queued moves starting within the next lookahead seconds.
+Retractions count as no extrusion. */
+float PrintLine::plannedExtrusionSpeed(float lookahead) {
+    float extruded = 0, duration = 0;
+    ufast8_t p = linesPos;
+    ufast8_t n = linesCount;
+    while(n > 0 && duration < lookahead) {
+        PrintLine &line = lines[p];
+        if(!line.isWarmUp()) {
+            float t = static_cast<float>(line.timeInTicks) * (1.0 / F_CPU);
+            if(line.speedE > 0)
+                extruded += line.speedE * t;
+            duration += t;
+        }
+        nextPlannerIndex(p);
+        n--;
+    }
+    return duration > 0 ? extruded / duration : 0;
+}
+#endif
+
+#if SD_ESTIMATE
+/** Duration in seconds of the move with its planned start, full and end speed. */
+float PrintLine::plannedTime() {
+    if(distance <= 0 || fullSpeed <= 0) return 0;
+#if RAMP_ACCELERATION
+    float a2 = accelerationDistance2 / distance; // 2 * acceleration in mm/s^2
+    float v = fullSpeed;
+    float accelDist = (v * v - startSpeed * startSpeed) / a2;
+    float decelDist = (v * v - endSpeed * endSpeed) / a2;
+    if(accelDist + decelDist > distance) { // full speed is not reached
+        v = sqrt((accelerationDistance2 + startSpeed * startSpeed + endSpeed * endSpeed) * 0.5f);
+        return 2.0f * (2.0f * v - startSpeed - endSpeed) / a2;
+    }
+    return 2.0f * (2.0f * v - startSpeed - endSpeed) / a2 + (distance - accelDist - decelDist) / v;
+#else
+    return distance / fullSpeed;
+#endif
+}
+
+/** Called from the stepper interrupt instead of executing cur while a file gets
+estimated. Waits for a full lookahead like a running print, then adds the time
+of the line and drops it. Returns the ticks until the next call. */
+int32_t PrintLine::estimateLine() {
+    if(estimating == 1 && linesCount < PRINTLINE_CACHE_SIZE - 2) {
+        cur = NULL;
+#if CPU_ARCH == ARCH_ARM
+        nlFlag = false;
+#endif
+        return 2000;
+    }
+    cur->fixStartAndEndSpeed();
+    if(linesPushed - linesCount == estimateMark)
+        estimateMarkTime = estimateTime;
+    estimateTime += cur->plannedTime();
+    if(cur->isEMove())
+        estimateESteps += (cur->isEPositiveMove() ? cur->delta[E_AXIS] : -cur->delta[E_AXIS]);
+    removeCurrentLineForbidInterrupt();
+    return 1000;
+}
+#endif
+
 #if ARC_SUPPORT
 // Arc function taken from grbl
 // The arc is approximated by generating a huge number of tiny, linear segments. The length of each
@@ -2095,6 +2327,22 @@ void PrintLine::arc(float *position, float *target, float *offset, float radius,
     //uint16_t segments = (radius>=BIG_ARC_RADIUS ? floor(millimeters_of_travel/MM_PER_ARC_SEGMENT_BIG) : floor(millimeters_of_travel/MM_PER_ARC_SEGMENT));
     // Increase segment size if printing faster then computation speed allows
     uint16_t segments = (Printer::feedrate > 60.0f ? floor(millimeters_of_travel / RMath::min(static_cast<float>(MM_PER_ARC_SEGMENT_BIG), Printer::feedrate * 0.01666f * static_cast<float>(MM_PER_ARC_SEGMENT))) : floor(millimeters_of_travel / static_cast<float>(MM_PER_ARC_SEGMENT)));
+#if ARC_ADAPTIVE_SEGMENTS
+    // Largest angle per segment keeping the chord within ARC_CHORD_TOLERANCE of the arc.
+    // Small radii need more segments than the fixed segment length gives.
+    float cosHalfTheta = 1.0f - static_cast<float>(ARC_CHORD_TOLERANCE) / radius;
+    float maxThetaPerSegment = (cosHalfTheta > 0.0f ? 2.0f * acos(cosHalfTheta) : M_PI);
+    float chordSegments = RMath::min(ceil(fabs(angular_travel) / maxThetaPerSegment), 65535.0f);
+    if(chordSegments > segments) segments = chordSegments;
+    // Centripetal acceleration v^2/r must not exceed the xy acceleration.
+    float oldFeedrate = Printer::feedrate;
+    float arcAcceleration = (extruder_travel != 0 ?
+                             RMath::min(Printer::maxAccelerationMMPerSquareSecond[X_AXIS], Printer::maxAccelerationMMPerSquareSecond[Y_AXIS]) :
+                             RMath::min(Printer::maxTravelAccelerationMMPerSquareSecond[X_AXIS], Printer::maxTravelAccelerationMMPerSquareSecond[Y_AXIS]));
+    float maxArcSpeed = sqrt(arcAcceleration * radius);
+    if(Printer::feedrate > maxArcSpeed)
+        Printer::feedrate = maxArcSpeed;
+#endif
     if(segments == 0) segments = 1;
     /*
       // Multiply inverse feed_rate to compensate for the fact that this movement is approximated
@@ -2132,8 +2380,15 @@ void PrintLine::arc(float *position, float *target, float *offset, float radius,
        This is important when there are successive arc motions.
     */
     // Vector rotation matrix values
+#if ARC_ADAPTIVE_SEGMENTS
+    // Segments get longer with chord tolerance, so use one more term of the series
+    float theta2 = theta_per_segment * theta_per_segment;
+    float cos_T = 1 - 0.5 * theta2 * (1 - theta2 * 0.083333333f);
+    float sin_T = theta_per_segment * (1 - theta2 * 0.16666667f);
+#else
     float cos_T = 1 - 0.5 * theta_per_segment * theta_per_segment; // Small angle approximation
     float sin_T = theta_per_segment;
+#endif
 
     float arc_target[4];
     float sin_Ti;
@@ -2178,10 +2433,91 @@ void PrintLine::arc(float *position, float *target, float *offset, float radius,
         arc_target[Y_AXIS] = center_axis1 + r_axis1;
         //arc_target[axis_linear] += linear_per_segment;
         arc_target[E_AXIS] += extruder_per_segment;
+#if ARC_ADAPTIVE_SEGMENTS
+        arcSegmentJoin = i > 1; // first segment starts at the previous move
+#endif
         Printer::moveToReal(arc_target[X_AXIS], arc_target[Y_AXIS], IGNORE_COORDINATE, arc_target[E_AXIS], IGNORE_COORDINATE);
+#if ARC_ADAPTIVE_SEGMENTS
+        arcSegmentJoin = false;
+#endif
     }
     // Ensure last segment arrives at target location.
+#if ARC_ADAPTIVE_SEGMENTS
+    arcSegmentJoin = segments > 1;
+#endif
     Printer::moveToReal(target[X_AXIS], target[Y_AXIS], IGNORE_COORDINATE, target[E_AXIS], IGNORE_COORDINATE);
+#if ARC_ADAPTIVE_SEGMENTS
+    arcSegmentJoin = false;
+    Printer::feedrate = oldFeedrate;
+#endif
+}
+#endif
+
+#if BEZIER_SUPPORT
+/**
+  Splits a cubic Bezier curve from position to target with absolute xy control points
+  control1 and control2 into lines. Line length adapts to the local curvature, so the lines
+  stay within ARC_CHORD_TOLERANCE of the curve. Each line gets the speed limit given by
+  the curvature, so the centripetal acceleration stays below the xy acceleration.
+*/
+void PrintLine::bezier(float *position, float *target, float *control1, float *control2) {
+    BezierCurve curve;
+    curve.init(position, control1, control2, target);
+    // First pass gets the length to distribute extrusion and z
+    float t = 0, length = 0, x, y;
+    float lastX = position[X_AXIS], lastY = position[Y_AXIS];
+    do {
+        t = curve.nextT(t, ARC_CHORD_TOLERANCE, MM_PER_ARC_SEGMENT);
+        curve.point(t, x, y);
+        length += sqrt((x - lastX) * (x - lastX) + (y - lastY) * (y - lastY));
+        lastX = x;
+        lastY = y;
+    } while(t < 1.0f);
+    if(length < 0.001f) {
+        return;// treat as succes because there is nothing to do;
+    }
+    float eStart = Printer::currentPositionSteps[E_AXIS] * Printer::invAxisStepsPerMM[E_AXIS];
+    float eTravel = target[E_AXIS] - eStart;
+    float zTravel = target[Z_AXIS] - position[Z_AXIS];
+    float oldFeedrate = Printer::feedrate;
+    float acceleration = (eTravel != 0 ?
+                          RMath::min(Printer::maxAccelerationMMPerSquareSecond[X_AXIS], Printer::maxAccelerationMMPerSquareSecond[Y_AXIS]) :
+                          RMath::min(Printer::maxTravelAccelerationMMPerSquareSecond[X_AXIS], Printer::maxTravelAccelerationMMPerSquareSecond[Y_AXIS]));
+    float done = 0, lastT = 0;
+    float lastCurvature = curve.curvature(0);
+    uint8_t count = 0;
+    lastX = position[X_AXIS];
+    lastY = position[Y_AXIS];
+    do {
+        if((count++ & 3) == 0) {
+            Commands::checkForPeriodicalActions(false);
+            UI_MEDIUM; // do check encoder
+        }
+        t = curve.nextT(lastT, ARC_CHORD_TOLERANCE, MM_PER_ARC_SEGMENT);
+        curve.point(t, x, y);
+        done += sqrt((x - lastX) * (x - lastX) + (y - lastY) * (y - lastY));
+        float curvature = curve.curvature(t);
+        float maxCurvature = RMath::max(RMath::max(lastCurvature, curvature), curve.curvature(0.5f * (lastT + t)));
+        lastCurvature = curvature;
+        Printer::feedrate = oldFeedrate;
+        if(maxCurvature > 0) {
+            float maxSpeed = sqrt(acceleration / maxCurvature);
+            if(Printer::feedrate > maxSpeed)
+                Printer::feedrate = maxSpeed;
+        }
+        arcSegmentJoin = lastT > 0; // first segment starts at the previous move
+        if(t >= 1.0f) // Ensure last segment arrives at target location.
+            Printer::moveToReal(target[X_AXIS], target[Y_AXIS], target[Z_AXIS], target[E_AXIS], IGNORE_COORDINATE);
+        else {
+            float fraction = done / length;
+            Printer::moveToReal(x, y, position[Z_AXIS] + zTravel * fraction, eStart + eTravel * fraction, IGNORE_COORDINATE);
+        }
+        arcSegmentJoin = false;
+        lastX = x;
+        lastY = y;
+        lastT = t;
+    } while(t < 1.0f);
+    Printer::feedrate = oldFeedrate;
 }
 #endif
 
@@ -2248,6 +2584,10 @@ int32_t PrintLine::bresenhamStep() { // Version for delta printer
             removeCurrentLineForbidInterrupt();
             return(wait); // waste some time for path optimization to fill up
         } // End if WARMUP
+#if SD_ESTIMATE
+        if(estimating) // plan only, see SDCard::estimateFile
+            return estimateLine();
+#endif
 #if FEATURE_Z_PROBE
         // z move may consist of more then 1 z line segment, so we better ignore them
         // if the probe was already hit.
@@ -2614,6 +2954,10 @@ int32_t PrintLine::bresenhamStep() { // version for Cartesian printer
             removeCurrentLineForbidInterrupt();
             return(wait); // waste some time for path optimization to fill up
         } // End if WARMUP
+#if SD_ESTIMATE
+        if(estimating) // plan only, see SDCard::estimateFile
+            return estimateLine();
+#endif
         //Only enable axis that are moving. If the axis doesn't need to move then it can stay disabled depending on configuration.
 #if GANTRY
 #if DRIVE_SYSTEM == XY_GANTRY || DRIVE_SYSTEM == YX_GANTRY
@@ -2633,6 +2977,9 @@ int32_t PrintLine::bresenhamStep() { // version for Cartesian printer
         if(cur->isXMove()) Printer::enableXStepper();
         if(cur->isYMove()) Printer::enableYStepper();
         if(cur->isZMove()) Printer::enableZStepper();
+#endif
+#if DISTORTION_STEP_INJECTION
+        if(cur->zCorrPieces) Printer::enableZStepper();
 #endif
         if(cur->isEMove()) Extruder::enable();
         cur->fixStartAndEndSpeed();
@@ -2672,6 +3019,10 @@ int32_t PrintLine::bresenhamStep() { // version for Cartesian printer
 #endif
 #endif // YZ or ZY Gantry
 #endif // GANTRY
+#if DISTORTION_STEP_INJECTION
+        if(cur->zCorrPieces) // move has no own z steps, so z direction belongs to the correction ramp
+            cur->startZCorrectionPiece(cur->stepsRemaining);
+#endif
 #if USE_ADVANCE
         if(!Printer::isAdvanceActivated()) // Set direction if no advance/OPS enabled
 #endif
@@ -2749,6 +3100,10 @@ int32_t PrintLine::bresenhamStep() { // version for Cartesian printer
                 cur->totalStepsRemaining--;
 #endif
             }
+#if DISTORTION_STEP_INJECTION
+        if(cur->zCorrPieces)
+            cur->injectZCorrectionStep();
+#endif
 #if (GANTRY)
 #if DRIVE_SYSTEM == XY_GANTRY || DRIVE_SYSTEM == YX_GANTRY
         Printer::executeXYGantrySteps();
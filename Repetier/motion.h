@@ -31,7 +31,7 @@
 #define FLAG_ACCELERATION_ENABLED 8 // unused
 #define FLAG_CHECK_ENDSTOPS 16
 #define FLAG_ALL_E_MOTORS 32 // For mixed extruder move all motors instead of selected motor
-#define FLAG_SKIP_DEACCELERATING 64 // unused
+#define FLAG_ARC_JOIN 64 // Segment continues the arc or curve of the previous segment
 #define FLAG_BLOCKED 128
 
 /** Are the step parameter computed */
@@ -165,6 +165,18 @@ private:
     float endSpeed;                 ///< Exit speed in mm/s
     float minSpeed;
     float distance;
+#if DISTORTION_STEP_INJECTION || defined(DOXYGEN)
+    uint8_t zCorrPieces;        ///< Number of z correction ramp pieces, 0 = no correction steps to inject.
+    uint8_t zCorrPiece;         ///< Ramp piece currently executed.
+    uint8_t zCorrDirs;          ///< Bit i set = piece i moves z in positive direction.
+    int32_t zCorrLength;        ///< Primary axis steps of the current piece.
+    int32_t zCorrError;         ///< Error calculation for Bresenham algorithm of current piece
+    int32_t zCorrEnd[DISTORTION_RAMP_PIECES];    ///< Value of stepsRemaining where piece ends.
+    uint16_t zCorrSteps[DISTORTION_RAMP_PIECES]; ///< Z correction steps to inject within piece.
+#endif
+#if MIXING_GRADIENT || defined(DOXYGEN)
+    int mixingWeights[NUM_EXTRUDER];    ///< Balanced mixing weights when the move was queued
+#endif
 #if NONLINEAR_SYSTEM || defined(DOXYGEN)
     uint8_t numNonlinearSegments;       ///< Number of delta segments left in line. Decremented by stepper timer.
     uint8_t moveID;                 ///< ID used to identify moves which are all part of the same line
@@ -195,6 +207,23 @@ public:
     int32_t stepsRemaining;            ///< Remaining steps, until move is finished
     static PrintLine *cur;
     static volatile ufast8_t linesCount; // Number of lines cached 0 = nothing to do
+#if SD_CHECKPOINT || SD_ESTIMATE
+    static uint32_t linesPushed; // Lines queued since start, finished = linesPushed - linesCount
+#endif
+#if SD_ESTIMATE
+    static volatile uint8_t estimating; // 1 = drop planned lines once lookahead is full, 2 = drop all lines
+    static float estimateTime; // Planned seconds of dropped lines
+    static int32_t estimateESteps; // Net e steps of dropped lines
+    static uint32_t estimateMark; // Line number starting the next layer
+    static float estimateMarkTime; // estimateTime when estimateMark was reached
+#endif
+#if ARC_SUPPORT || BEZIER_SUPPORT
+    static bool arcSegmentJoin; // Next queued line continues the current arc or curve
+#endif
+#if VOLUMETRIC_FLOW_LIMIT
+    static uint32_t extrudingMoves; // Printing moves checked against the volumetric limit
+    static uint32_t flowLimitedMoves; // Printing moves slowed down by the volumetric limit
+#endif
     inline bool areParameterUpToDate() {
         return joinFlags & FLAG_JOIN_STEPPARAMS_COMPUTED;
     }
@@ -219,6 +248,12 @@ public:
     inline void setEndSpeedFixed(bool newState) {
         joinFlags = (newState ? joinFlags | FLAG_JOIN_END_FIXED : joinFlags & ~FLAG_JOIN_END_FIXED);
     }
+#if MIXING_GRADIENT
+    inline void storeMixingWeights() {
+        for(fast8_t i = 0; i < NUM_EXTRUDER; i++)
+            mixingWeights[i] = extruder[i].mixingWB;
+    }
+#endif
     inline bool isWarmUp() {
         return flags & FLAG_WARMUP;
     }
@@ -616,6 +651,38 @@ public:
         totalStepsRemaining--;
 #endif
     }
+#if DISTORTION_STEP_INJECTION || defined(DOXYGEN)
+    /** Initializes Bresenham parameter for the active z correction ramp piece.
+    \return true if the z direction pin was changed. */
+    INLINE bool startZCorrectionPiece(int32_t pieceStart) {
+        zCorrLength = pieceStart - zCorrEnd[zCorrPiece];
+        zCorrError = zCorrLength >> 1;
+        bool positive = zCorrDirs & (1 << zCorrPiece);
+        if(zCorrSteps[zCorrPiece] == 0 || positive == Printer::getZDirection())
+            return false; // pieces without steps keep the direction
+        Printer::setZDirection(positive);
+        return true;
+    }
+    /** Steps z if the correction ramp requires it. Must be called once for every
+    primary axis step before stepsRemaining gets decremented. Only called from stepper interrupt. */
+    INLINE void injectZCorrectionStep() {
+        while(stepsRemaining <= zCorrEnd[zCorrPiece] && zCorrPiece < zCorrPieces - 1) {
+            int32_t pieceStart = zCorrEnd[zCorrPiece];
+            zCorrPiece++;
+#if defined(DIRECTION_DELAY) && DIRECTION_DELAY > 0
+            if(startZCorrectionPiece(pieceStart))
+                HAL::delayMicroseconds(DIRECTION_DELAY);
+#else
+            startZCorrectionPiece(pieceStart);
+#endif
+        }
+        if((zCorrError -= zCorrSteps[zCorrPiece]) < 0) {
+            Printer::startZStep();
+            zCorrError += zCorrLength;
+        }
+    }
+    int32_t computeZCorrectionRamp(int32_t startX, int32_t startY, int32_t startCorrection);
+#endif
     void updateStepsParameter();
     float safeSpeed(fast8_t drivingAxis);
     void calculateMove(float axis_diff[], uint8_t pathOptimize, fast8_t distanceBase);
@@ -632,6 +699,11 @@ public:
     }
     static INLINE void setCurrentLine() {
         cur = &lines[linesPos];
+#if MIXING_GRADIENT
+        Extruder::mixingS = 0;
+        for(fast8_t i = 0; i < NUM_EXTRUDER; i++)
+            Extruder::mixingS += (Extruder::mixingWA[i] = cur->mixingWeights[i]);
+#endif
 #if CPU_ARCH==ARCH_ARM
         PrintLine::nlFlag = true;
 #endif
@@ -653,6 +725,9 @@ public:
         Printer::setMenuMode(MENU_MODE_PRINTING, true);
         InterruptProtectedBlock noInts;
         linesCount++;
+#if SD_CHECKPOINT || SD_ESTIMATE
+        linesPushed++;
+#endif
     }
     static uint8_t getLinesCount() {
         InterruptProtectedBlock noInts;
@@ -661,6 +736,13 @@ public:
     static PrintLine *getNextWriteLine() {
         return &lines[linesWritePos];
     }
+#if TEMP_MODEL_CONTROL
+    static float plannedExtrusionSpeed(float lookahead);
+#endif
+#if SD_ESTIMATE
+    float plannedTime();
+    static int32_t estimateLine();
+#endif
     static inline void computeMaxJunctionSpeed(PrintLine *previous, PrintLine *current);
     static int32_t bresenhamStep();
     static void waitForXFreeLines(uint8_t b = 1, bool allowMoves = false);
@@ -672,13 +754,16 @@ public:
 #if !NONLINEAR_SYSTEM || defined(DOXYGEN)
     static void queueCartesianMove(uint8_t check_endstops, uint8_t pathOptimize);
 #if DISTORTION_CORRECTION || defined(DOXYGEN)
-    static void queueCartesianSegmentTo(uint8_t check_endstops, uint8_t pathOptimize);
+    static void queueCartesianSegmentTo(uint8_t check_endstops, uint8_t pathOptimize, bool injectCorrection = false);
 #endif
 #endif
     static void moveRelativeDistanceInSteps(int32_t x, int32_t y, int32_t z, int32_t e, float feedrate, bool waitEnd, bool check_endstop, bool pathOptimize = true);
     static void moveRelativeDistanceInStepsReal(int32_t x, int32_t y, int32_t z, int32_t e, float feedrate, bool waitEnd, bool pathOptimize = true);
 #if ARC_SUPPORT || defined(DOXYGEN)
     static void arc(float *position, float *target, float *offset, float radius, uint8_t isclockwise);
+#endif
+#if BEZIER_SUPPORT || defined(DOXYGEN)
+    static void bezier(float *position, float *target, float *control1, float *control2);
 #endif
     static INLINE void previousPlannerIndex(ufast8_t &p) {
         p = (p ? p - 1 : PRINTLINE_CACHE_SIZE - 1);
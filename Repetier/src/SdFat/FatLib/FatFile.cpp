@@ -761,7 +761,8 @@ int FatFile::read(void* buf, size_t nbyte) {
                 n = toRead;
             }
             // read block to cache and copy data to caller
-            pc = m_vol->cacheFetchData(block, FatCache::CACHE_FOR_READ);
+            pc = m_vol->cacheFetchData(block, isDir() ? FatCache::CACHE_FOR_READ
+                                       : FatCache::CACHE_OPTION_NO_LRU);
             if (!pc) {
                 DBG_FAIL_MACRO;
                 goto fail;
@@ -1425,6 +1426,9 @@ int FatFile::write(const void* buf, size_t nbyte) {
                 // rewrite part of block
                 cacheOption = FatCache::CACHE_FOR_WRITE;
             }
+            if (!isDir()) {
+                cacheOption |= FatCache::CACHE_OPTION_NO_LRU;
+            }
             pc = m_vol->cacheFetchData(block, cacheOption);
             if (!pc) {
                 DBG_FAIL_MACRO;
@@ -71,6 +71,14 @@
 #endif  // __arm__
 #endif  // USE_SEPARATE_FAT_CACHE
 //------------------------------------------------------------------------------
+/**
+ * Set SD_BLOCK_CACHE to the number of 512 byte blocks kept in a LRU cache
+ * behind the FAT and directory caches. Zero disables the LRU cache.
+ */
+#ifndef SD_BLOCK_CACHE
+#define SD_BLOCK_CACHE 0
+#endif  // SD_BLOCK_CACHE
+//------------------------------------------------------------------------------
 /**
  * Set USE_MULTI_BLOCK_IO non-zero to use multi-block SD read/write.
  *
@@ -34,7 +34,12 @@ cache_t* FatCache::read(uint32_t lbn, uint8_t option) {
       goto fail;
     }
     if (!(option & CACHE_OPTION_NO_READ)) {
+#if SD_BLOCK_CACHE
+      if (option & CACHE_OPTION_NO_LRU ? !m_vol->readBlock(lbn, m_block.data)
+          : !m_vol->lruReadBlock(lbn, m_block.data)) {
+#else  // SD_BLOCK_CACHE
       if (!m_vol->readBlock(lbn, m_block.data)) {
+#endif  // SD_BLOCK_CACHE
         DBG_FAIL_MACRO;
         goto fail;
       }
@@ -71,6 +76,62 @@ bool FatCache::sync() {
 fail:
   return false;
 }
+#if SD_BLOCK_CACHE
+//------------------------------------------------------------------------------
+void FatVolume::lruInit() {
+  for (uint8_t i = 0; i < SD_BLOCK_CACHE; i++) {
+    m_lruLbn[i] = 0XFFFFFFFF;
+    m_lruAge[i] = i;
+  }
+  m_lruHits = m_lruMisses = 0;
+}
+//------------------------------------------------------------------------------
+bool FatVolume::lruReadBlock(uint32_t block, uint8_t* dst) {
+  uint8_t i;
+  for (i = 0; i < SD_BLOCK_CACHE; i++) {
+    if (m_lruLbn[i] == block) {
+      memcpy(dst, m_lruBlock[i].data, 512);
+      lruTouch(i);
+      m_lruHits++;
+      return true;
+    }
+  }
+  m_lruMisses++;
+  if (!readBlock(block, dst)) {
+    return false;
+  }
+  // Replace the least recently used entry.
+  for (i = 0; i < SD_BLOCK_CACHE - 1; i++) {
+    if (m_lruAge[i] == SD_BLOCK_CACHE - 1) {
+      break;
+    }
+  }
+  memcpy(m_lruBlock[i].data, dst, 512);
+  m_lruLbn[i] = block;
+  lruTouch(i);
+  return true;
+}
+//------------------------------------------------------------------------------
+void FatVolume::lruTouch(uint8_t i) {
+  uint8_t age = m_lruAge[i];
+  for (uint8_t j = 0; j < SD_BLOCK_CACHE; j++) {
+    if (m_lruAge[j] < age) {
+      m_lruAge[j]++;
+    }
+  }
+  m_lruAge[i] = 0;
+}
+//------------------------------------------------------------------------------
+void FatVolume::lruWrite(uint32_t block, const uint8_t* src, size_t nb) {
+  // Write through so cached copies never get stale.
+  for (uint8_t i = 0; i < SD_BLOCK_CACHE; i++) {
+    uint32_t offset = m_lruLbn[i] - block;
+    if (offset < nb) {
+      memcpy(m_lruBlock[i].data, src + 512 * offset, 512);
+    }
+  }
+}
+#endif  // SD_BLOCK_CACHE
 //------------------------------------------------------------------------------
 bool FatVolume::allocateCluster(uint32_t current, uint32_t* next) {
   uint32_t find = current ? current : m_allocSearchStart;
@@ -441,6 +502,9 @@ bool FatVolume::init(uint8_t part) {
   m_fatType = 0;
   m_allocSearchStart = 1;
   m_cache.init(this);
+#if SD_BLOCK_CACHE
+  lruInit();
+#endif  // SD_BLOCK_CACHE
 #if USE_SEPARATE_FAT_CACHE
   m_fatCache.init(this);
 #endif  // USE_SEPARATE_FAT_CACHE
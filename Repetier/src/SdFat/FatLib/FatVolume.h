@@ -104,6 +104,8 @@ class FatCache {
     = CACHE_STATUS_DIRTY | CACHE_STATUS_MIRROR_FAT;
   /** Sync existing block but do not read new block. */
   static const uint8_t CACHE_OPTION_NO_READ = 4;
+  /** File data block, do not keep it in the LRU block cache. */
+  static const uint8_t CACHE_OPTION_NO_LRU = 8;
   /** Cache block for read. */
   static const uint8_t CACHE_FOR_READ = 0;
   /** Cache block for write. */
@@ -260,6 +262,20 @@ class FatVolume {
   int8_t dbgFat(uint32_t n, uint32_t* v) {
     return fatGet(n, v);
   }
+#if SD_BLOCK_CACHE
+  /** \return Number of FAT/directory block reads served by the LRU cache. */
+  uint32_t lruHits() const {
+    return m_lruHits;
+  }
+  /** \return Number of FAT/directory block reads that went to the card. */
+  uint32_t lruMisses() const {
+    return m_lruMisses;
+  }
+  /** Reset the LRU cache hit/miss counters. */
+  void lruClearStats() {
+    m_lruHits = m_lruMisses = 0;
+  }
+#endif  // SD_BLOCK_CACHE
 //------------------------------------------------------------------------------
  private:
   // Allow FatFile and FatCache access to FatVolume private functions.
@@ -288,6 +304,9 @@ class FatVolume {
     return m_blockDev->syncBlocks();
   }
   bool writeBlock(uint32_t block, const uint8_t* src) {
+#if SD_BLOCK_CACHE
+    lruWrite(block, src, 1);
+#endif  // SD_BLOCK_CACHE
     return m_blockDev->writeBlock(block, src);
   }
 #if USE_MULTI_BLOCK_IO
@@ -295,9 +314,24 @@ class FatVolume {
     return m_blockDev->readBlocks(block, dst, nb);
   }
   bool writeBlocks(uint32_t block, const uint8_t* src, size_t nb) {
+#if SD_BLOCK_CACHE
+    lruWrite(block, src, nb);
+#endif  // SD_BLOCK_CACHE
     return m_blockDev->writeBlocks(block, src, nb);
   }
 #endif  // USE_MULTI_BLOCK_IO
+#if SD_BLOCK_CACHE
+  // LRU cache for blocks read through FatCache, age 0 is the newest entry.
+  cache_t  m_lruBlock[SD_BLOCK_CACHE];
+  uint32_t m_lruLbn[SD_BLOCK_CACHE];
+  uint8_t  m_lruAge[SD_BLOCK_CACHE];
+  uint32_t m_lruHits;
+  uint32_t m_lruMisses;
+  void lruInit();
+  bool lruReadBlock(uint32_t block, uint8_t* dst);
+  void lruTouch(uint8_t i);
+  void lruWrite(uint32_t block, const uint8_t* src, size_t nb);
+#endif  // SD_BLOCK_CACHE
 #if MAINTAIN_FREE_CLUSTER_COUNT
   int32_t  m_freeClusterCount;     // Count of free clusters in volume.
   void setFreeClusterCount(int32_t value) {
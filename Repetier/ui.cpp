@@ -1897,8 +1897,125 @@ void UIDisplay::setStatus(const char *txt, bool error) {
 
 const UIMenu * const ui_pages[UI_NUM_PAGES] PROGMEM = UI_PAGES;
 uint16_t nFilesOnCard;
+#if SD_DIR_INDEX
+/** Entry of the sorted index of the directory shown in the file selector. */
+struct UISDIndexEntry {
+    uint32_t key; ///< Sort key, bit 31 is set for files so folders come first
+    uint16_t dirIndex; ///< Position of the entry in the directory
+};
+UISDIndexEntry sdIndex[SD_DIR_INDEX];
+uint16_t sdIndexCount = 0;
+bool sdIndexValid = false; // false if directory has more than SD_DIR_INDEX entries
+uint8_t sdIndexGeneration = 0;
+
+static uint32_t sdIndexKey(FatFile &file, const char *name) {
+    if(name[0] == '.' && name[1] == '.') return 0; // parent folder stays on top
+    uint32_t key = file.isDir() ? 0 : 0x80000000UL;
+#if SD_DIR_SORT == 1
+    dir_t d;
+    file.dirEntry(&d);
+    key |= (~((static_cast<uint32_t>(d.lastWriteDate) << 16) | d.lastWriteTime)) >> 1; // newest first
+#else
+    for(uint8_t i = 0; i < 5; i++) { // first 5 chars with 6 bit each, ties are solved by name compare
+        uint8_t c = static_cast<uint8_t>(*name);
+        if(c) name++;
+        if(c >= 'a' && c <= 'z') c -= 'a' - 'A';
+        c = (c < 32 ? 0 : (c > 95 ? 63 : c - 32));
+        key |= static_cast<uint32_t>(c) << (24 - 6 * i);
+    }
+#endif
+    return key;
+}
+
+#if SD_DIR_SORT == 0
+static int8_t sdIndexCompareNames(const char *a, const char *b) {
+    while(true) {
+        uint8_t ca = static_cast<uint8_t>(*a++), cb = static_cast<uint8_t>(*b++);
+        if(ca >= 'a' && ca <= 'z') ca -= 'a' - 'A';
+        if(cb >= 'a' && cb <= 'z') cb -= 'a' - 'A';
+        if(ca != cb) return ca < cb ? -1 : 1;
+        if(ca == 0) return 0;
+    }
+}
+#endif
+
+/** Returns true if the entry with key and tempLongFilename sorts before e. */
+static bool sdIndexBefore(FatFile *root, uint32_t key, UISDIndexEntry &e) {
+    if(key != e.key)
+        return key < e.key;
+#if SD_DIR_SORT == 0
+    char other[LONG_FILENAME_LENGTH + 1];
+    FatFile file;
+    uint32_t pos = root->curPosition(); // keep enumeration position
+    other[0] = 0;
+    if(file.open(root, e.dirIndex, O_READ)) {
+        file.getName(other, LONG_FILENAME_LENGTH);
+        file.close();
+    }
+    root->seekSet(pos);
+    return sdIndexCompareNames(tempLongFilename, other) < 0;
+#else
+    return false;
+#endif
+}
+
+/** Reads the current directory once and fills the index sorted by insertion. */
+static void sdIndexBuild() {
+    FatFile *root = sd.fat.vwd();
+    FatFile file;
+    sdIndexCount = 0;
+    sdIndexValid = true;
+    sdIndexGeneration = sd.dirGeneration;
+    root->rewind();
+    while (file.openNext(root, O_READ)) {
+        HAL::pingWatchdog();
+        file.getName(tempLongFilename, LONG_FILENAME_LENGTH);
+        if ((uid.folderLevel >= SD_MAX_FOLDER_DEPTH && strcmp(tempLongFilename, "..") == 0) ||
+                (tempLongFilename[0] == '.' && tempLongFilename[1] != '.')) {
+            file.close();
+            continue;
+        }
+        if(sdIndexCount >= SD_DIR_INDEX) { // too large, list unsorted
+            file.close();
+            sdIndexValid = false;
+            return;
+        }
+        uint32_t key = sdIndexKey(file, tempLongFilename);
+        uint16_t dirIndex = file.dirIndex();
+        file.close();
+        uint16_t lo = 0, hi = sdIndexCount;
+        while(lo < hi) { // insert behind equal entries
+            uint16_t mid = (lo + hi) >> 1;
+            if(sdIndexBefore(root, key, sdIndex[mid]))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        memmove(&sdIndex[lo + 1], &sdIndex[lo], (sdIndexCount - lo) * sizeof(UISDIndexEntry));
+        sdIndex[lo].key = key;
+        sdIndex[lo].dirIndex = dirIndex;
+        sdIndexCount++;
+    }
+}
+
+/** Rebuilds the index if files were changed since and returns true if it can be used. */
+static bool sdIndexUsable() {
+    if(sdIndexGeneration != sd.dirGeneration)
+        uid.updateSDFileCount();
+    return sdIndexValid;
+}
+#endif
+
 void UIDisplay::updateSDFileCount() {
 #if SDSUPPORT
+#if SD_DIR_INDEX
+    sd.fat.chdir(cwd);
+    sdIndexBuild();
+    if(sdIndexValid) {
+        nFilesOnCard = sdIndexCount;
+        return;
+    }
+#endif
     dir_t* p = NULL;
     FatFile *root = sd.fat.vwd();
     FatFile file;
@@ -1930,6 +2047,18 @@ void getSDFilenameAt(uint16_t filePos, char *filename) {
     dir_t* p = NULL;
     FatFile *root = sd.fat.vwd();
     FatFile file;
+#if SD_DIR_INDEX
+    if(sdIndexUsable()) {
+        filename[0] = 0;
+        if(filePos < sdIndexCount && file.open(root, sdIndex[filePos].dirIndex, O_READ)) {
+            file.getName(tempLongFilename, LONG_FILENAME_LENGTH);
+            strcpy(filename, tempLongFilename);
+            if(file.isDir()) strcat(filename, "/"); // Set marker for directory
+            file.close();
+        }
+        return;
+    }
+#endif
     root->rewind();
     while (file.openNext(root, O_READ)) {
         HAL::pingWatchdog();
@@ -1984,6 +2113,25 @@ void UIDisplay::goDir(char *name) {
     updateSDFileCount();
 #endif
 }
+#if SDSUPPORT
+/** write file name in tempLongFilename to row r */
+static void sdPrintRow(uint16_t &r, char cache[UI_ROWS][MAX_COLS + 1], uint16_t offset, bool isDir) {
+    uid.col = 0;
+    if(r + offset == uid.menuPos[uid.menuLevel])
+        uid.printCols[uid.col++] = CHAR_SELECTOR;
+    else
+        uid.printCols[uid.col++] = ' ';
+    // print file name with possible blank fill
+    if(isDir)
+        uid.printCols[uid.col++] = bFOLD; // Prepend folder symbol
+    uint16_t length = RMath::min((int)strlen(tempLongFilename), MAX_COLS - uid.col);
+    memcpy(uid.printCols + uid.col, tempLongFilename, length);
+    uid.col += length;
+    uid.printCols[uid.col] = 0;
+    strcpy(cache[r++], uid.printCols);
+}
+#endif
+
 /** write file names at current position to lcd */
 void sdrefresh(uint16_t &r, char cache[UI_ROWS][MAX_COLS + 1]) {
 #if SDSUPPORT
@@ -1991,7 +2139,7 @@ void sdrefresh(uint16_t &r, char cache[UI_ROWS][MAX_COLS + 1]) {
     uint16_t offset = uid.menuTop[uid.menuLevel];
     FatFile *root;
     FatFile file;
-    uint16_t length, skip;
+    uint16_t skip;
 
     sd.fat.chdir(uid.cwd);
     root = sd.fat.vwd();
@@ -1999,6 +2147,18 @@ void sdrefresh(uint16_t &r, char cache[UI_ROWS][MAX_COLS + 1]) {
 
     skip = (offset > 0 ? offset - 1 : 0);
 
+#if SD_DIR_INDEX
+    if(sdIndexUsable()) { // open only the visible entries
+        for(uint16_t i = skip; i < sdIndexCount && r < UI_ROWS; i++) {
+            if(!file.open(root, sdIndex[i].dirIndex, O_READ))
+                break;
+            file.getName(tempLongFilename, LONG_FILENAME_LENGTH);
+            sdPrintRow(r, cache, offset, file.isDir());
+            file.close();
+        }
+        return;
+    }
+#endif
     while (r + offset < nFilesOnCard + 1 && r < UI_ROWS && file.openNext(root, O_READ)) {
         HAL::pingWatchdog();
         file.getName(tempLongFilename, LONG_FILENAME_LENGTH);
@@ -2020,19 +2180,7 @@ void sdrefresh(uint16_t &r, char cache[UI_ROWS][MAX_COLS + 1]) {
             file.close();
             continue;
         }
-        uid.col = 0;
-        if(r + offset == uid.menuPos[uid.menuLevel])
-            uid.printCols[uid.col++] = CHAR_SELECTOR;
-        else
-            uid.printCols[uid.col++] = ' ';
-        // print file name with possible blank fill
-        if(DIR_IS_SUBDIR(p))
-            uid.printCols[uid.col++] = bFOLD; // Prepend folder symbol
-        length = RMath::min((int)strlen(tempLongFilename), MAX_COLS - uid.col);
-        memcpy(uid.printCols + uid.col, tempLongFilename, length);
-        uid.col += length;
-        uid.printCols[uid.col] = 0;
-        strcpy(cache[r++], uid.printCols);
+        sdPrintRow(r, cache, offset, DIR_IS_SUBDIR(p));
         file.close();
     }
 #endif
@@ -2558,6 +2706,9 @@ int UIDisplay::okAction(bool allowMoves) {
                 sd.sdmode = 0;
                 sd.file.close();
                 if(sd.fat.remove(filename)) {
+#if SD_DIR_INDEX
+                    sd.dirGeneration++;
+#endif
                     Com::printFLN(Com::tFileDeleted);
                     BEEP_LONG
                     if(menuPos[menuLevel] > 0)
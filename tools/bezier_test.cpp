@@ -0,0 +1,174 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Checks the G5 flattening of BezierCurve::nextT. Every line must stay within the
+   chord tolerance of the exact curve and must not be longer than the segment limit.
+   For comparison the number of uniform G1 lines a slicer would need for the same
+   error is reported. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "Bezier.h"
+
+struct Curve {
+    const char *name;
+    float p[4][2];
+};
+
+static Curve curves[] = {
+    {"straight", {{0, 0}, {10, 0}, {20, 0}, {30, 0}}},
+    {"quarter circle", {{50, 0}, {50, 27.614f}, {27.614f, 50}, {0, 50}}},
+    {"s-curve", {{0, 0}, {40, 0}, {-20, 30}, {20, 30}}},
+    {"loop", {{0, 0}, {60, 40}, {-60, 40}, {0, 0.5f}}},
+    {"cusp", {{0, 0}, {30, 30}, {0, 30}, {30, 0}}},
+    {"tiny", {{100, 100}, {100.2f, 100.3f}, {100.4f, 99.9f}, {100.5f, 100.1f}}},
+    {"long flat", {{0, 0}, {100, 5}, {200, -5}, {300, 0}}},
+};
+
+static unsigned long randomState = 12345;
+static float randomCoordinate() {
+    randomState = randomState * 1103515245UL + 12345UL;
+    return static_cast<float>((randomState >> 8) % 200000) * 0.001f;
+}
+
+// Exact curve point in double precision
+static void exactPoint(const float p[4][2], double t, double &x, double &y) {
+    double mt = 1.0 - t;
+    double b0 = mt * mt * mt, b1 = 3.0 * mt * mt * t, b2 = 3.0 * mt * t * t, b3 = t * t * t;
+    x = b0 * p[0][0] + b1 * p[1][0] + b2 * p[2][0] + b3 * p[3][0];
+    y = b0 * p[0][1] + b1 * p[1][1] + b2 * p[2][1] + b3 * p[3][1];
+}
+
+static double distanceToLine(double px, double py, double ax, double ay, double bx, double by) {
+    double dx = bx - ax, dy = by - ay;
+    double l2 = dx * dx + dy * dy;
+    double f = (l2 > 0 ? ((px - ax) * dx + (py - ay) * dy) / l2 : 0);
+    if(f < 0) f = 0;
+    if(f > 1) f = 1;
+    double ex = ax + f * dx - px, ey = ay + f * dy - py;
+    return sqrt(ex * ex + ey * ey);
+}
+
+// Maximum distance of the curve between t0 and t1 from the line between the given points
+static double lineError(const float p[4][2], double t0, double t1, double ax, double ay, double bx, double by) {
+    double maxError = 0;
+    for(int i = 0; i <= 64; i++) {
+        double x, y;
+        exactPoint(p, t0 + (t1 - t0) * i / 64.0, x, y);
+        double e = distanceToLine(x, y, ax, ay, bx, by);
+        if(e > maxError) maxError = e;
+    }
+    return maxError;
+}
+
+struct Result {
+    int lines;
+    double maxError;
+    double maxLength;
+};
+
+static Result flatten(const float p[4][2], float tolerance, float maxLength) {
+    BezierCurve curve;
+    curve.init(p[0], p[1], p[2], p[3]);
+    Result r = {0, 0, 0};
+    float t = 0, lastX = p[0][0], lastY = p[0][1];
+    do {
+        float lastT = t, x, y;
+        t = curve.nextT(t, tolerance, maxLength);
+        curve.point(t, x, y);
+        double e = lineError(p, lastT, t, lastX, lastY, x, y);
+        double l = sqrt((x - lastX) * (x - lastX) + (y - lastY) * (y - lastY));
+        if(e > r.maxError) r.maxError = e;
+        if(l > r.maxLength) r.maxLength = l;
+        lastX = x;
+        lastY = y;
+        r.lines++;
+    } while(t < 1.0f && r.lines < 100000);
+    return r;
+}
+
+// Uniform lines in t a slicer would emit to reach the same maximum error
+static int uniformLines(const float p[4][2], double maxError) {
+    for(int n = 1; n < 100000; n += (n < 64 ? 1 : n / 16)) {
+        double worst = 0, lastX = p[0][0], lastY = p[0][1];
+        for(int i = 1; i <= n && worst <= maxError; i++) {
+            double x, y;
+            exactPoint(p, static_cast<double>(i) / n, x, y);
+            double e = lineError(p, static_cast<double>(i - 1) / n, static_cast<double>(i) / n, lastX, lastY, x, y);
+            if(e > worst) worst = e;
+            lastX = x;
+            lastY = y;
+        }
+        if(worst <= maxError) return n;
+    }
+    return 100000;
+}
+
+int main() {
+    static const float tolerances[] = {0.002f, 0.01f, 0.05f};
+    static const float maxLengths[] = {1.0f, 5.0f, 1000.0f};
+    const int fixedCurves = sizeof(curves) / sizeof(curves[0]);
+    const int randomCurves = 200;
+    int failures = 0;
+    double worstError = 0, worstLength = 0;
+    long adaptiveTotal = 0, uniformTotal = 0;
+    printf("%-16s %9s %9s %7s %9s %9s %8s\n", "curve", "tolerance", "maxLength", "lines", "error", "length", "uniform");
+    for(int c = 0; c < fixedCurves + randomCurves; c++) {
+        Curve rc;
+        const Curve *curve = &rc;
+        if(c < fixedCurves)
+            curve = &curves[c];
+        else {
+            rc.name = "random";
+            for(int i = 0; i < 4; i++)
+                for(int j = 0; j < 2; j++)
+                    rc.p[i][j] = randomCoordinate();
+        }
+        for(unsigned ti = 0; ti < sizeof(tolerances) / sizeof(tolerances[0]); ti++) {
+            for(unsigned li = 0; li < sizeof(maxLengths) / sizeof(maxLengths[0]); li++) {
+                float tolerance = tolerances[ti], maxLength = maxLengths[li];
+                Result r = flatten(curve->p, tolerance, maxLength);
+                // float coordinates of ~200 mm carry about 1e-5 mm rounding
+                bool ok = r.maxError <= tolerance + 1e-4 && r.maxLength <= maxLength * 1.01 + 1e-4;
+                double relativeError = r.maxError / tolerance;
+                double relativeLength = r.maxLength / maxLength;
+                if(relativeError > worstError) worstError = relativeError;
+                if(relativeLength > worstLength) worstLength = relativeLength;
+                if(maxLength > 100) { // pure tolerance limit, compare with uniform G1 lines
+                    int uniform = uniformLines(curve->p, tolerance);
+                    adaptiveTotal += r.lines;
+                    uniformTotal += uniform;
+                    if(c < fixedCurves)
+                        printf("%-16s %9.3f %9.0f %7d %9.5f %9.3f %8d\n", curve->name, tolerance, maxLength, r.lines, r.maxError, r.maxLength, uniform);
+                }
+                if(!ok) {
+                    failures++;
+                    printf("FAIL %s tolerance %g maxLength %g: error %g length %g\n", curve->name, tolerance, maxLength, r.maxError, r.maxLength);
+                }
+            }
+        }
+    }
+    printf("%d curves, worst error %.3f of tolerance, worst line %.3f of max. length\n", fixedCurves + randomCurves, worstError, worstLength);
+    printf("lines for pure chord tolerance: adaptive %ld, uniform G1 %ld\n", adaptiveTotal, uniformTotal);
+    if(failures) {
+        printf("bezier_test: %d failures\n", failures);
+        return 1;
+    }
+    printf("bezier_test: ok\n");
+    return 0;
+}
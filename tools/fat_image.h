@@ -0,0 +1,146 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* SdFat of the firmware on a FAT32 image in host memory for the SD benchmarks.
+   The image replaces the SPI card, it counts every block transfer and whether the
+   block went into the SdFat cache or straight into the caller's buffer. Unwritten
+   blocks read as zero, so large cards only cost the blocks that are used.
+   Set SD_BLOCK_CACHE before including this file to test the LRU block cache. */
+
+#ifndef _FAT_IMAGE_H
+#define _FAT_IMAGE_H
+
+#include <map>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Use the FAT library without Repetier.h, Arduino and the SPI card driver.
+#define _REPETIER_H
+#define SdFatConfig_h
+#define BlockDriver_h
+#define SDSUPPORT 1
+#define ENABLE_ARDUINO_FEATURES 0
+#define USE_LONG_FILE_NAMES 1
+#define USE_MULTI_BLOCK_IO 0 // the AVR settings
+#define MAX_VFAT_ENTRIES (2)
+
+/** Only used by FatVolume::wipe and FatFile::printSFN */
+struct Com {
+    static void print(char) {}
+    static void print(const char *) {}
+    static void println() {}
+};
+
+class BlockDriver {
+public:
+    uint32_t reads;        ///< Blocks read from the card
+    uint32_t cacheReads;   ///< Blocks read into the SdFat cache
+    uint32_t writes;       ///< Blocks written to the card
+    const uint8_t *cache;  ///< SdFat cache, set by FatImage::begin
+
+    BlockDriver() : cache(0) {
+        clearStats();
+    }
+    void clearStats() {
+        reads = cacheReads = writes = 0;
+    }
+    bool readBlock(uint32_t block, uint8_t *dst) {
+        reads++;
+        if(dst == cache)
+            cacheReads++;
+        std::map<uint32_t, Block>::const_iterator it = blocks.find(block);
+        if(it == blocks.end())
+            memset(dst, 0, 512);
+        else
+            memcpy(dst, it->second.data, 512);
+        return true;
+    }
+    bool writeBlock(uint32_t block, const uint8_t *src) {
+        writes++;
+        memcpy(blocks[block].data, src, 512);
+        return true;
+    }
+    bool syncBlocks() {
+        return true;
+    }
+private:
+    struct Block {
+        uint8_t data[512];
+    };
+    std::map<uint32_t, Block> blocks;
+};
+
+#pragma GCC diagnostic push // the library is written for avr-gcc
+#pragma GCC diagnostic ignored "-Wpragmas"
+#pragma GCC diagnostic ignored "-Wclass-memaccess"
+#pragma GCC diagnostic ignored "-Waddress-of-packed-member"
+#include "src/SdFat/FatLib/FatVolume.cpp"
+#include "src/SdFat/FatLib/FatFile.cpp"
+#include "src/SdFat/FatLib/FatFileLFN.cpp"
+#include "src/SdFat/FatLib/FatFileSFN.cpp"
+#include "src/SdFat/FatLib/FatFileSystem.h"
+#pragma GCC diagnostic pop
+
+/** FAT32 card with 32 KB clusters like SD cards from 4 to 32 GB come formatted. */
+class FatImage : public FatFileSystem {
+public:
+    BlockDriver card;
+
+    /** Formats the image with totalBlocks blocks and mounts it. */
+    bool begin(uint32_t totalBlocks = 8UL << 21, uint8_t blocksPerCluster = 64) {
+        static const uint16_t reserved = 32;
+        uint32_t clusters = totalBlocks / blocksPerCluster;
+        uint32_t fatBlocks = (4 * (clusters + 2) + 511) / 512;
+        cache_t block;
+        memset(&block, 0, sizeof(block));
+        fat32_boot_t *bs = &block.fbs32;
+        bs->jump[0] = 0xEB;
+        bs->jump[1] = 0x58;
+        bs->jump[2] = 0x90;
+        memcpy(bs->oemId, "REPETIER", 8);
+        bs->bytesPerSector = 512;
+        bs->sectorsPerCluster = blocksPerCluster;
+        bs->reservedSectorCount = reserved;
+        bs->fatCount = 2;
+        bs->mediaType = 0xF8;
+        bs->totalSectors32 = totalBlocks;
+        bs->sectorsPerFat32 = fatBlocks;
+        bs->fat32RootCluster = 2;
+        bs->fat32FSInfo = 1;
+        bs->bootSignature = 0x29;
+        memcpy(bs->volumeLabel, "NO NAME    ", 11);
+        memcpy(bs->fileSystemType, "FAT32   ", 8);
+        bs->bootSectorSig0 = 0x55;
+        bs->bootSectorSig1 = 0xAA;
+        card.writeBlock(0, block.data);
+        memset(&block, 0, sizeof(block));
+        block.fat32[0] = 0x0FFFFFF8;
+        block.fat32[1] = 0x0FFFFFFF;
+        block.fat32[2] = 0x0FFFFFFF; // root directory
+        card.writeBlock(reserved, block.data);
+        card.writeBlock(reserved + fatBlocks, block.data);
+        if(!FatFileSystem::begin(&card))
+            return false;
+        card.cache = cacheClear()->data;
+        card.clearStats();
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,212 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Converts an ASCII G-code file into a compiled job for SD_COMPILED_JOBS, the same file
+   M28 writes on the printer. Copy the result to the SD card and print it with M23/M24,
+   the firmware detects the M37 job header and reads the packed binary commands.
+
+   Usage: gcode_compile input.gcode output.gco
+
+   The lines are parsed like GCode::parseAscii, comments and line numbers are dropped.
+   Packing and header come from CompiledJob.h, the code the firmware uses. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef SD_COMPILED_KEYFRAME
+#define SD_COMPILED_KEYFRAME 64
+#endif
+#define BEZIER_SUPPORT 1 // P with fractional part is sent as additional float
+
+#include "CompiledJob.h"
+
+/** Parameters of one command with the members and bits of GCode */
+struct Command {
+    uint16_t params, params2;
+    uint16_t M, G;
+    float X, Y, Z, E, F;
+    int32_t S, P;
+    float PF, I, J, R, D, C, H, A, B, K, L, O, Q;
+    uint8_t T;
+    char *text;
+    char textBuffer[100]; // not V2 commands always write 16 bytes
+
+    bool hasM() { return (params & 2) != 0; }
+    bool hasG() { return (params & 4) != 0; }
+    bool hasX() { return (params & 8) != 0; }
+    bool hasY() { return (params & 16) != 0; }
+    bool hasZ() { return (params & 32) != 0; }
+    bool hasE() { return (params & 64) != 0; }
+    bool hasF() { return (params & 256) != 0; }
+    bool hasT() { return (params & 512) != 0; }
+    bool hasS() { return (params & 1024) != 0; }
+    bool hasP() { return (params & 2048) != 0; }
+    bool isV2() { return (params & 4096) != 0; }
+    bool hasString() { return (params & 32768) != 0; }
+    bool hasI() { return (params2 & 1) != 0; }
+    bool hasJ() { return (params2 & 2) != 0; }
+    bool hasR() { return (params2 & 4) != 0; }
+    bool hasD() { return (params2 & 8) != 0; }
+    bool hasC() { return (params2 & 16) != 0; }
+    bool hasH() { return (params2 & 32) != 0; }
+    bool hasA() { return (params2 & 64) != 0; }
+    bool hasB() { return (params2 & 128) != 0; }
+    bool hasK() { return (params2 & 256) != 0; }
+    bool hasL() { return (params2 & 512) != 0; }
+    bool hasO() { return (params2 & 1024) != 0; }
+    bool hasQ() { return (params2 & 2048) != 0; }
+
+    Command() {
+        memset(this, 0, sizeof(*this));
+        text = textBuffer;
+    }
+
+    /** Second parameter word, V2 is needed to store it */
+    void setParam2(float &value, float v, uint16_t bit) {
+        value = v;
+        params2 |= bit;
+        params |= 4096;
+    }
+
+    /** Parses line like GCode::parseAscii. Returns false for lines without command. */
+    bool parse(char *line) {
+        char *pos = line, c;
+        char *endPtr;
+        params = params2 = 0;
+        memset(textBuffer, 0, sizeof(textBuffer));
+        while((c = *(pos++)) != 0) {
+            if(c == ';' || c == '(' || c == '%') break; // comment or program block
+            switch(c) {
+            case 'G': case 'g':
+                G = strtol(pos, NULL, 10) & 0xffff;
+                params |= 4;
+                if(G > 255) params |= 4096;
+                break;
+            case 'M': case 'm':
+                M = strtol(pos, &endPtr, 10) & 0xffff;
+                params |= 2;
+                if(M > 255) params |= 4096;
+                if(M == 20 || M == 23 || M == 28 || M == 29 || M == 30 || M == 32 || M == 36 || M == 38 || M == 117 || M == 531) {
+                    pos = endPtr;
+                    while(*pos == ' ') pos++;
+                    size_t n = 0;
+                    while(pos[n] && pos[n] != '\n' && pos[n] != '\r' && pos[n] != '*' && pos[n] != ';'
+                            && ((M == 117 || M == 20 || M == 531) || pos[n] != ' '))
+                        n++;
+                    if(n > 80) n = 80;
+                    memcpy(textBuffer, pos, n);
+                    params |= 32768;
+                    return true; // text ends the command
+                }
+                break;
+            case 'X': case 'x': X = strtod(pos, NULL); params |= 8; break;
+            case 'Y': case 'y': Y = strtod(pos, NULL); params |= 16; break;
+            case 'Z': case 'z': Z = strtod(pos, NULL); params |= 32; break;
+            case 'E': case 'e': E = strtod(pos, NULL); params |= 64; break;
+            case 'F': case 'f': F = strtod(pos, NULL); params |= 256; break;
+            case 'T': case 't': T = strtol(pos, NULL, 10) & 0xff; params |= 512; break;
+            case 'S': case 's': S = strtol(pos, NULL, 10); params |= 1024; break;
+            case 'P': case 'p':
+                P = strtol(pos, NULL, 10);
+                params |= 2048;
+                PF = strtod(pos, NULL);
+                if(PF != static_cast<float>(P)) { // fractional part needs its own float
+                    params2 |= 4096;
+                    params |= 4096;
+                }
+                break;
+            case 'I': case 'i': setParam2(I, strtod(pos, NULL), 1); break;
+            case 'J': case 'j': setParam2(J, strtod(pos, NULL), 2); break;
+            case 'R': case 'r': setParam2(R, strtod(pos, NULL), 4); break;
+            case 'D': case 'd': setParam2(D, strtod(pos, NULL), 8); break;
+            case 'C': case 'c': setParam2(C, strtod(pos, NULL), 16); break;
+            case 'H': case 'h': setParam2(H, strtod(pos, NULL), 32); break;
+            case 'A': case 'a': setParam2(A, strtod(pos, NULL), 64); break;
+            case 'B': case 'b': setParam2(B, strtod(pos, NULL), 128); break;
+            case 'K': case 'k': setParam2(K, strtod(pos, NULL), 256); break;
+            case 'L': case 'l': setParam2(L, strtod(pos, NULL), 512); break;
+            case 'O': case 'o': setParam2(O, strtod(pos, NULL), 1024); break;
+            case 'Q': case 'q': setParam2(Q, strtod(pos, NULL), 2048); break;
+            case '*': return params != 0; // checksum of the host protocol
+            default: break; // N and unknown letters
+            }
+        }
+        return params != 0;
+    }
+};
+
+int main(int argc, char **argv) {
+    if(argc != 3) {
+        fprintf(stderr, "usage: %s input.gcode output.gco\n", argv[0]);
+        return 2;
+    }
+    FILE *in = fopen(argv[1], "r");
+    if(in == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    FILE *out = fopen(argv[2], "wb");
+    if(out == NULL) {
+        perror(argv[2]);
+        fclose(in);
+        return 1;
+    }
+    static JobCompiler job;
+    static Command code;
+    uint8_t buf[100];
+    char line[256];
+    long lineNumber = 0, commands = 0, inputBytes = 0, outputBytes = 0, packed = 0;
+    // placeholder header like SDCard::startCompile, rewritten with the final values
+    job.start();
+    Command header;
+    job.header(header);
+    job.valid = 0;
+    outputBytes += fwrite(buf, 1, encodeBinaryCommand(&header, buf, &job), out);
+    job.valid = 0;
+    while(fgets(line, sizeof(line), in) != NULL) {
+        lineNumber++;
+        inputBytes += strlen(line);
+        if(!code.parse(line))
+            continue;
+        if(code.hasM() && (code.M == 28 || code.M == 29)) {
+            fprintf(stderr, "%s:%ld: skipped M%d, file writes can not be part of a job\n", argv[1], lineNumber, code.M);
+            continue;
+        }
+        uint8_t len = encodeBinaryCommand(&code, buf, &job);
+        if(len == 0)
+            continue;
+        if(buf[1] & (8192 >> 8))
+            packed++;
+        outputBytes += fwrite(buf, 1, len, out);
+        commands++;
+    }
+    fclose(in);
+    job.header(header);
+    job.valid = 0;
+    uint8_t len = encodeBinaryCommand(&header, buf, &job);
+    if(len != SD_JOB_HEADER_SIZE || fseek(out, 0, SEEK_SET) != 0 || fwrite(buf, 1, len, out) != len || fclose(out) != 0) {
+        fprintf(stderr, "%s: could not write the job header\n", argv[2]);
+        return 1;
+    }
+    printf("%ld lines, %ld commands, %ld of them packed\n", lineNumber, commands, packed);
+    printf("%ld bytes ASCII, %ld bytes compiled (%.0f%%)\n", inputBytes, outputBytes, inputBytes ? 100.0 * outputBytes / inputBytes : 0.0);
+    printf("header: height %.2f mm, filament %.1f mm, time %.0f s, %ld layers, layer height %.2f mm\n", job.height, job.filament,
+           job.time, static_cast<long>(job.layers), job.layerHeight);
+    return 0;
+}
@@ -0,0 +1,270 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Runs heat manager HTR_MODEL and HTR_PID of Extruder::manageTemperatures against a
+   simulated hotend. The hotend is a heater block with heat loss to ambient, a sensor
+   that lags behind the block and a filament heat load that grows with the block
+   temperature. The controllers get a first order model with dead time of it, PID
+   values come from that model with the tuning rules of the step autotune.
+   Reports overshoot and settling time for a heat up and the temperature sag and
+   recovery for flow steps, for an exact model and for a model with 20% gain error. */
+
+#include <math.h>
+#include <stdio.h>
+
+#define TEMP_MODEL_CONTROL 1
+#define TEMP_MODEL_AMBIENT 25
+#define TEMP_MODEL_HORIZON 4
+#define TEMP_MODEL_CORRECTION 0.5
+#define TEMP_MODEL_MAX_CORRECTION 40
+#ifndef TEMP_MODEL_STEADY_RATE
+#define TEMP_MODEL_STEADY_RATE 1
+#endif
+#define PID_CONTROL_RANGE 20
+
+#include "TemperatureModel.h"
+
+static unsigned long randomState = 4711;
+static float uniformRandom() {
+    randomState = randomState * 1103515245UL + 12345UL;
+    return (static_cast<float>((randomState >> 8) & 0xffff) + 0.5f) / 65536.0f;
+}
+static float gaussRandom() {
+    return sqrt(-2.0f * log(uniformRandom())) * cos(6.2831853f * uniformRandom());
+}
+
+static const float dt = 0.01f;      // simulation step in s
+static const float target = 210;
+static const float band = 1;        // settled within +-band degC
+
+struct Hotend {
+    float gain;         // degC per pwm unit
+    float timeConstant; // heater block in s
+    float transport;    // s until block changes reach the sensor
+    float sensorLag;    // time constant of the sensor in s
+    float filamentLoad; // pwm per mm/s filament speed at target
+    float noise;        // 1 sigma sensor noise in degC
+    float block, sensor;
+    float delayed[1024];
+    int delayPos;
+
+    void reset(float temp) {
+        block = sensor = temp;
+        for(int i = 0; i < 1024; i++)
+            delayed[i] = temp;
+        delayPos = 0;
+    }
+    void step(float pwm, float speed) {
+        float load = filamentLoad * speed * (block - TEMP_MODEL_AMBIENT) / (target - TEMP_MODEL_AMBIENT);
+        block += dt * (gain * (pwm - load) - (block - TEMP_MODEL_AMBIENT)) / timeConstant;
+        int delaySteps = static_cast<int>(transport / dt);
+        delayed[delayPos] = block;
+        delayPos = (delayPos + 1) & 1023;
+        sensor += dt * (delayed[(delayPos - delaySteps + 1024) & 1023] - sensor) / sensorLag;
+    }
+    /** Sensor noise with 1 sigma noise degC and ADC like resolution of 1/8 degC */
+    float read() const {
+        return floor((sensor + noise * gaussRandom()) * 8.0f + 0.5f) * 0.125f;
+    }
+};
+
+static const Hotend defaultHotend = {1.6f, 120, 1, 2, 6.4f, 0.15f, 0, 0, {0}, 0};
+
+/** The state manageTemperatures keeps per heater */
+struct Controller {
+    bool model;
+    TemperatureModel m;
+    float Kp, Ki, Kd;
+    float current, temperatureC, lastTemperatureC;
+    float iState, iMin, iMax;
+    int pidMax;
+
+    void reset(float temp) {
+        current = temperatureC = lastTemperatureC = temp;
+        iState = 0;
+    }
+    /** One pass of manageTemperatures for this heater */
+    int output(float plannedSpeed) {
+        float error = target - current;
+        int out = 0;
+        if(error > PID_CONTROL_RANGE) {
+            out = pidMax;
+            iState = model ? 0 : iMin;
+        } else if(error < -PID_CONTROL_RANGE)
+            out = 0;
+        else if(model) { // computeModelOutput
+            out = m.control(current, temperatureC - lastTemperatureC, target, plannedSpeed, pidMax, iState);
+        } else {
+            float pidTerm = Kp * error;
+            iState = fmin(fmax(iState + error, iMin), iMax);
+            pidTerm += Ki * iState * 0.1;
+            pidTerm += Kd * (lastTemperatureC - temperatureC);
+            out = static_cast<int>(fmin(fmax(pidTerm, 0.0f), pidMax));
+        }
+        return out;
+    }
+};
+
+/** PID values like autotuneStep computes them from the model with rule 1 (some overshoot). */
+static void pidFromModel(const TemperatureModel &m, float &Kp, float &Ki, float &Kd) {
+    float wLow = 0, wHigh = 3.14159f / m.dead;
+    for(int i = 0; i < 30; i++) {
+        float w = 0.5f * (wLow + wHigh);
+        if(atan(w * m.timeConstant) + w * m.dead > 3.14159f)
+            wHigh = w;
+        else
+            wLow = w;
+    }
+    float w = 0.5f * (wLow + wHigh);
+    float Ku = sqrt(1.0f + w * m.timeConstant * w * m.timeConstant) / m.gain;
+    float Tu = 2.0f * 3.14159f / w;
+    Kp = 0.33f * Ku;
+    Ki = Kp * 2.0f / Tu;
+    Kd = Kp * Tu / 3.0f;
+}
+
+static Controller makeController(bool model, const TemperatureModel &m) {
+    Controller c;
+    c.model = model;
+    c.m = m;
+    c.pidMax = 255;
+    pidFromModel(m, c.Kp, c.Ki, c.Kd);
+    if(model) {
+        c.iMin = -TEMP_MODEL_MAX_CORRECTION;
+        c.iMax = TEMP_MODEL_MAX_CORRECTION;
+    } else { // updateTempControlVars with EXT0_PID_INTEGRAL_DRIVE_MIN/MAX
+        c.iMin = 60 * 10.0f / c.Ki;
+        c.iMax = 140 * 10.0f / c.Ki;
+    }
+    return c;
+}
+
+/** Filament speed in mm/s at time t, 8 mm/s (about 19 mm^3/s with 1.75 mm filament)
+from 600 to 720 s */
+static float flowStep(float t) {
+    return t >= 600 && t < 720 ? 8 : 0;
+}
+
+struct Result {
+    float overshoot; // max above target, after first reaching it
+    float sag;       // max below target, after first reaching it
+    float settled;   // s after the phase start until within +-band for good
+};
+
+/** Simulates heat up and two flow changes, the phases start at 0, 600 and 720 s. The queue
+holds queueTime seconds of moves, plannedExtrusionSpeed averages over that or the model
+lookahead. */
+static void simulate(const Hotend &plant, Controller c, float queueTime, Result *phases) {
+    static const float phaseStart[] = {0, 600, 720, 1200};
+    Hotend h = plant;
+    h.reset(TEMP_MODEL_AMBIENT);
+    c.reset(TEMP_MODEL_AMBIENT);
+    bool reached = false;
+    float lastOutside = 0;
+    int out = 0, pass = 0, phase = 0;
+    float lookahead = fmin(queueTime, c.m.dead + TEMP_MODEL_HORIZON);
+    phases[0].overshoot = phases[0].sag = 0;
+    for(long i = 0; i < static_cast<long>(phaseStart[3] / dt); i++) {
+        float t = i * dt;
+        if(t >= phaseStart[phase + 1]) {
+            phases[phase].settled = fmax(lastOutside - phaseStart[phase], 0.0f);
+            phase++;
+            phases[phase].overshoot = phases[phase].sag = 0;
+        }
+        if(i % 10 == 0) { // manageTemperatures runs every 100 ms
+            c.current = h.read();
+            float planned = 0;
+            for(int k = 0; k < 10; k++)
+                planned += flowStep(t + lookahead * k / 10.0f) / 10.0f;
+            out = c.output(planned);
+            if(++pass == 10) {
+                pass = 0;
+                c.lastTemperatureC = c.temperatureC;
+                c.temperatureC = c.current;
+            }
+        }
+        h.step(out, flowStep(t));
+        float error = h.sensor - target;
+        if(error >= 0)
+            reached = true;
+        if(reached) {
+            phases[phase].overshoot = fmax(phases[phase].overshoot, error);
+            phases[phase].sag = fmax(phases[phase].sag, -error);
+        }
+        if(!reached || fabs(error) > band)
+            lastOutside = t;
+    }
+    phases[phase].settled = fmax(lastOutside - phaseStart[phase], 0.0f);
+}
+
+int main() {
+    int failures = 0;
+    const Hotend &h = defaultHotend;
+    // first order model with dead time as the step autotune sees the hotend
+    TemperatureModel exact = {h.gain, h.timeConstant + h.sensorLag, h.transport + h.sensorLag, h.filamentLoad};
+    TemperatureModel off = exact;
+    off.gain *= 0.8f;
+    off.feedForward *= 0.8f;
+    printf("hotend: gain %.2f, time constant %.0f s, transport %.1f s, sensor lag %.1f s, filament %.1f pwm/(mm/s)\n",
+           h.gain, h.timeConstant, h.transport, h.sensorLag, h.filamentLoad);
+    Controller pid = makeController(false, exact);
+    printf("PID from model: Kp %.2f Ki %.3f Kd %.1f\n", pid.Kp, pid.Ki, pid.Kd);
+    printf("%-22s %10s %10s %10s %10s %10s %10s\n", "", "heat up", "", "flow step", "", "flow stop", "");
+    printf("%-22s %10s %10s %10s %10s %10s %10s\n", "controller", "overshoot", "settled", "sag", "settled", "overshoot", "settled");
+    static const struct {
+        const char *name;
+        bool model;
+        const TemperatureModel *m;
+    } cases[] = {
+        {"PID", false, &exact},
+        {"model", true, &exact},
+        {"model, gain -20%", true, &off},
+    };
+    Result res[3][3];
+    for(int i = 0; i < 3; i++) {
+        Controller c = makeController(cases[i].model, *cases[i].m);
+        simulate(h, c, 2, res[i]);
+        printf("%-22s %9.2fC %9.0fs %9.2fC %9.0fs %9.2fC %9.0fs\n", cases[i].name, res[i][0].overshoot, res[i][0].settled,
+               res[i][1].sag, res[i][1].settled, res[i][2].overshoot, res[i][2].settled);
+    }
+    // Heat up like PID without its overshoot, flow changes stay within the band
+    if(res[1][0].overshoot > fmax(res[0][0].overshoot, 0.5f * band) || res[1][0].settled > 1.2f * res[0][0].settled) {
+        printf("FAIL model heat up is worse than PID\n");
+        failures++;
+    }
+    if(res[1][1].sag > band || res[1][2].overshoot > band) {
+        printf("FAIL feed-forward does not keep flow changes within %g degC\n", band);
+        failures++;
+    }
+    // Flow changes with a wrong model still beat PID and the correction settles every phase
+    if(res[2][1].sag >= res[0][1].sag || res[2][2].overshoot >= res[0][2].overshoot) {
+        printf("FAIL model with gain error does not improve flow changes\n");
+        failures++;
+    }
+    for(int p = 0; p < 3; p++)
+        if(res[2][p].settled > 150) {
+            printf("FAIL model with gain error does not settle\n");
+            failures++;
+        }
+    if(failures) {
+        printf("heater_sim: %d failures\n", failures);
+        return 1;
+    }
+    printf("heater_sim: ok\n");
+    return 0;
+}
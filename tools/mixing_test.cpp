@@ -0,0 +1,172 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Runs the step distribution of the mixing extruder like Extruder::step does it and
+   counts the steps of every motor. Checks the filament ratio of long runs with fixed
+   weights, of gradients that change the weights with every move like MIXING_GRADIENT
+   does and of retracts. The errors have to stay within the 16 bit range of the AVR. */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "MixingExtruder.h"
+
+#define NUM_EXTRUDER 3
+
+struct Motor {
+    float stepsPerMM;
+    int mixingW, mixingWB, mixingE;
+};
+
+static Motor extruder[NUM_EXTRUDER];
+static int mixingWA[NUM_EXTRUDER], mixingS;
+static long steps[NUM_EXTRUDER];
+static double ideal[NUM_EXTRUDER];
+static int maxError;
+
+/** setMixingWeight for all weights. With gradient the stepper activates the weights with
+the next move and keeps the errors, else the weights apply at once and the errors restart. */
+static void setWeights(const int *w, bool gradient) {
+    for(int i = 0; i < NUM_EXTRUDER; i++)
+        extruder[i].mixingW = w[i];
+    int total = balanceMixingWeights(extruder, NUM_EXTRUDER);
+    for(int i = 0; i < NUM_EXTRUDER; i++) {
+        mixingWA[i] = extruder[i].mixingWB;
+        if(!gradient)
+            extruder[i].mixingE = extruder[i].mixingWB;
+    }
+    mixingS = total;
+}
+
+static void reset() {
+    for(int i = 0; i < NUM_EXTRUDER; i++) {
+        extruder[i].mixingE = 0;
+        steps[i] = 0;
+        ideal[i] = 0;
+    }
+    maxError = 0;
+}
+
+/** Virtual steps of one move, returns the largest deviation in steps of a motor from the
+exact share of all virtual steps so far. */
+static double move(long virtualSteps, bool forward) {
+    double deviation = 0;
+    for(long s = 0; s < virtualSteps; s++) {
+        uint8_t best = mixingStepExtruder(extruder, mixingWA, mixingS, NUM_EXTRUDER, forward);
+        if(best != 255)
+            steps[best] += forward ? 1 : -1;
+        for(int i = 0; i < NUM_EXTRUDER; i++) {
+            if(best != 255)
+                ideal[i] += (forward ? 1.0 : -1.0) * mixingWA[i] / mixingS;
+            deviation = fmax(deviation, fabs(steps[i] - ideal[i]));
+            if(abs(extruder[i].mixingE) > maxError)
+                maxError = abs(extruder[i].mixingE);
+        }
+    }
+    return deviation;
+}
+
+/** Gradient from weights a to b over moves of moveSteps virtual steps each. */
+static double gradient(const int *a, const int *b, int moves, long moveSteps, bool keepErrors) {
+    double deviation = 0;
+    for(int m = 0; m <= moves; m++) {
+        int w[NUM_EXTRUDER];
+        for(int i = 0; i < NUM_EXTRUDER; i++)
+            w[i] = (a[i] * (moves - m) + b[i] * m) / moves;
+        setWeights(w, keepErrors);
+        deviation = fmax(deviation, move(moveSteps + (m * 37) % 11, true));
+    }
+    return deviation;
+}
+
+int main() {
+    int failures = 0;
+    // direct drive, geared and bowden motor
+    static const float resolution[NUM_EXTRUDER] = {93, 420, 140};
+    for(int i = 0; i < NUM_EXTRUDER; i++)
+        extruder[i].stepsPerMM = resolution[i];
+    printf("steps per mm %g %g %g\n", resolution[0], resolution[1], resolution[2]);
+
+    // fixed weights over 1 million virtual steps
+    static const int fixed[][NUM_EXTRUDER] = {{1, 0, 0}, {1, 1, 1}, {1, 2, 7}, {33, 33, 34}, {97, 2, 1}, {0, 1, 4}};
+    for(unsigned k = 0; k < sizeof(fixed) / sizeof(fixed[0]); k++) {
+        reset();
+        setWeights(fixed[k], false);
+        double deviation = move(1000000, true);
+        // filament of each motor relative to the wanted ratio
+        double mm[NUM_EXTRUDER], total = 0, ratioError = 0;
+        int sumW = fixed[k][0] + fixed[k][1] + fixed[k][2];
+        for(int i = 0; i < NUM_EXTRUDER; i++)
+            total += mm[i] = steps[i] / resolution[i];
+        for(int i = 0; i < NUM_EXTRUDER; i++)
+            ratioError = fmax(ratioError, fabs(mm[i] / total - static_cast<double>(fixed[k][i]) / sumW));
+        printf("weights %2d:%2d:%2d  steps %6ld %6ld %6ld  max deviation %.2f steps  ratio error %.5f%%\n", fixed[k][0], fixed[k][1],
+               fixed[k][2], steps[0], steps[1], steps[2], deviation, 100 * ratioError);
+        // balancing truncates every weight to 1/MIXING_WEIGHT_SUM and gives the rest to the largest one
+        if(mixingS != MIXING_WEIGHT_SUM || deviation >= 1 || ratioError > (NUM_EXTRUDER - 1.0) / MIXING_WEIGHT_SUM || maxError >= 20000) {
+            printf("FAIL fixed weights %d:%d:%d\n", fixed[k][0], fixed[k][1], fixed[k][2]);
+            failures++;
+        }
+    }
+
+    // gradients with a new ratio for every move, errors kept like MIXING_GRADIENT and reset like before
+    static const int from[NUM_EXTRUDER] = {100, 0, 0}, to[NUM_EXTRUDER] = {0, 30, 70};
+    for(int keep = 1; keep >= 0; keep--) {
+        reset();
+        double deviation = gradient(from, to, 2000, 40, keep != 0);
+        deviation = fmax(deviation, gradient(to, from, 2000, 40, keep != 0));
+        double worst = 0;
+        for(int i = 0; i < NUM_EXTRUDER; i++)
+            worst = fmax(worst, fabs(steps[i] - ideal[i]));
+        printf("gradient %s: max deviation %.2f steps, %.2f steps after 4000 moves\n", keep ? "keeping errors" : "resetting errors", deviation, worst);
+        if(keep && (deviation >= NUM_EXTRUDER || maxError >= 20000)) {
+            printf("FAIL gradient drifts from the wanted ratio\n");
+            failures++;
+        }
+    }
+
+    // retracts: every move goes back and forth, the motors have to end where they started
+    reset();
+    setWeights(fixed[2], true);
+    for(int r = 0; r < 1000; r++) {
+        move(200 + r % 7, true);
+        move(200 + r % 7, false);
+    }
+    printf("retracts: steps %ld %ld %ld after 1000 retracts\n", steps[0], steps[1], steps[2]);
+    if(labs(steps[0]) > 1 || labs(steps[1]) > 1 || labs(steps[2]) > 1) {
+        printf("FAIL retracts move the filament\n");
+        failures++;
+    }
+
+    // all weights 0 must not divide by zero and must not step
+    static const int none[NUM_EXTRUDER] = {0, 0, 0};
+    reset();
+    setWeights(none, true);
+    if(mixingS != 0 || mixingStepExtruder(extruder, mixingWA, mixingS, NUM_EXTRUDER, true) != 255) {
+        printf("FAIL weights 0 step a motor\n");
+        failures++;
+    }
+
+    if(failures) {
+        printf("mixing_test: %d failures\n", failures);
+        return 1;
+    }
+    printf("mixing_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,236 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Simulates the probe path of Printer::runZProbe for a BED_LEVELING_METHOD 1 grid,
+   once with the plain repeated slow touches and once with Z_PROBE_FAST_APPROACH.
+   Moves use trapezoidal profiles, the probe triggers at the bed height plus
+   gaussian noise and results are quantized to z steps. Reports the time per grid
+   and the error of the measured heights. The defaults are the values of the
+   shipped configuration. */
+
+#include <math.h>
+#include <stdio.h>
+
+struct Machine {
+    float zStepsPerMM;     // ZAXIS_STEPS_PER_MM
+    float maxFeedrateZ;    // MAX_FEEDRATE_Z, caps all z speeds below
+    float zAcceleration;   // MAX_TRAVEL_ACCELERATION_UNITS_PER_SQ_SECOND_Z
+    float homingFeedrateZ; // HOMING_FEEDRATE_Z, used for moves up
+    float xyAcceleration;  // MAX_TRAVEL_ACCELERATION_UNITS_PER_SQ_SECOND_X
+    float xySpeed;         // Z_PROBE_XY_SPEED
+    float probeSpeed;      // Z_PROBE_SPEED
+    float fastSpeed;       // Z_PROBE_FAST_SPEED
+    float learnMargin;     // Z_PROBE_LEARN_MARGIN
+    float repeatability;   // Z_PROBE_REPEATABILITY
+    float switchingDistance; // Z_PROBE_SWITCHING_DISTANCE
+    float bedDistance;     // Z_PROBE_BED_DISTANCE, start height above the bed
+    float probeDelay;      // Z_PROBE_DELAY in s before each touch
+    int repetitions;       // Z_PROBE_REPETITIONS
+    float triggerNoise;    // 1 sigma trigger repeatability of the probe in mm
+    float p[3][2];         // Z_PROBE_X1 ... Z_PROBE_Y3
+};
+
+static const Machine defaultMachine = {
+    805, 5, 100, 20, 2000, 150, 2, 10, 1.0f, 0.01f, 2.5f, 6.0f, 0, 5, 0.004f,
+    {{100, 20}, {160, 170}, {20, 170}}
+};
+
+static unsigned long randomState = 4711;
+static float uniformRandom() {
+    randomState = randomState * 1103515245UL + 12345UL;
+    return (static_cast<float>((randomState >> 8) & 0xffff) + 0.5f) / 65536.0f;
+}
+static float gaussRandom() {
+    return sqrt(-2.0f * log(uniformRandom())) * cos(6.2831853f * uniformRandom());
+}
+
+/* Time to cover distance stopAt of a trapezoidal move over plannedDistance that
+   starts and ends at rest. */
+static float moveTime(float plannedDistance, float speed, float acceleration, float stopAt) {
+    float accelDistance = 0.5f * speed * speed / acceleration;
+    if(2.0f * accelDistance > plannedDistance) { // triangle profile
+        accelDistance = 0.5f * plannedDistance;
+        speed = sqrt(acceleration * plannedDistance);
+    }
+    if(stopAt <= accelDistance)
+        return sqrt(2.0f * stopAt / acceleration);
+    float t = speed / acceleration;
+    float cruise = plannedDistance - 2.0f * accelDistance;
+    if(stopAt <= accelDistance + cruise)
+        return t + (stopAt - accelDistance) / speed;
+    float rest = plannedDistance - stopAt; // time left in deceleration is sqrt(2 rest / a)
+    return 2.0f * t + cruise / speed - sqrt(2.0f * rest / acceleration);
+}
+
+struct Probe {
+    const Machine &m;
+    bool fast;
+    float bedHeight;     // true bed height at the current point
+    float z;             // nozzle height
+    float time;
+    int touches;         // slow touches
+    int fastMoves;
+    bool learned;
+    float learnedZ;
+
+    Probe(const Machine &machine, bool fastApproach) : m(machine), fast(fastApproach), bedHeight(0), z(0), time(0), touches(0), fastMoves(0), learned(false), learnedZ(0) {}
+
+    float quantize(float v) const {
+        return floor(v * m.zStepsPerMM + 0.5f) / m.zStepsPerMM;
+    }
+    /* Like zProbeMove, moves down by distance and stops when the probe triggers. */
+    bool down(float distance, float speed) {
+        speed = fmin(speed, m.maxFeedrateZ);
+        float trigger = quantize(bedHeight + m.triggerNoise * gaussRandom());
+        float way = z - trigger;
+        time += m.probeDelay;
+        if(way <= distance) {
+            time += moveTime(distance, speed, m.zAcceleration, fmax(way, 0.0f));
+            z = trigger;
+            return true;
+        }
+        time += moveTime(distance, speed, m.zAcceleration, distance);
+        z -= distance;
+        return false;
+    }
+    void up(float distance) {
+        time += moveTime(fabs(distance), fmin(m.homingFeedrateZ, m.maxFeedrateZ), m.zAcceleration, fabs(distance));
+        z += distance;
+    }
+    /* Follows Printer::runZProbe and returns the averaged distance below start. */
+    float run() {
+        const float probeDepth = 100;
+        float start = z, sum = 0, lastMeasurement = 0;
+        int repeat = m.repetitions;
+        for(int r = 0; r < repeat; r++) {
+            if(fast && r == 0) {
+                bool hit;
+                fastMoves++;
+                if(learned) {
+                    float approach = z - learnedZ - m.learnMargin;
+                    hit = approach > 0 && down(approach, m.fastSpeed);
+                } else
+                    hit = down(probeDepth, m.fastSpeed);
+                if(hit)
+                    up(m.switchingDistance);
+            }
+            down(probeDepth, m.probeSpeed);
+            touches++;
+            float measurement = start - z;
+            sum += measurement;
+            if(fast) {
+                learnedZ = z;
+                learned = true;
+                if(r > 0 && fabs(measurement - lastMeasurement) <= m.repeatability)
+                    repeat = r + 1;
+                lastMeasurement = measurement;
+            }
+            if(r + 1 < repeat)
+                up(m.switchingDistance);
+        }
+        up(start - z);
+        return sum / repeat;
+    }
+};
+
+struct GridResult {
+    float time, xyTime, maxError, rmsError;
+    int touches, fastMoves;
+};
+
+/* Bed with tilt and a bowl shaped warp, heights relative to the first point */
+static float bedAt(float x, float y) {
+    return 0.002f * (x - 100) - 0.0015f * (y - 20) + 0.15f * (1.0f - ((x - 90) * (x - 90) + (y - 95) * (y - 95)) / 12000.0f);
+}
+
+static GridResult probeGrid(const Machine &m, int size, bool fast) {
+    Probe probe(m, fast);
+    GridResult res = {0, 0, 0, 0, 0, 0};
+    float delta = 1.0f / (size - 1);
+    float lastX = m.p[0][0], lastY = m.p[0][1];
+    double squares = 0;
+    probe.z = m.bedDistance + bedAt(lastX, lastY);
+    for(int ix = 0; ix < size; ix++) {
+        for(int iy = 0; iy < size; iy++) {
+            float px = m.p[0][0] + delta * (ix * (m.p[1][0] - m.p[0][0]) + iy * (m.p[2][0] - m.p[0][0]));
+            float py = m.p[0][1] + delta * (ix * (m.p[1][1] - m.p[0][1]) + iy * (m.p[2][1] - m.p[0][1]));
+            float dist = sqrt((px - lastX) * (px - lastX) + (py - lastY) * (py - lastY));
+            float xy = moveTime(dist, m.xySpeed, m.xyAcceleration, dist);
+            res.xyTime += xy;
+            probe.time += xy;
+            lastX = px;
+            lastY = py;
+            probe.bedHeight = bedAt(px, py);
+            float trueDistance = probe.z - probe.bedHeight;
+            float error = fabs(probe.run() - trueDistance);
+            if(error > res.maxError) res.maxError = error;
+            squares += error * error;
+        }
+    }
+    res.time = probe.time;
+    res.rmsError = sqrt(squares / (size * size));
+    res.touches = probe.touches;
+    res.fastMoves = probe.fastMoves;
+    return res;
+}
+
+int main() {
+    const Machine &m = defaultMachine;
+    static const int sizes[] = {3, 4, 5, 7, 10};
+    static const float noises[] = {0.002f, 0.004f, 0.008f};
+    const int runs = 20;
+    int failures = 0;
+    printf("z %.0f steps/mm, max z %.0f mm/s, probe %.0f mm/s, fast %.0f mm/s, %d repetitions, start %.1f mm above bed\n",
+           m.zStepsPerMM, m.maxFeedrateZ, m.probeSpeed, m.fastSpeed, m.repetitions, m.bedDistance);
+    printf("%5s %6s %9s %9s %7s %9s %9s %7s %8s %8s\n", "noise", "grid", "slow [s]", "fast [s]", "saved", "touches", "touches", "xy [s]", "rms slow", "rms fast");
+    for(unsigned ni = 0; ni < sizeof(noises) / sizeof(noises[0]); ni++) {
+        Machine mn = m;
+        mn.triggerNoise = noises[ni];
+        for(unsigned si = 0; si < sizeof(sizes) / sizeof(sizes[0]); si++) {
+            GridResult slow = {0, 0, 0, 0, 0, 0}, fast = {0, 0, 0, 0, 0, 0};
+            for(int run = 0; run < runs; run++) {
+                GridResult s = probeGrid(mn, sizes[si], false);
+                GridResult f = probeGrid(mn, sizes[si], true);
+                slow.time += s.time / runs;
+                fast.time += f.time / runs;
+                slow.xyTime += s.xyTime / runs;
+                slow.touches += s.touches;
+                fast.touches += f.touches;
+                slow.rmsError += s.rmsError / runs;
+                fast.rmsError += f.rmsError / runs;
+                slow.maxError = fmax(slow.maxError, s.maxError);
+                fast.maxError = fmax(fast.maxError, f.maxError);
+            }
+            printf("%5.3f %3dx%-2d %9.1f %9.1f %6.0f%% %9.1f %9.1f %7.1f %8.4f %8.4f\n", noises[ni], sizes[si], sizes[si],
+                   slow.time, fast.time, 100.0f * (1.0f - fast.time / slow.time),
+                   static_cast<float>(slow.touches) / runs, static_cast<float>(fast.touches) / runs,
+                   slow.xyTime, slow.rmsError, fast.rmsError);
+            // Fast probing must save time and may only lose the averaging over fewer touches
+            if(fast.time >= slow.time || fast.maxError > 5.0f * noises[ni] + 1.0f / m.zStepsPerMM) {
+                printf("FAIL noise %g grid %d: time %g/%g, max error %g\n", noises[ni], sizes[si], slow.time, fast.time, fast.maxError);
+                failures++;
+            }
+        }
+    }
+    if(failures) {
+        printf("probe_sim: %d failures\n", failures);
+        return 1;
+    }
+    printf("probe_sim: ok\n");
+    return 0;
+}
@@ -0,0 +1,154 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Counts the block reads from the card of a SD print while the directory gets listed
+   like M20 or the SD menu does it, with and without the SD_BLOCK_CACHE LRU. The LRU
+   only sits between the SdFat cache and the card, so the SdFat cache asks for the same
+   blocks in both cases and the reads without LRU are the reads with LRU plus its hits.
+   Build with -DSD_BLOCK_CACHE=0 to count the reads without LRU directly. */
+
+#include <stdio.h>
+
+#ifndef SD_BLOCK_CACHE
+#define SD_BLOCK_CACHE 4
+#endif
+#include "fat_image.h"
+
+static const uint32_t fileSize = 1UL << 20;
+static const uint32_t listInterval = 8192; // print bytes between listings, about 4 s of printing
+
+struct Result {
+    uint32_t reads, hits, misses, listings;
+};
+
+/** Lists the directory like FatFile::lsRecursive, every file gets opened and named.
+Returns the number of directory blocks scanned. */
+static uint32_t listDirectory(FatImage &fs) {
+    FatFile file;
+    char name[64];
+    fs.vwd()->rewind();
+    while(file.openNext(fs.vwd(), O_READ)) {
+        file.getName(name, sizeof(name));
+        file.close();
+    }
+    return (fs.vwd()->curPosition() + 511) / 512;
+}
+
+/** Prints the file with 64 byte reads, listing the directory every listInterval bytes
+if list is set. */
+static Result printFile(FatImage &fs, bool list) {
+    FatFile file;
+    file.open(fs.vwd(), "PRINT.GCO", O_READ);
+    fs.cacheClear();
+#if SD_BLOCK_CACHE
+    fs.vol()->lruClearStats();
+#endif
+    fs.card.clearStats();
+    Result r = {0, 0, 0, 0};
+    uint8_t buf[64];
+    uint32_t pos = 0, nextList = 0;
+    int n;
+    while((n = file.read(buf, sizeof(buf))) > 0) {
+        pos += n;
+        if(list && pos >= nextList) {
+            nextList += listInterval;
+            listDirectory(fs);
+            r.listings++;
+        }
+    }
+    file.close();
+    r.reads = fs.card.reads;
+#if SD_BLOCK_CACHE
+    r.hits = fs.vol()->lruHits();
+    r.misses = fs.vol()->lruMisses();
+#endif
+    return r;
+}
+
+/** Creates files with long names in the root directory, the print file first. */
+static bool writeFiles(FatImage &fs, int files) {
+    FatFile f;
+    char line[64];
+    if(!f.open(fs.vwd(), "PRINT.GCO", O_CREAT | O_WRITE | O_TRUNC))
+        return false;
+    for(uint32_t written = 0; written < fileSize; written += sizeof(line)) {
+        memset(line, 'G', sizeof(line));
+        f.write(line, sizeof(line));
+    }
+    f.close();
+    for(int i = 0; i < files; i++) {
+        snprintf(line, sizeof(line), "calibration part %03d with long name.gcode", i);
+        if(!f.open(fs.vwd(), line, O_CREAT | O_WRITE | O_TRUNC))
+            return false;
+        f.write("G28\n", 4);
+        f.close();
+    }
+    return true;
+}
+
+int main() {
+    int failures = 0;
+#if SD_BLOCK_CACHE
+    uint32_t dataBlocks = fileSize / 512;
+#endif
+    static const int fileCounts[] = {4, 12, 40};
+    printf("SD_BLOCK_CACHE %d, %u KB print, directory listed every %u bytes\n", SD_BLOCK_CACHE, static_cast<unsigned>(fileSize >> 10),
+           static_cast<unsigned>(listInterval));
+    printf("card reads without / with LRU\n");
+    printf("%-6s %8s %14s %14s %8s %8s\n", "files", "dir", "print", "print and", "LRU", "saved");
+    printf("%-6s %8s %14s %14s %8s %8s\n", "", "blocks", "alone", "listings", "hits", "");
+    for(unsigned k = 0; k < sizeof(fileCounts) / sizeof(fileCounts[0]); k++) {
+        FatImage &fs = *new FatImage; // empty card for every directory size
+        if(!fs.begin() || !writeFiles(fs, fileCounts[k])) {
+            printf("FAIL could not write the FAT image\n");
+            return 1;
+        }
+        uint32_t dirBlocks = listDirectory(fs);
+        Result alone = printFile(fs, false);
+        Result r = printFile(fs, true);
+        uint32_t without = r.reads + r.hits;
+        char printAlone[24], printListing[24];
+        snprintf(printAlone, sizeof(printAlone), "%u / %u", static_cast<unsigned>(alone.reads + alone.hits), static_cast<unsigned>(alone.reads));
+        snprintf(printListing, sizeof(printListing), "%u / %u", static_cast<unsigned>(without), static_cast<unsigned>(r.reads));
+        printf("%-6d %8u %14s %14s %8u %7.1f%%\n", fileCounts[k] + 1, static_cast<unsigned>(dirBlocks), printAlone, printListing,
+               static_cast<unsigned>(r.hits), without ? 100.0 * r.hits / without : 0.0);
+        if(r.reads > without || alone.reads > r.reads) {
+            printf("FAIL LRU adds card reads\n");
+            failures++;
+        }
+#if SD_BLOCK_CACHE
+        // file data bypasses the LRU, so the FAT block survives the data blocks of the print
+        if(alone.reads > dataBlocks + 1) {
+            printf("FAIL print rereads the FAT block\n");
+            failures++;
+        }
+        // a directory that fits into the LRU next to the FAT block is read from the card once
+        if(dirBlocks + 1 <= SD_BLOCK_CACHE && r.reads > alone.reads + dirBlocks) {
+            printf("FAIL listings of %u blocks reread the card\n", static_cast<unsigned>(dirBlocks));
+            failures++;
+        }
+#endif
+        delete &fs;
+    }
+    if(failures) {
+        printf("sd_cache_bench: %d failures\n", failures);
+        return 1;
+    }
+    printf("sd_cache_bench: ok\n");
+    return 0;
+}
@@ -0,0 +1,223 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Reads a G-code file from a FAT32 image the way an SD print does, byte by byte with
+   file.read() and with the SD_READ_BUFFERS buffers of SDCard::readByte. Counts the
+   SdFat read calls, the block reads from the card and the bytes copied out of the
+   SdFat cache. Each mode runs alone and with the TOOLCHANGE_PREHEAT scan, which reads
+   ahead with a second file handle through the same cache. */
+
+#include <stdio.h>
+
+#include "fat_image.h"
+
+static const uint32_t fileSize = 2UL << 20;
+static const uint32_t scanInterval = 1024; // print bytes between tool change scans, 2 KB/s with scans every 500 ms
+static const uint32_t scanBytes = 16384;   // TOOLCHANGE_SCAN_BYTES
+
+/** File reads of the print without SD_READ_BUFFERS */
+struct ByteReader {
+    FatFile *file;
+    uint32_t calls;
+
+    ByteReader(FatFile *f) : file(f), calls(0) {}
+    int readByte() {
+        calls++;
+        return file->read();
+    }
+    void prefetch() {}
+};
+
+/** SDCard::readByte, fillReadBuffer, nextReadBuffer and prefetch with SD_READ_BUFFERS */
+template<uint16_t SD_READ_BUFFER_SIZE> struct BufferedReader {
+    FatFile *file;
+    uint32_t calls, filesize;
+    uint8_t readBuffer[2][SD_READ_BUFFER_SIZE];
+    uint16_t readBufferFill[2], readBufferPos;
+    uint8_t readBufferActive;
+
+    BufferedReader(FatFile *f) : file(f), calls(0), filesize(f->fileSize()), readBufferPos(0), readBufferActive(0) {
+        readBufferFill[0] = readBufferFill[1] = 0;
+    }
+    bool fillReadBuffer(uint8_t idx) {
+        uint32_t pos = file->curPosition();
+        if(pos >= filesize) return false;
+        uint16_t size = SD_READ_BUFFER_SIZE - (pos & (SD_READ_BUFFER_SIZE - 1));
+        calls++;
+        int n = file->read(readBuffer[idx], size);
+        if(n <= 0) return false;
+        readBufferFill[idx] = n;
+        return true;
+    }
+    bool nextReadBuffer() {
+        if(readBufferFill[readBufferActive] != 0) {
+            readBufferFill[readBufferActive] = 0;
+            readBufferActive ^= 1;
+        }
+        readBufferPos = 0;
+        return readBufferFill[readBufferActive] != 0 || fillReadBuffer(readBufferActive);
+    }
+    inline int readByte() {
+        if(readBufferPos >= readBufferFill[readBufferActive] && !nextReadBuffer())
+            return -1;
+        return readBuffer[readBufferActive][readBufferPos++];
+    }
+    void prefetch() {
+        uint8_t idx = readBufferActive ^ 1;
+        if(readBufferFill[idx] == 0 && readBufferFill[readBufferActive] != 0)
+            fillReadBuffer(idx);
+    }
+};
+
+struct Result {
+    uint32_t calls, reads, cacheReads, scanReads, checksum, bytes;
+};
+
+/** Reads the whole print like the SD print loop, prefetching after every line. With
+scan the second handle reads the block at the scan position like SDCard::scanToolchange,
+up to scanBytes ahead of the print. */
+template<class Reader> static Result printFile(FatImage &fs, bool scan) {
+    FatFile file, scanFile;
+    file.open(fs.vwd(), "PRINT.GCO", O_READ);
+    scanFile.open(fs.vwd(), "PRINT.GCO", O_READ);
+    fs.cacheClear();
+    fs.card.clearStats();
+    static Reader *reader; // large buffers, keep them off the stack
+    reader = new Reader(&file);
+    Result r = {0, 0, 0, 0, 0, 0};
+    uint32_t scanPos = 0, nextScan = scanInterval;
+    uint8_t buf[64];
+    int c;
+    while((c = reader->readByte()) >= 0) {
+        r.checksum = r.checksum * 31 + c;
+        r.bytes++;
+        if(c == '\n')
+            reader->prefetch();
+        if(scan && r.bytes >= nextScan) {
+            nextScan += scanInterval;
+            if(scanPos < file.curPosition()) // buffered bytes are not scanned
+                scanPos = file.curPosition();
+            if(scanPos < fileSize && scanPos - r.bytes <= scanBytes) {
+                uint32_t before = fs.card.reads;
+                if(scanFile.curPosition() != scanPos)
+                    scanFile.seekSet(scanPos);
+                do {
+                    uint16_t size = 512 - (scanPos & 511);
+                    int n = scanFile.read(buf, size < sizeof(buf) ? size : sizeof(buf));
+                    if(n <= 0) break;
+                    scanPos += n;
+                } while((scanPos & 511) != 0 && scanPos < fileSize);
+                r.scanReads += fs.card.reads - before;
+            }
+        }
+    }
+    r.calls = reader->calls;
+    r.reads = fs.card.reads;
+    r.cacheReads = fs.card.cacheReads;
+    delete reader;
+    file.close();
+    scanFile.close();
+    return r;
+}
+
+/** Writes the print file with typical G-code lines. A second file grows at the same time,
+so the clusters of the print file are not contiguous. */
+static uint32_t writeFiles(FatImage &fs) {
+    FatFile print, other;
+    if(!print.open(fs.vwd(), "PRINT.GCO", O_CREAT | O_WRITE | O_TRUNC) || !other.open(fs.vwd(), "OTHER.GCO", O_CREAT | O_WRITE | O_TRUNC))
+        return 0;
+    uint32_t checksum = 0, written = 0, n = 0;
+    char line[96];
+    while(written < fileSize) {
+        int len;
+        if(n % 400 == 0)
+            len = snprintf(line, sizeof(line), ";LAYER:%u\nG1 Z%.2f F600\n", static_cast<unsigned>(n / 400), 0.2 + 0.2 * (n / 400));
+        else if(n % 97 == 0)
+            len = snprintf(line, sizeof(line), "G0 F9000 X%.3f Y%.3f\n", 50 + (n * 7 % 1000) * 0.1, 50 + (n * 13 % 1000) * 0.1);
+        else
+            len = snprintf(line, sizeof(line), "G1 X%.3f Y%.3f E%.5f\n", 50 + (n * 7 % 1000) * 0.1, 50 + (n * 13 % 1000) * 0.1, n * 0.03317);
+        if(written + len > fileSize)
+            len = fileSize - written;
+        print.write(line, len);
+        for(int i = 0; i < len; i++)
+            checksum = checksum * 31 + static_cast<uint8_t>(line[i]);
+        written += len;
+        if(++n % 300 == 0)
+            other.write(line, len);
+    }
+    print.close();
+    other.close();
+    return checksum;
+}
+
+int main() {
+    int failures = 0;
+    static FatImage fs;
+    if(!fs.begin()) {
+        printf("FAIL could not mount the FAT image\n");
+        return 1;
+    }
+    uint32_t checksum = writeFiles(fs);
+    uint32_t blocks = fileSize / 512;
+    printf("FAT32, %u KB clusters, %u KB G-code in %u blocks, tool change scan every %u bytes\n",
+           static_cast<unsigned>(fs.blocksPerCluster() / 2), static_cast<unsigned>(fileSize >> 10), static_cast<unsigned>(blocks),
+           static_cast<unsigned>(scanInterval));
+    printf("%-22s %10s %10s %10s %10s %14s\n", "", "read()", "card", "into", "scan", "bytes copied");
+    printf("%-22s %10s %10s %10s %10s %14s\n", "mode", "calls", "reads", "cache", "reads", "from cache");
+    Result res[3][2];
+    static const char *names[3] = {"byte reads", "SD_READ_BUFFERS 512", "SD_READ_BUFFERS 128"};
+    for(int scan = 0; scan < 2; scan++) {
+        res[0][scan] = printFile<ByteReader>(fs, scan);
+        res[1][scan] = printFile<BufferedReader<512> >(fs, scan);
+        res[2][scan] = printFile<BufferedReader<128> >(fs, scan);
+        for(int m = 0; m < 3; m++) {
+            const Result &r = res[m][scan];
+            uint32_t direct = r.reads - r.cacheReads;
+            char name[40];
+            snprintf(name, sizeof(name), "%s%s", names[m], scan ? ", scan" : "");
+            printf("%-22s %10u %10u %10u %10u %14u\n", name, static_cast<unsigned>(r.calls), static_cast<unsigned>(r.reads),
+                   static_cast<unsigned>(r.cacheReads), static_cast<unsigned>(r.scanReads), static_cast<unsigned>(r.bytes - 512 * direct));
+            if(r.bytes != fileSize || r.checksum != checksum) {
+                printf("FAIL %s does not read the file content\n", name);
+                failures++;
+            }
+        }
+    }
+    // 512 byte buffers take every block of the print once and in one read call, alone
+    // straight from the card, with the scan partly from the blocks the scan left in the cache
+    for(int scan = 0; scan < 2; scan++) {
+        const Result &b = res[1][scan];
+        if(b.calls != blocks || b.reads > blocks + blocks / 32 || (!scan && b.bytes - 512 * (b.reads - b.cacheReads) != 0)) {
+            printf("FAIL SD_READ_BUFFERS 512 reads blocks more than once%s\n", scan ? " with the scan" : "");
+            failures++;
+        }
+    }
+    // buffers never need more card reads than reading byte by byte
+    for(int m = 1; m < 3; m++)
+        for(int scan = 0; scan < 2; scan++)
+            if(res[m][scan].reads > res[0][scan].reads) {
+                printf("FAIL %s needs more card reads than byte reads\n", names[m]);
+                failures++;
+            }
+    if(failures) {
+        printf("sd_read_bench: %d failures\n", failures);
+        return 1;
+    }
+    printf("sd_read_bench: ok\n");
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Compares the FAST_TEMPERATURE_LOOKUP conversion with the table conversion of
+   TemperatureController::convertTemperature for every raw value of every built in
+   sensor table. Shift and sample count default to the firmware defaults. */
+
+#include <math.h>
+#include <stdio.h>
+
+#define ANALOG_REDUCE_BITS 0
+#define FAST_TEMPERATURE_LOOKUP 1
+#ifndef TEMPERATURE_LOOKUP_SHIFT
+#define TEMPERATURE_LOOKUP_SHIFT 6
+#endif
+#ifndef TEMPERATURE_LOOKUP_SAMPLES
+#define TEMPERATURE_LOOKUP_SAMPLES 232
+#endif
+#define ARCH_AVR 1
+#define CPU_ARCH ARCH_AVR
+#define PROGMEM
+
+#include "TemperatureTable.h"
+#include "ThermistorTables.h"
+
+struct BuiltinTable {
+    int type;
+    const short *table;
+    int num;
+};
+
+#define TABLE(n) {n, &temptable_##n[0][0], NUMTEMPS_##n}
+static const BuiltinTable tables[] = {
+    TABLE(1), TABLE(2), TABLE(3), TABLE(4), TABLE(8), TABLE(9), TABLE(10), TABLE(11),
+    TABLE(12), TABLE(13), TABLE(14), TABLE(15), TABLE(16)
+};
+
+int main() {
+    int failures = 0;
+    printf("shift %d, %d samples, %d bytes ram per controller\n", TEMPERATURE_LOOKUP_SHIFT, TEMPERATURE_LOOKUP_SAMPLES,
+           static_cast<int>(sizeof(TemperatureLookup)));
+    printf("%5s %8s %10s %10s %9s %9s\n", "table", "samples", "tolerance", "max error", "searched", "saturated");
+    for(unsigned t = 0; t < sizeof(tables) / sizeof(tables[0]); t++) {
+        SensorTable st;
+        st.table = tables[t].table;
+        st.num = tables[t].num;
+        st.inverted = tables[t].type != 13; // 13 is the PTC table
+        st.ram = false;
+        static TemperatureLookup lookup;
+        if(!lookup.build(st)) {
+            printf("FAIL table %d: does not fit into %d samples\n", tables[t].type, TEMPERATURE_LOOKUP_SAMPLES);
+            failures++;
+            continue;
+        }
+        int used = lookup.first[TEMPERATURE_LOOKUP_CELLS - 1] + (1 << (TEMPERATURE_LOOKUP_SHIFT - lookup.shift[TEMPERATURE_LOOKUP_CELLS - 1])) + 1;
+        // interpolated samples round by 1/32 degC and the integer interpolation truncates by up to 1/16 degC
+        double allowed = (lookup.tolerance + 1.5) / 16.0;
+        double maxError = 0;
+        long searched = 0;
+        int saturated = 0;
+        for(int raw = 0; raw < 4096; raw++) {
+            float tableValue = st.value(raw); // TEMP_INT_TO_FLOAT(tableValue) is the convertTemperature result
+            int16_t fast = lookup.convert(raw);
+            int16_t v = st.inverted ? 4092 - raw : raw;
+            for(int k = 1; k < st.num && st.raw(k - 1) <= v; k++)
+                searched++;
+            if(!(2.0f * tableValue < 32767.0f) || 2.0f * tableValue < -32768.0f) {
+                // table divides by zero or leaves the int16_t range, lookup must report the limit
+                saturated++;
+                if(fast != (2.0f * tableValue < 0 ? -32768 : 32767)) {
+                    printf("FAIL table %d raw %d: table %g degC, lookup %g degC\n", tables[t].type, raw, tableValue / 8.0, fast / 16.0);
+                    failures++;
+                }
+                continue;
+            }
+            double error = fabs(fast / 16.0 - tableValue / 8.0);
+            if(error > maxError)
+                maxError = error;
+            if(error > allowed) {
+                printf("FAIL table %d raw %d: table %g degC, lookup %g degC\n", tables[t].type, raw, tableValue / 8.0, fast / 16.0);
+                failures++;
+            }
+        }
+        printf("%5d %8d %9.3fC %9.3fC %9.1f %9d\n", tables[t].type, used, lookup.tolerance / 16.0, maxError, searched / 4096.0, saturated);
+        if(lookup.tolerance > 4) { // the default sample count keeps all built in tables within 1/4 degC
+            printf("FAIL table %d: tolerance %g degC\n", tables[t].type, lookup.tolerance / 16.0);
+            failures++;
+        }
+    }
+    if(failures) {
+        printf("temperature_test: %d failures\n", failures);
+        return 1;
+    }
+    printf("temperature_test: ok\n");
+    return 0;
+}